@@ -105,7 +105,7 @@ gLinkerOptions = {
   }
 
 
-def getCFLAGS(mode, backend, warn, warnings_as_errors, hostspblas, CC):
+def getCFLAGS(mode, backend, warn, warnings_as_errors, hostspblas, hostomp, zlib, deterministic, CC):
   result = []
   if mode == 'release':
     # turn on optimization
@@ -122,7 +122,7 @@ def getCFLAGS(mode, backend, warn, warnings_as_errors, hostspblas, CC):
     result.append('/bigobj')
 
   # generate omp code
-  if backend == 'omp':
+  if backend == 'omp' or hostomp:
     result.append(gCompilerOptions[CC]['omp'])
 
   if warn:
@@ -137,10 +137,18 @@ def getCFLAGS(mode, backend, warn, warnings_as_errors, hostspblas, CC):
   if hostspblas == 'mkl':
     result.append('-DINTEL_MKL_SPBLAS')
 
+  # read and write gzip compressed files
+  if zlib:
+    result.append('-DCUSP_USE_ZLIB')
+
+  # reductions independent of the number of threads
+  if deterministic:
+    result.append('-DCUSP_DETERMINISTIC_REDUCTIONS')
+
   return result
 
 
-def getCXXFLAGS(mode, backend, warn, warnings_as_errors, hostspblas, CXX):
+def getCXXFLAGS(mode, backend, warn, warnings_as_errors, hostspblas, hostomp, zlib, deterministic, CXX):
   result = []
   if mode == 'release':
     # turn on optimization
@@ -155,7 +163,7 @@ def getCXXFLAGS(mode, backend, warn, warnings_as_errors, hostspblas, CXX):
     result.append('-m32')
 
   # generate omp code
-  if backend == 'omp':
+  if backend == 'omp' or hostomp:
     result.append(gCompilerOptions[CXX]['omp'])
 
   if warn:
@@ -170,6 +178,14 @@ def getCXXFLAGS(mode, backend, warn, warnings_as_errors, hostspblas, CXX):
   if hostspblas == 'mkl':
     result.append('-DINTEL_MKL_SPBLAS')
 
+  # read and write gzip compressed files
+  if zlib:
+    result.append('-DCUSP_USE_ZLIB')
+
+  # reductions independent of the number of threads
+  if deterministic:
+    result.append('-DCUSP_DETERMINISTIC_REDUCTIONS')
+
   return result
 
 
@@ -238,6 +254,15 @@ def Environment():
                                   allowed_values = ('cusp', 'mkl'))
   vars.Add(hostspblas_variable)
 
+  # add a variable to multithread host algorithms with OpenMP
+  vars.Add(BoolVariable('hostomp', 'Multithread host algorithms with OpenMP', 0))
+
+  # add a variable to read and write gzip compressed files with zlib
+  vars.Add(BoolVariable('zlib', 'Read and write gzip compressed files with zlib', 0))
+
+  # add a variable to make host reductions independent of the number of threads
+  vars.Add(BoolVariable('deterministic', 'Bitwise reproducible host reductions for any number of threads', 0))
+
   # create an Environment
   env = OldEnvironment(tools = getTools(), variables = vars)
 
@@ -255,10 +280,10 @@ def Environment():
   env.Append(CXXFLAGS = ['-DTHRUST_DEVICE_SYSTEM=%s' % backend_define])
 
   # get C compiler switches
-  env.Append(CFLAGS = getCFLAGS(env['mode'], env['backend'], env['Wall'], env['Werror'], env['hostspblas'], env.subst('$CC')))
+  env.Append(CFLAGS = getCFLAGS(env['mode'], env['backend'], env['Wall'], env['Werror'], env['hostspblas'], env['hostomp'], env['zlib'], env['deterministic'], env.subst('$CC')))
 
   # get CXX compiler switches
-  env.Append(CXXFLAGS = getCXXFLAGS(env['mode'], env['backend'], env['Wall'], env['Werror'], env['hostspblas'], env.subst('$CXX')))
+  env.Append(CXXFLAGS = getCXXFLAGS(env['mode'], env['backend'], env['Wall'], env['Werror'], env['hostspblas'], env['hostomp'], env['zlib'], env['deterministic'], env.subst('$CXX')))
 
   # get NVCC compiler switches
   env.Append(NVCCFLAGS = getNVCCFLAGS(env['mode'], env['backend'], env['arch']))
@@ -282,7 +307,7 @@ def Environment():
       env.Append(LIBPATH = ['/usr/local/lib'])
     else:
       raise ValueError, "Unknown OS.  What is the Ocelot library path?"
-  elif env['backend'] == 'omp':
+  if env['backend'] == 'omp' or env['hostomp']:
     if os.name == 'posix':
       env.Append(LIBS = ['gomp'])
     elif os.name == 'nt':
@@ -290,6 +315,9 @@ def Environment():
     else:
       raise ValueError, "Unknown OS.  What is the name of the OpenMP library?"
 
+  if env['zlib']:
+    env.Append(LIBS = ['z'])
+
   if env['hostspblas'] == 'mkl':
     intel_lib = 'mkl_intel'
     if platform.machine()[-2:] == '64':
@@ -0,0 +1,283 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file assembler.h
+ *  \brief Assemble sparse matrices from (i,j,v) triplets
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/array1d.h>
+
+#include <cusp/detail/host/detail/assembly.h>
+
+#include <vector>
+
+namespace cusp
+{
+
+/*! \addtogroup sparse_matrices Sparse Matrices
+ */
+
+/*! \addtogroup sparse_matrix_assembly Sparse Matrix Assembly
+ *  \ingroup sparse_matrices
+ *  \{
+ */
+
+/*! \p assembler : Collects (i,j,v) triplets, possibly from several threads
+ * at once, and assembles them into a sparse matrix where duplicate entries
+ * are summed together.
+ *
+ * Triplets are appended to per-thread buffers, so threads of an OpenMP
+ * parallel region may call \p insert concurrently without locking.
+ * \p finalize then builds a CSR matrix with sorted column indices in
+ * parallel, grouping the triplets by blocks of rows instead of sorting them.
+ *
+ * \tparam IndexType Type used for matrix indices (e.g. \c int).
+ * \tparam ValueType Type used for matrix values (e.g. \c float).
+ *
+ * \note The assembler holds its triplets in host memory.  The assembled
+ * matrix may be of any format and memory space.
+ *
+ * \note \p insert(i,j,v) selects the buffer of the calling thread by its
+ * OpenMP thread number, so it must not be called from more threads than
+ * the assembler has buffers nor from nested parallel regions.  Other
+ * threading models should pass an explicit buffer index per thread.
+ *
+ *  The following code snippet demonstrates how to assemble a matrix in
+ *  parallel with \p assembler.
+ *
+ *  \code
+ *  #include <cusp/assembler.h>
+ *  #include <cusp/csr_matrix.h>
+ *  #include <cusp/print.h>
+ *
+ *  int main(void)
+ *  {
+ *      // one buffer per OpenMP thread
+ *      cusp::assembler<int,float> assembler(100, 100);
+ *
+ *      // each thread appends the contributions of its elements
+ *      #pragma omp parallel for
+ *      for (int e = 0; e < 99; e++)
+ *      {
+ *          assembler.insert(e,     e,      1.0f);
+ *          assembler.insert(e,     e + 1, -1.0f);
+ *          assembler.insert(e + 1, e,     -1.0f);
+ *          assembler.insert(e + 1, e + 1,  1.0f);
+ *      }
+ *
+ *      // sum the duplicate entries into a CSR matrix
+ *      cusp::csr_matrix<int,float,cusp::device_memory> A;
+ *      assembler.finalize(A);
+ *
+ *      // print the matrix
+ *      cusp::print(A);
+ *  }
+ *  \endcode
+ */
+template <typename IndexType, typename ValueType>
+class assembler
+{
+    public:
+    typedef IndexType index_type;
+    typedef ValueType value_type;
+
+    /*! Construct an assembler for a \p num_rows by \p num_cols matrix with
+     *  one buffer per OpenMP thread.
+     */
+    assembler(size_t num_rows, size_t num_cols);
+
+    /*! Construct an assembler for a \p num_rows by \p num_cols matrix with
+     *  \p num_buffers buffers.
+     */
+    assembler(size_t num_rows, size_t num_cols, size_t num_buffers);
+
+    size_t num_rows(void) const;
+    size_t num_cols(void) const;
+    size_t num_buffers(void) const;
+
+    /*! Number of triplets inserted since the last \p finalize or \p clear
+     */
+    size_t num_triplets(void) const;
+
+    /*! Preallocate room for \p num_triplets triplets in every buffer
+     */
+    void reserve(size_t num_triplets);
+
+    /*! Append the triplet (i,j,v) to the buffer of the calling thread
+     *
+     * \throws cusp::invalid_input_exception if the thread number is not less
+     * than \p num_buffers
+     */
+    void insert(IndexType i, IndexType j, const ValueType& v);
+
+    /*! Append the triplet (i,j,v) to the given buffer
+     *
+     * \throws cusp::invalid_input_exception if \p buffer is not less than
+     * \p num_buffers
+     */
+    void insert(IndexType i, IndexType j, const ValueType& v, size_t buffer);
+
+    /*! Assemble the inserted triplets into \p A, summing duplicate entries.
+     *  The buffers are emptied and their storage released.
+     *
+     * \throws cusp::invalid_input_exception if a triplet lies outside the matrix
+     */
+    template <typename MatrixType>
+    void finalize(MatrixType& A);
+
+    /*! Discard the inserted triplets, keeping the buffers' storage
+     */
+    void clear(void);
+
+    private:
+    typedef cusp::detail::host::detail::triplet_buffer<IndexType,ValueType> buffer_type;
+
+    size_t num_rows_;
+    size_t num_cols_;
+
+    std::vector<buffer_type> buffers;
+};
+
+/*! \p assembly_map : Precomputed map from (i,j,v) triplets to the entries
+ * of a CSR matrix with a fixed sparsity pattern.
+ *
+ * When a matrix is assembled repeatedly with the same pattern, e.g. at every
+ * step of a time dependent finite element simulation, only the values of
+ * the triplets change.  An \p assembly_map is built once from the row and
+ * column indices of the triplets, in the order in which their values will be
+ * produced, and \p refresh_values then recomputes the values of the matrix
+ * in place without sorting, searching or allocating.
+ *
+ * Entry \c k of the matrix is the sum of the triplet values
+ * <tt>values[triplets[offsets[k]]] ... values[triplets[offsets[k+1]-1]]</tt>,
+ * taken in the order of the triplets.
+ *
+ * \tparam IndexType Type used for matrix and triplet indices (e.g. \c int).
+ *
+ *  \code
+ *  #include <cusp/assembler.h>
+ *  #include <cusp/csr_matrix.h>
+ *
+ *  int main(void)
+ *  {
+ *      // coordinates of the element contributions (2x2 per element)
+ *      int num_elements = 99;
+ *      cusp::array1d<int, cusp::host_memory> I(4 * num_elements);
+ *      cusp::array1d<int, cusp::host_memory> J(4 * num_elements);
+ *
+ *      for (int e = 0; e < num_elements; e++)
+ *      {
+ *          I[4*e+0] = e;   J[4*e+0] = e;
+ *          I[4*e+1] = e;   J[4*e+1] = e+1;
+ *          I[4*e+2] = e+1; J[4*e+2] = e;
+ *          I[4*e+3] = e+1; J[4*e+3] = e+1;
+ *      }
+ *
+ *      // assemble the sparsity pattern once
+ *      cusp::assembler<int, float> assembler(num_elements + 1, num_elements + 1);
+ *      for (size_t n = 0; n < I.size(); n++)
+ *          assembler.insert(I[n], J[n], 0.0f);
+ *
+ *      cusp::csr_matrix<int, float, cusp::host_memory> A;
+ *      assembler.finalize(A);
+ *
+ *      cusp::assembly_map<int> map(A, I, J);
+ *
+ *      cusp::array1d<float, cusp::host_memory> V(4 * num_elements);
+ *
+ *      for (int step = 0; step < 100; step++)
+ *      {
+ *          // compute the element contributions V in parallel
+ *          // ...
+ *
+ *          // sum the contributions into A.values
+ *          cusp::refresh_values(A, map, V);
+ *      }
+ *  }
+ *  \endcode
+ */
+template <typename IndexType>
+class assembly_map
+{
+    public:
+    typedef IndexType index_type;
+
+    /*! first triplet of each entry of the matrix (size num_entries + 1)
+     */
+    cusp::array1d<IndexType,cusp::host_memory> offsets;
+
+    /*! triplets grouped by matrix entry (size num_triplets)
+     */
+    cusp::array1d<IndexType,cusp::host_memory> triplets;
+
+    /*! Construct an empty \p assembly_map.
+     */
+    assembly_map(void) {}
+
+    /*! Construct the \p assembly_map of the triplets with coordinates
+     *  (row_indices[n], column_indices[n]) into the entries of \p A.
+     *
+     * \param A CSR matrix whose pattern contains every triplet
+     * \param row_indices row index of each triplet
+     * \param column_indices column index of each triplet
+     *
+     * \throws cusp::invalid_input_exception if a triplet is not an entry of \p A
+     */
+    template <typename MatrixType, typename Array1, typename Array2>
+    assembly_map(const MatrixType& A, const Array1& row_indices, const Array2& column_indices);
+
+    /*! Number of entries in the matrix
+     */
+    size_t num_entries(void) const { return offsets.empty() ? 0 : offsets.size() - 1; }
+
+    /*! Number of triplets
+     */
+    size_t num_triplets(void) const { return triplets.size(); }
+};
+/*! \}
+ */
+
+/*! \addtogroup algorithms Algorithms
+ *  \ingroup algorithms
+ *  \{
+ */
+
+/*! \p refresh_values : Overwrite the values of a matrix with the sums of
+ * triplet values given by an \p assembly_map.
+ *
+ * Every entry of \p A is set to the sum of its triplets, so entries without
+ * triplets become zero.  The sparsity pattern of \p A is not modified.
+ *
+ * \param A CSR matrix the map was built for
+ * \param map \p assembly_map of the triplets into \p A
+ * \param values value of each triplet, in the order used to build \p map
+ *
+ * \throws cusp::invalid_input_exception if the sizes of \p A or \p values
+ * do not match \p map
+ */
+template <typename MatrixType, typename IndexType, typename Array>
+void refresh_values(MatrixType& A, const assembly_map<IndexType>& map, const Array& values);
+/*! \}
+ */
+
+} // end namespace cusp
+
+#include <cusp/detail/assembler.inl>
+
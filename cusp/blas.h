@@ -37,6 +37,12 @@ namespace blas
 
 /*! \addtogroup blas BLAS
  *  \ingroup algorithms
+ *
+ *  For host arrays \p dot, \p dotc, \p nrm2, \p mdot and \p mdotc add
+ *  partial sums computed in parallel, so the rounding of the result can
+ *  change with the number of OpenMP threads.  Define
+ *  \c CUSP_DETERMINISTIC_REDUCTIONS (deterministic=1 in the SCons build)
+ *  to make these results bitwise identical for any number of threads.
  *  \{
  */
 
@@ -241,6 +247,79 @@ typename Array1::value_type
     dotc(const Array1& x,
          const Array2& y);
 
+/*! \p mdot : dot products of a vector with each column of a
+ * column-major matrix (y = A^T * x)
+ *
+ * All inner products are computed in a single pass over \p x.
+ * \p y may be in a different memory space than \p A and \p x.
+ */
+template <typename Array2d,
+          typename Array1,
+          typename Array2>
+void mdot(const Array2d& A,
+          const Array1& x,
+                Array2& y);
+
+/*! \p mdot : dot products of a vector with each column of a
+ * column-major matrix (y = A^T * x)
+ */
+template <typename Array2d,
+          typename Array1,
+          typename Array2>
+void mdot(const Array2d& A,
+          const Array1& x,
+          const Array2& y);
+
+/*! \p mdotc : conjugate dot products of a vector with each column of a
+ * column-major matrix (y = conjugate(A)^T * x)
+ *
+ * All inner products are computed in a single pass over \p x.
+ * \p y may be in a different memory space than \p A and \p x.
+ */
+template <typename Array2d,
+          typename Array1,
+          typename Array2>
+void mdotc(const Array2d& A,
+           const Array1& x,
+                 Array2& y);
+
+/*! \p mdotc : conjugate dot products of a vector with each column of a
+ * column-major matrix (y = conjugate(A)^T * x)
+ */
+template <typename Array2d,
+          typename Array1,
+          typename Array2>
+void mdotc(const Array2d& A,
+           const Array1& x,
+           const Array2& y);
+
+/*! \p maxpy : scaled addition of a linear combination of the columns of
+ * a column-major matrix (y = alpha * A * x + y)
+ *
+ * The updates of all columns are applied in a single pass over \p y.
+ * \p x may be in a different memory space than \p A and \p y.
+ */
+template <typename Array2d,
+          typename Array1,
+          typename Array2,
+          typename ScalarType>
+void maxpy(const Array2d& A,
+           const Array1& x,
+                 Array2& y,
+           ScalarType alpha);
+
+/*! \p maxpy : scaled addition of a linear combination of the columns of
+ * a column-major matrix (y = alpha * A * x + y)
+ */
+template <typename Array2d,
+          typename Array1,
+          typename Array2,
+          typename ScalarType>
+void maxpy(const Array2d& A,
+           const Array1& x,
+           const Array2& y,
+           ScalarType alpha);
+
 
 template <typename ForwardIterator,
           typename ScalarType>
@@ -39,6 +39,22 @@ namespace cusp
 template <typename SourceType, typename DestinationType>
 void convert(const SourceType& src, DestinationType& dst);
 
+/*! \p convert_inplace : Convert between matrix formats, consuming the source
+ *
+ * The index and value arrays of \p src are moved into \p dst, instead of
+ * copied, wherever the two layouts share them (e.g. the column indices and
+ * values of COO and CSR matrices with the same index, value and memory
+ * space types).  Other conversions fall back to \p convert.  In either case
+ * \p src is left empty and its storage is released.
+ *
+ * \note SourceType must be a container, not a view.
+ * \note DestinationType will be resized as necessary
+ *
+ * \see \p cusp::convert
+ */
+template <typename SourceType, typename DestinationType>
+void convert_inplace(SourceType& src, DestinationType& dst);
+
 /*! \}
  */
 
@@ -0,0 +1,225 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <cusp/convert.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/exception.h>
+#include <cusp/format.h>
+
+#include <cusp/detail/profiler.h>
+#include <cusp/detail/host/parallel.h>
+
+#include <thrust/copy.h>
+
+namespace cusp
+{
+
+template <typename IndexType, typename ValueType>
+assembler<IndexType,ValueType>
+    ::assembler(size_t num_rows, size_t num_cols)
+    : num_rows_(num_rows), num_cols_(num_cols),
+      buffers(cusp::detail::host::max_threads())
+{}
+
+template <typename IndexType, typename ValueType>
+assembler<IndexType,ValueType>
+    ::assembler(size_t num_rows, size_t num_cols, size_t num_buffers)
+    : num_rows_(num_rows), num_cols_(num_cols),
+      buffers(num_buffers)
+{}
+
+template <typename IndexType, typename ValueType>
+size_t assembler<IndexType,ValueType>
+    ::num_rows(void) const
+{
+    return num_rows_;
+}
+
+template <typename IndexType, typename ValueType>
+size_t assembler<IndexType,ValueType>
+    ::num_cols(void) const
+{
+    return num_cols_;
+}
+
+template <typename IndexType, typename ValueType>
+size_t assembler<IndexType,ValueType>
+    ::num_buffers(void) const
+{
+    return buffers.size();
+}
+
+template <typename IndexType, typename ValueType>
+size_t assembler<IndexType,ValueType>
+    ::num_triplets(void) const
+{
+    size_t N = 0;
+
+    for(size_t p = 0; p < buffers.size(); p++)
+        N += buffers[p].values.size();
+
+    return N;
+}
+
+template <typename IndexType, typename ValueType>
+void assembler<IndexType,ValueType>
+    ::reserve(size_t num_triplets)
+{
+    for(size_t p = 0; p < buffers.size(); p++)
+    {
+        buffers[p].row_indices.reserve(num_triplets);
+        buffers[p].column_indices.reserve(num_triplets);
+        buffers[p].values.reserve(num_triplets);
+    }
+}
+
+template <typename IndexType, typename ValueType>
+void assembler<IndexType,ValueType>
+    ::insert(IndexType i, IndexType j, const ValueType& v)
+{
+    insert(i, j, v, cusp::detail::host::thread_num());
+}
+
+template <typename IndexType, typename ValueType>
+void assembler<IndexType,ValueType>
+    ::insert(IndexType i, IndexType j, const ValueType& v, size_t buffer)
+{
+    if(buffer >= buffers.size())
+        throw cusp::invalid_input_exception("assembler buffer index is out of range");
+
+    buffer_type& b = buffers[buffer];
+
+    b.row_indices.push_back(i);
+    b.column_indices.push_back(j);
+    b.values.push_back(v);
+}
+
+template <typename IndexType, typename ValueType>
+template <typename MatrixType>
+void assembler<IndexType,ValueType>
+    ::finalize(MatrixType& A)
+{
+    CUSP_PROFILE_SCOPED();
+
+    cusp::csr_matrix<IndexType,ValueType,cusp::host_memory> B;
+
+    size_t num_entries =
+        cusp::detail::host::detail::assemble_csr(num_rows_, num_cols_, buffers,
+                                                 B.row_offsets, B.column_indices, B.values);
+
+    B.resize(num_rows_, num_cols_, num_entries);
+
+    // release the buffers before the output is converted
+    std::vector<buffer_type>(buffers.size()).swap(buffers);
+
+    cusp::convert_inplace(B, A);
+}
+
+template <typename IndexType, typename ValueType>
+void assembler<IndexType,ValueType>
+    ::clear(void)
+{
+    for(size_t p = 0; p < buffers.size(); p++)
+    {
+        buffers[p].row_indices.clear();
+        buffers[p].column_indices.clear();
+        buffers[p].values.clear();
+    }
+}
+
+namespace detail
+{
+
+template <typename MatrixType, typename Array1, typename Array2, typename Array3, typename Array4>
+void build_assembly_map(const MatrixType& A,
+                        const Array1& row_indices, const Array2& column_indices,
+                              Array3& offsets, Array4& triplets,
+                        cusp::csr_format, cusp::host_memory)
+{
+    cusp::detail::host::detail::csr_assembly_map(A.num_rows, A.num_cols, A.row_offsets, A.column_indices,
+                                                 row_indices, column_indices, offsets, triplets);
+}
+
+template <typename MatrixType, typename Array1, typename Array2, typename Array3, typename Array4>
+void build_assembly_map(const MatrixType& A,
+                        const Array1& row_indices, const Array2& column_indices,
+                              Array3& offsets, Array4& triplets,
+                        cusp::csr_format, cusp::device_memory)
+{
+    typedef typename MatrixType::index_type IndexType;
+
+    // transfer the pattern and the triplet coordinates to the host
+    cusp::array1d<IndexType,cusp::host_memory> A_row_offsets(A.row_offsets);
+    cusp::array1d<IndexType,cusp::host_memory> A_column_indices(A.column_indices);
+    cusp::array1d<IndexType,cusp::host_memory> I(row_indices);
+    cusp::array1d<IndexType,cusp::host_memory> J(column_indices);
+
+    cusp::detail::host::detail::csr_assembly_map(A.num_rows, A.num_cols, A_row_offsets, A_column_indices,
+                                                 I, J, offsets, triplets);
+}
+
+template <typename MatrixType, typename IndexType, typename Array>
+void refresh_values(MatrixType& A, const cusp::assembly_map<IndexType>& map, const Array& values,
+                    cusp::csr_format, cusp::host_memory)
+{
+    cusp::detail::host::detail::refresh_values(map.offsets, map.triplets, values, A.values);
+}
+
+template <typename MatrixType, typename IndexType, typename Array>
+void refresh_values(MatrixType& A, const cusp::assembly_map<IndexType>& map, const Array& values,
+                    cusp::csr_format, cusp::device_memory)
+{
+    typedef typename MatrixType::value_type ValueType;
+
+    // sum on the host and transfer the values of A
+    cusp::array1d<ValueType,cusp::host_memory> triplet_values(values);
+    cusp::array1d<ValueType,cusp::host_memory> A_values(A.num_entries);
+
+    cusp::detail::host::detail::refresh_values(map.offsets, map.triplets, triplet_values, A_values);
+
+    thrust::copy(A_values.begin(), A_values.end(), A.values.begin());
+}
+
+} // end namespace detail
+
+template <typename IndexType>
+template <typename MatrixType, typename Array1, typename Array2>
+assembly_map<IndexType>
+    ::assembly_map(const MatrixType& A, const Array1& row_indices, const Array2& column_indices)
+{
+    CUSP_PROFILE_SCOPED();
+
+    if (row_indices.size() != column_indices.size())
+        throw cusp::invalid_input_exception("array dimensions do not match");
+
+    cusp::detail::build_assembly_map(A, row_indices, column_indices, offsets, triplets,
+                                     typename MatrixType::format(), typename MatrixType::memory_space());
+}
+
+template <typename MatrixType, typename IndexType, typename Array>
+void refresh_values(MatrixType& A, const assembly_map<IndexType>& map, const Array& values)
+{
+    CUSP_PROFILE_SCOPED();
+
+    if (A.num_entries != map.num_entries() || values.size() != map.num_triplets())
+        throw cusp::invalid_input_exception("array dimensions do not match");
+
+    cusp::detail::refresh_values(A, map, values,
+                                 typename MatrixType::format(), typename MatrixType::memory_space());
+}
+
+} // end namespace cusp
+
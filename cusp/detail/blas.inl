@@ -16,9 +16,12 @@
 
 
 #include <cusp/array1d.h>
+#include <cusp/array2d.h>
 
 #include <cusp/exception.h>
 
+#include <cusp/detail/host/blas.h>
+
 #include <thrust/copy.h>
 #include <thrust/fill.h>
 #include <thrust/functional.h>
@@ -388,6 +391,294 @@ namespace detail
                      last,
                      detail::SCAL<ScalarType>(alpha));
   }
+
+  // The array versions dispatch on the memory spaces of the arrays: host
+  // arrays use the multithreaded kernels in cusp/detail/host/blas.h and all
+  // other arrays use the thrust implementations above.
+  template <typename Array1,
+	    typename Array2,
+	    typename ScalarType,
+	    typename MemorySpace1,
+	    typename MemorySpace2>
+  void axpy(const Array1& x,
+	    Array2& y,
+	    ScalarType alpha,
+	    MemorySpace1,
+	    MemorySpace2)
+  {
+    cusp::blas::detail::axpy(x.begin(), x.end(), y.begin(), alpha);
+  }
+
+  template <typename Array1,
+	    typename Array2,
+	    typename ScalarType>
+  void axpy(const Array1& x,
+	    Array2& y,
+	    ScalarType alpha,
+	    cusp::host_memory,
+	    cusp::host_memory)
+  {
+    cusp::detail::host::axpy(x.begin(), y.begin(), x.size(), alpha);
+  }
+
+  template <typename Array1,
+	    typename Array2,
+	    typename Array3,
+	    typename ScalarType1,
+	    typename ScalarType2,
+	    typename MemorySpace1,
+	    typename MemorySpace2,
+	    typename MemorySpace3>
+  void axpby(const Array1& x,
+	     const Array2& y,
+	     Array3& z,
+	     ScalarType1 alpha,
+	     ScalarType2 beta,
+	     MemorySpace1,
+	     MemorySpace2,
+	     MemorySpace3)
+  {
+    cusp::blas::detail::axpby(x.begin(), x.end(), y.begin(), z.begin(), alpha, beta);
+  }
+
+  template <typename Array1,
+	    typename Array2,
+	    typename Array3,
+	    typename ScalarType1,
+	    typename ScalarType2>
+  void axpby(const Array1& x,
+	     const Array2& y,
+	     Array3& z,
+	     ScalarType1 alpha,
+	     ScalarType2 beta,
+	     cusp::host_memory,
+	     cusp::host_memory,
+	     cusp::host_memory)
+  {
+    cusp::detail::host::axpby(x.begin(), y.begin(), z.begin(), x.size(), alpha, beta);
+  }
+
+  template <typename Array1,
+	    typename Array2,
+	    typename Array3,
+	    typename Array4,
+	    typename ScalarType1,
+	    typename ScalarType2,
+	    typename ScalarType3,
+	    typename MemorySpace1,
+	    typename MemorySpace2,
+	    typename MemorySpace3,
+	    typename MemorySpace4>
+  void axpbypcz(const Array1& x,
+		const Array2& y,
+		const Array3& z,
+		Array4& output,
+		ScalarType1 alpha,
+		ScalarType2 beta,
+		ScalarType3 gamma,
+		MemorySpace1,
+		MemorySpace2,
+		MemorySpace3,
+		MemorySpace4)
+  {
+    cusp::blas::detail::axpbypcz(x.begin(), x.end(), y.begin(), z.begin(), output.begin(), alpha, beta, gamma);
+  }
+
+  template <typename Array1,
+	    typename Array2,
+	    typename Array3,
+	    typename Array4,
+	    typename ScalarType1,
+	    typename ScalarType2,
+	    typename ScalarType3>
+  void axpbypcz(const Array1& x,
+		const Array2& y,
+		const Array3& z,
+		Array4& output,
+		ScalarType1 alpha,
+		ScalarType2 beta,
+		ScalarType3 gamma,
+		cusp::host_memory,
+		cusp::host_memory,
+		cusp::host_memory,
+		cusp::host_memory)
+  {
+    cusp::detail::host::axpbypcz(x.begin(), y.begin(), z.begin(), output.begin(), x.size(), alpha, beta, gamma);
+  }
+
+  template <typename Array1,
+	    typename Array2,
+	    typename MemorySpace1,
+	    typename MemorySpace2>
+  typename Array1::value_type
+  dot(const Array1& x,
+      const Array2& y,
+      MemorySpace1,
+      MemorySpace2)
+  {
+    return cusp::blas::detail::dot(x.begin(), x.end(), y.begin());
+  }
+
+  template <typename Array1,
+	    typename Array2>
+  typename Array1::value_type
+  dot(const Array1& x,
+      const Array2& y,
+      cusp::host_memory,
+      cusp::host_memory)
+  {
+    return cusp::detail::host::dot<typename Array1::value_type>(x.begin(), y.begin(), x.size());
+  }
+
+  template <typename Array1,
+	    typename Array2,
+	    typename MemorySpace1,
+	    typename MemorySpace2>
+  typename Array1::value_type
+  dotc(const Array1& x,
+       const Array2& y,
+       MemorySpace1,
+       MemorySpace2)
+  {
+    return cusp::blas::detail::dotc(x.begin(), x.end(), y.begin());
+  }
+
+  template <typename Array1,
+	    typename Array2>
+  typename Array1::value_type
+  dotc(const Array1& x,
+       const Array2& y,
+       cusp::host_memory,
+       cusp::host_memory)
+  {
+    return cusp::detail::host::dotc<typename Array1::value_type>(x.begin(), y.begin(), x.size());
+  }
+
+  template <typename Array,
+	    typename MemorySpace>
+  typename norm_type<typename Array::value_type>::type
+  nrm2(const Array& x,
+       MemorySpace)
+  {
+    return cusp::blas::detail::nrm2(x.begin(), x.end());
+  }
+
+  template <typename Array>
+  typename norm_type<typename Array::value_type>::type
+  nrm2(const Array& x,
+       cusp::host_memory)
+  {
+    typedef typename norm_type<typename Array::value_type>::type NormType;
+
+    return std::sqrt(cusp::detail::host::nrm2_squared<NormType>(x.begin(), x.size()));
+  }
+
+  template <typename Array,
+	    typename ScalarType,
+	    typename MemorySpace>
+  void scal(Array& x,
+	    ScalarType alpha,
+	    MemorySpace)
+  {
+    cusp::blas::detail::scal(x.begin(), x.end(), alpha);
+  }
+
+  template <typename Array,
+	    typename ScalarType>
+  void scal(Array& x,
+	    ScalarType alpha,
+	    cusp::host_memory)
+  {
+    cusp::detail::host::scal(x.begin(), x.size(), alpha);
+  }
+
+  template <typename Array2d,
+	    typename Array1,
+	    typename Array2>
+  void assert_column_dimensions(const Array2d& A,
+				const Array1& x,
+				const Array2& y)
+  {
+    if(A.num_rows != x.size() || A.num_cols != y.size())
+      throw cusp::invalid_input_exception("array dimensions do not match");
+  }
+
+  template <bool Conjugate,
+	    typename Array2d,
+	    typename Array1,
+	    typename Array2,
+	    typename MemorySpace1,
+	    typename MemorySpace2>
+  void mdot(const Array2d& A,
+	    const Array1& x,
+	    Array2& y,
+	    cusp::column_major,
+	    MemorySpace1,
+	    MemorySpace2)
+  {
+    for(size_t j = 0; j < A.num_cols; j++)
+    {
+      if(Conjugate)
+	y[j] = cusp::blas::dotc(cusp::make_array1d_view(A.values.begin() + A.pitch * j,
+							A.values.begin() + A.pitch * j + A.num_rows), x);
+      else
+	y[j] = cusp::blas::dot(cusp::make_array1d_view(A.values.begin() + A.pitch * j,
+						       A.values.begin() + A.pitch * j + A.num_rows), x);
+    }
+  }
+
+  template <bool Conjugate,
+	    typename Array2d,
+	    typename Array1,
+	    typename Array2>
+  void mdot(const Array2d& A,
+	    const Array1& x,
+	    Array2& y,
+	    cusp::column_major,
+	    cusp::host_memory,
+	    cusp::host_memory)
+  {
+    cusp::detail::host::mdot<Conjugate,typename Array2d::value_type>
+      (A.values.begin(), A.pitch, x.begin(), y.begin(), A.num_rows, A.num_cols);
+  }
+
+  template <typename Array2d,
+	    typename Array1,
+	    typename Array2,
+	    typename ScalarType,
+	    typename MemorySpace1,
+	    typename MemorySpace2>
+  void maxpy(const Array2d& A,
+	     const Array1& x,
+	     Array2& y,
+	     ScalarType alpha,
+	     cusp::column_major,
+	     MemorySpace1,
+	     MemorySpace2)
+  {
+    typedef typename Array2d::value_type ValueType;
+
+    for(size_t j = 0; j < A.num_cols; j++)
+      cusp::blas::axpy(cusp::make_array1d_view(A.values.begin() + A.pitch * j,
+					       A.values.begin() + A.pitch * j + A.num_rows),
+		       y, alpha * ValueType(x[j]));
+  }
+
+  template <typename Array2d,
+	    typename Array1,
+	    typename Array2,
+	    typename ScalarType>
+  void maxpy(const Array2d& A,
+	     const Array1& x,
+	     Array2& y,
+	     ScalarType alpha,
+	     cusp::column_major,
+	     cusp::host_memory,
+	     cusp::host_memory)
+  {
+    cusp::detail::host::maxpy<typename Array2d::value_type>
+      (A.values.begin(), A.pitch, x.begin(), y.begin(), A.num_rows, A.num_cols, alpha);
+  }
 } // end namespace detail
 
 
@@ -411,7 +702,9 @@ void axpy(const Array1& x,
 {
     CUSP_PROFILE_SCOPED();
     detail::assert_same_dimensions(x, y);
-    cusp::blas::detail::axpy(x.begin(), x.end(), y.begin(), alpha);
+    cusp::blas::detail::axpy(x, y, alpha,
+                             typename Array1::memory_space(),
+                             typename Array2::memory_space());
 }
 
 template <typename Array1,
@@ -423,7 +716,9 @@ void axpy(const Array1& x,
 {
     CUSP_PROFILE_SCOPED();
     detail::assert_same_dimensions(x, y);
-    cusp::blas::detail::axpy(x.begin(), x.end(), y.begin(), alpha);
+    cusp::blas::detail::axpy(x, y, alpha,
+                             typename Array1::memory_space(),
+                             typename Array2::memory_space());
 }
 
 
@@ -454,7 +749,10 @@ void axpby(const Array1& x,
 {
     CUSP_PROFILE_SCOPED();
     detail::assert_same_dimensions(x, y, z);
-    cusp::blas::detail::axpby(x.begin(), x.end(), y.begin(), z.begin(), alpha, beta);
+    cusp::blas::detail::axpby(x, y, z, alpha, beta,
+                              typename Array1::memory_space(),
+                              typename Array2::memory_space(),
+                              typename Array3::memory_space());
 }
 
 template <typename Array1,
@@ -470,7 +768,10 @@ void axpby(const Array1& x,
 {
     CUSP_PROFILE_SCOPED();
     detail::assert_same_dimensions(x, y, z);
-    cusp::blas::detail::axpby(x.begin(), x.end(), y.begin(), z.begin(), alpha, beta);
+    cusp::blas::detail::axpby(x, y, z, alpha, beta,
+                              typename Array1::memory_space(),
+                              typename Array2::memory_space(),
+                              typename Array3::memory_space());
 }
 
 template <typename InputIterator1,
@@ -508,7 +809,11 @@ void axpbypcz(const Array1& x,
 {
     CUSP_PROFILE_SCOPED();
     detail::assert_same_dimensions(x, y, z, output);
-    cusp::blas::detail::axpbypcz(x.begin(), x.end(), y.begin(), z.begin(), output.begin(), alpha, beta, gamma);
+    cusp::blas::detail::axpbypcz(x, y, z, output, alpha, beta, gamma,
+                                 typename Array1::memory_space(),
+                                 typename Array2::memory_space(),
+                                 typename Array3::memory_space(),
+                                 typename Array4::memory_space());
 }
 
 template <typename Array1,
@@ -528,7 +833,11 @@ void axpbypcz(const Array1& x,
 {
     CUSP_PROFILE_SCOPED();
     detail::assert_same_dimensions(x, y, z, output);
-    cusp::blas::detail::axpbypcz(x.begin(), x.end(), y.begin(), z.begin(), output.begin(), alpha, beta, gamma);
+    cusp::blas::detail::axpbypcz(x, y, z, output, alpha, beta, gamma,
+                                 typename Array1::memory_space(),
+                                 typename Array2::memory_space(),
+                                 typename Array3::memory_space(),
+                                 typename Array4::memory_space());
 }
     
 
@@ -619,7 +928,9 @@ typename Array1::value_type
 {
     CUSP_PROFILE_SCOPED();
     detail::assert_same_dimensions(x, y);
-    return cusp::blas::detail::dot(x.begin(), x.end(), y.begin());
+    return cusp::blas::detail::dot(x, y,
+                                   typename Array1::memory_space(),
+                                   typename Array2::memory_space());
 }
 
 // TODO properly harmonize heterogenous types
@@ -646,7 +957,107 @@ typename Array1::value_type
 {
     CUSP_PROFILE_SCOPED();
     detail::assert_same_dimensions(x, y);
-    return cusp::blas::detail::dotc(x.begin(), x.end(), y.begin());
+    return cusp::blas::detail::dotc(x, y,
+                                    typename Array1::memory_space(),
+                                    typename Array2::memory_space());
+}
+
+// The product of the columns of A with x is computed where A and x live;
+// y only receives the results.
+template <typename Array2d,
+          typename Array1,
+          typename Array2>
+void mdot(const Array2d& A,
+          const Array1& x,
+                Array2& y)
+{
+    CUSP_PROFILE_SCOPED();
+    detail::assert_column_dimensions(A, x, y);
+    cusp::blas::detail::mdot<false>(A, x, y,
+                                    typename Array2d::orientation(),
+                                    typename Array2d::memory_space(),
+                                    typename Array1::memory_space());
+}
+
+template <typename Array2d,
+          typename Array1,
+          typename Array2>
+void mdot(const Array2d& A,
+          const Array1& x,
+          const Array2& y)
+{
+    CUSP_PROFILE_SCOPED();
+    detail::assert_column_dimensions(A, x, y);
+    cusp::blas::detail::mdot<false>(A, x, y,
+                                    typename Array2d::orientation(),
+                                    typename Array2d::memory_space(),
+                                    typename Array1::memory_space());
+}
+
+template <typename Array2d,
+          typename Array1,
+          typename Array2>
+void mdotc(const Array2d& A,
+           const Array1& x,
+                 Array2& y)
+{
+    CUSP_PROFILE_SCOPED();
+    detail::assert_column_dimensions(A, x, y);
+    cusp::blas::detail::mdot<true>(A, x, y,
+                                   typename Array2d::orientation(),
+                                   typename Array2d::memory_space(),
+                                   typename Array1::memory_space());
+}
+
+template <typename Array2d,
+          typename Array1,
+          typename Array2>
+void mdotc(const Array2d& A,
+           const Array1& x,
+           const Array2& y)
+{
+    CUSP_PROFILE_SCOPED();
+    detail::assert_column_dimensions(A, x, y);
+    cusp::blas::detail::mdot<true>(A, x, y,
+                                   typename Array2d::orientation(),
+                                   typename Array2d::memory_space(),
+                                   typename Array1::memory_space());
+}
+
+// The coefficients x are read one at a time, so only A and y decide
+// where the update is computed.
+template <typename Array2d,
+          typename Array1,
+          typename Array2,
+          typename ScalarType>
+void maxpy(const Array2d& A,
+           const Array1& x,
+                 Array2& y,
+           ScalarType alpha)
+{
+    CUSP_PROFILE_SCOPED();
+    detail::assert_column_dimensions(A, y, x);
+    cusp::blas::detail::maxpy(A, x, y, alpha,
+                              typename Array2d::orientation(),
+                              typename Array2d::memory_space(),
+                              typename Array2::memory_space());
+}
+
+template <typename Array2d,
+          typename Array1,
+          typename Array2,
+          typename ScalarType>
+void maxpy(const Array2d& A,
+           const Array1& x,
+           const Array2& y,
+           ScalarType alpha)
+{
+    CUSP_PROFILE_SCOPED();
+    detail::assert_column_dimensions(A, y, x);
+    cusp::blas::detail::maxpy(A, x, y, alpha,
+                              typename Array2d::orientation(),
+                              typename Array2d::memory_space(),
+                              typename Array2::memory_space());
 }
 
 
@@ -723,7 +1134,7 @@ typename norm_type<typename Array::value_type>::type
     nrm2(const Array& x)
 {
     CUSP_PROFILE_SCOPED();
-    return cusp::blas::detail::nrm2(x.begin(), x.end());
+    return cusp::blas::detail::nrm2(x, typename Array::memory_space());
 }
 
 
@@ -767,7 +1178,7 @@ void scal(Array& x,
           ScalarType alpha)
 {
     CUSP_PROFILE_SCOPED();
-    cusp::blas::detail::scal(x.begin(), x.end(), alpha);
+    cusp::blas::detail::scal(x, alpha, typename Array::memory_space());
 }
 
 template <typename Array,
@@ -776,7 +1187,7 @@ void scal(const Array& x,
           ScalarType alpha)
 {
     CUSP_PROFILE_SCOPED();
-    cusp::blas::detail::scal(x.begin(), x.end(), alpha);
+    cusp::blas::detail::scal(x, alpha, typename Array::memory_space());
 }
 
 } // end namespace blas
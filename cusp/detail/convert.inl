@@ -17,6 +17,10 @@
 #include <cusp/detail/dispatch/convert.h>
 
 #include <cusp/copy.h>
+#include <cusp/coo_matrix.h>
+#include <cusp/csr_matrix.h>
+
+#include <cusp/detail/format_utils.h>
 
 namespace cusp
 {
@@ -43,6 +47,68 @@ void convert(const SourceType& src, DestinationType& dst,
       typename DestinationType::memory_space());
 }
 
+// release the storage held by a container
+template <typename MatrixType>
+void release(MatrixType& A)
+{
+  MatrixType empty;
+  A.swap(empty);
+}
+
+// same type
+template <typename MatrixType>
+void convert_inplace(MatrixType& src, MatrixType& dst)
+{
+  dst.swap(src);
+  release(src);
+}
+
+// COO -> CSR (column indices and values are moved)
+template <typename IndexType, typename ValueType, typename MemorySpace>
+void convert_inplace(cusp::coo_matrix<IndexType,ValueType,MemorySpace>& src,
+                     cusp::csr_matrix<IndexType,ValueType,MemorySpace>& dst)
+{
+  // rows must be contiguous for the entries to stay in place
+  if (!src.is_sorted_by_row())
+  {
+    cusp::convert(src, dst);
+    release(src);
+    return;
+  }
+
+  dst.row_offsets.resize(src.num_rows + 1);
+  cusp::detail::indices_to_offsets(src.row_indices, dst.row_offsets);
+
+  dst.column_indices.swap(src.column_indices);
+  dst.values.swap(src.values);
+  dst.resize(src.num_rows, src.num_cols, src.num_entries);
+
+  release(src);
+}
+
+// CSR -> COO (column indices and values are moved)
+template <typename IndexType, typename ValueType, typename MemorySpace>
+void convert_inplace(cusp::csr_matrix<IndexType,ValueType,MemorySpace>& src,
+                     cusp::coo_matrix<IndexType,ValueType,MemorySpace>& dst)
+{
+  dst.row_indices.resize(src.num_entries);
+  cusp::detail::offsets_to_indices(src.row_offsets, dst.row_indices);
+
+  dst.column_indices.swap(src.column_indices);
+  dst.values.swap(src.values);
+  dst.resize(src.num_rows, src.num_cols, src.num_entries);
+
+  release(src);
+}
+
+// all other conversions
+template <typename SourceType, typename DestinationType>
+void convert_inplace(SourceType& src, DestinationType& dst)
+{
+  cusp::convert(src, dst);
+  release(src);
+}
+
 } // end namespace detail
 
 /////////////////
@@ -58,5 +124,12 @@ void convert(const SourceType& src, DestinationType& dst)
       typename DestinationType::format());
 }
 
-} // end namespace cusp
+template <typename SourceType, typename DestinationType>
+void convert_inplace(SourceType& src, DestinationType& dst)
+{
+  CUSP_PROFILE_SCOPED();
 
+  cusp::detail::convert_inplace(src, dst);
+}
+
+} // end namespace cusp
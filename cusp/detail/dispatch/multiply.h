@@ -15,6 +15,9 @@
  */
     
 #include <cusp/array1d.h>
+#include <cusp/copy.h>
+
+#include <thrust/copy.h>
 
 #include <cusp/detail/host/multiply.h>
 #include <cusp/detail/device/multiply.h>
@@ -58,6 +61,186 @@ void multiply(const LinearOperator&  A,
     cusp::detail::device::multiply(A, B, C);
 }
 
+/////////////////////////////////////
+// Symbolic and Numeric Host Paths //
+/////////////////////////////////////
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3>
+void multiply_symbolic(const Matrix1& A,
+                       const Matrix2& B,
+                             Matrix3& C,
+                       cusp::host_memory,
+                       cusp::host_memory,
+                       cusp::host_memory)
+{
+    cusp::detail::host::multiply_symbolic(A, B, C);
+}
+
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3>
+void multiply_numeric(const Matrix1& A,
+                      const Matrix2& B,
+                            Matrix3& C,
+                      cusp::host_memory,
+                      cusp::host_memory,
+                      cusp::host_memory)
+{
+    cusp::detail::host::multiply_numeric(A, B, C);
+}
+
+///////////////////////////////////////
+// Symbolic and Numeric Device Paths //
+///////////////////////////////////////
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3>
+void multiply_symbolic(const Matrix1& A,
+                       const Matrix2& B,
+                             Matrix3& C,
+                       cusp::device_memory,
+                       cusp::device_memory,
+                       cusp::device_memory)
+{
+    // TODO do this natively on the device
+
+    // transfer to host, multiply on host, and transfer back to device
+    typename Matrix1::container::template rebind<cusp::host_memory>::type A_(A);
+    typename Matrix2::container::template rebind<cusp::host_memory>::type B_(B);
+    typename Matrix3::container::template rebind<cusp::host_memory>::type C_;
+
+    cusp::detail::host::multiply_symbolic(A_, B_, C_);
+
+    cusp::copy(C_, C);
+}
+
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3>
+void multiply_numeric(const Matrix1& A,
+                      const Matrix2& B,
+                            Matrix3& C,
+                      cusp::device_memory,
+                      cusp::device_memory,
+                      cusp::device_memory)
+{
+    // TODO do this natively on the device
+
+    // transfer to host, multiply on host, and transfer values back to device
+    typename Matrix1::container::template rebind<cusp::host_memory>::type A_(A);
+    typename Matrix2::container::template rebind<cusp::host_memory>::type B_(B);
+    typename Matrix3::container::template rebind<cusp::host_memory>::type C_(C);
+
+    cusp::detail::host::multiply_numeric(A_, B_, C_);
+
+    thrust::copy(C_.values.begin(), C_.values.end(), C.values.begin());
+}
+
+//////////////////////////
+// Masked Product Paths //
+//////////////////////////
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3,
+          typename Matrix4>
+void multiply_masked(const Matrix1& A,
+                     const Matrix2& B,
+                     const Matrix3& M,
+                           Matrix4& C,
+                     cusp::host_memory)
+{
+    cusp::detail::host::multiply_masked(A, B, M, C);
+}
+
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3,
+          typename Matrix4>
+void multiply_masked(const Matrix1& A,
+                     const Matrix2& B,
+                     const Matrix3& M,
+                           Matrix4& C,
+                     cusp::device_memory)
+{
+    // TODO do this natively on the device
+
+    // transfer to host, multiply on host, and transfer back to device
+    typename Matrix1::container::template rebind<cusp::host_memory>::type A_(A);
+    typename Matrix2::container::template rebind<cusp::host_memory>::type B_(B);
+    typename Matrix3::container::template rebind<cusp::host_memory>::type M_(M);
+    typename Matrix4::container::template rebind<cusp::host_memory>::type C_;
+
+    cusp::detail::host::multiply_masked(A_, B_, M_, C_);
+
+    cusp::copy(C_, C);
+}
+
+///////////////////////////
+// Galerkin Product Paths //
+///////////////////////////
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3,
+          typename Matrix4>
+void galerkin_product(const Matrix1& R,
+                      const Matrix2& A,
+                      const Matrix3& P,
+                            Matrix4& RAP,
+                      cusp::host_memory)
+{
+    cusp::detail::host::galerkin_product(R, A, P, RAP);
+}
+
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3,
+          typename Matrix4>
+void galerkin_product(const Matrix1& R,
+                      const Matrix2& A,
+                      const Matrix3& P,
+                            Matrix4& RAP,
+                      cusp::device_memory)
+{
+    // TODO implement a fused kernel on the device
+    typename Matrix4::container AP;
+    cusp::detail::device::multiply(A, P, AP);
+    cusp::detail::device::multiply(R, AP, RAP);
+}
+
+///////////////////////////
+// Blocked Product Paths //
+///////////////////////////
+template <typename Matrix1,
+          typename Matrix2,
+          typename BlockFunction>
+void multiply_blocked(const Matrix1& A,
+                      const Matrix2& B,
+                            BlockFunction f,
+                      const size_t max_bytes,
+                      cusp::host_memory,
+                      cusp::host_memory)
+{
+    cusp::detail::host::multiply_blocked(A, B, f, max_bytes);
+}
+
+template <typename Matrix1,
+          typename Matrix2,
+          typename BlockFunction>
+void multiply_blocked(const Matrix1& A,
+                      const Matrix2& B,
+                            BlockFunction f,
+                      const size_t max_bytes,
+                      cusp::device_memory,
+                      cusp::device_memory)
+{
+    // blocks of C are delivered in host memory
+    cusp::csr_matrix<typename Matrix1::index_type,typename Matrix1::value_type,cusp::host_memory> A_(A);
+    cusp::csr_matrix<typename Matrix2::index_type,typename Matrix2::value_type,cusp::host_memory> B_(B);
+
+    cusp::detail::host::multiply_blocked(A_, B_, f, max_bytes);
+}
+
 } // end namespace dispatch
 } // end namespace detail
 } // end namespace cusp
@@ -18,6 +18,8 @@
 #include <cusp/format.h>
 #include <cusp/array1d.h>
 
+#include <cusp/detail/host/sort.h>
+
 #include <thrust/fill.h>
 #include <thrust/extrema.h>
 #include <thrust/binary_search.h>
@@ -260,10 +262,8 @@ void sort_by_row(Array1& rows, Array2& columns, Array3& values)
 }
 
 template <typename Array1, typename Array2, typename Array3>
-void sort_by_row_and_column(Array1& rows, Array2& columns, Array3& values)
+void stable_sort_by_row_and_column(Array1& rows, Array2& columns, Array3& values)
 {
-    CUSP_PROFILE_SCOPED();
-
     typedef typename Array1::value_type IndexType;
     typedef typename Array3::value_type ValueType;
     typedef typename Array1::memory_space MemorySpace;
@@ -293,6 +293,28 @@ void sort_by_row_and_column(Array1& rows, Array2& columns, Array3& values)
     }
 }
 
+template <typename Array1, typename Array2, typename Array3, typename MemorySpace>
+void sort_by_row_and_column(Array1& rows, Array2& columns, Array3& values, MemorySpace)
+{
+    stable_sort_by_row_and_column(rows, columns, values);
+}
+
+template <typename Array1, typename Array2, typename Array3>
+void sort_by_row_and_column(Array1& rows, Array2& columns, Array3& values, cusp::host_memory)
+{
+    // radix sort on packed (row, column) keys when the indices fit in 64 bits
+    if (!cusp::detail::host::radix_sort_by_row_and_column(rows, columns, values))
+        stable_sort_by_row_and_column(rows, columns, values);
+}
+
+template <typename Array1, typename Array2, typename Array3>
+void sort_by_row_and_column(Array1& rows, Array2& columns, Array3& values)
+{
+    CUSP_PROFILE_SCOPED();
+
+    sort_by_row_and_column(rows, columns, values, typename Array1::memory_space());
+}
+
 } // end namespace detail
 } // end namespace cusp
 
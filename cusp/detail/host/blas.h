@@ -0,0 +1,395 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file blas.h
+ *  \brief Multithreaded BLAS-1 kernels for host arrays
+ */
+
+#pragma once
+
+#include <cusp/complex.h>
+
+#include <cusp/detail/host/parallel.h>
+
+#include <algorithm>
+#include <vector>
+
+// The vector is divided into contiguous blocks with partition_begin, like
+// the other host kernels, so each thread works on the same part of every
+// vector across the iterations of a solver.  Within a block, the loops are
+// written so the compiler can vectorize them: elementwise kernels index
+// plain arrays and reductions keep several independent partial sums.
+
+namespace cusp
+{
+namespace detail
+{
+namespace host
+{
+
+// BLAS-1 kernels are limited by memory bandwidth, so a thread is only
+// worth starting for a fairly large block
+const size_t blas_grain_size = 1 << 15;
+
+// conjugate and squared magnitude of real and complex values
+template <typename T>
+T blas_conjugate(const T& x) { return x; }
+
+template <typename T>
+cusp::complex<T> blas_conjugate(const cusp::complex<T>& x) { return cusp::conj(x); }
+
+template <typename T>
+T blas_abs_squared(const T& x) { return x * x; }
+
+template <typename T>
+T blas_abs_squared(const cusp::complex<T>& x) { return x.real() * x.real() + x.imag() * x.imag(); }
+
+// Run kernel(begin, end) on the static partition of [0,n) of each thread
+template <typename Kernel>
+void blas_for(const size_t n, const Kernel& kernel)
+{
+    #pragma omp parallel num_threads(num_threads(n, blas_grain_size))
+    {
+        kernel(partition_begin(n, thread_num(),     team_size()),
+               partition_begin(n, thread_num() + 1, team_size()));
+    }
+}
+
+// Reductions split [0,n) into parts and add the partial results of the
+// parts in a balanced tree.  Normally each thread reduces one part, its
+// static partition, so the rounding of the result depends on the number
+// of threads.  When CUSP_DETERMINISTIC_REDUCTIONS is defined the parts are
+// fixed blocks of blas_reduction_block_size elements, which the threads
+// divide among themselves, and the result is bitwise identical for any
+// number of threads (with or without OpenMP).
+//
+// The deterministic mode adds one partial result per block (n / 8192) to
+// the final tree and may give a thread one block more than another, which
+// costs the most on vectors that fit in the cache.  Time of dot of two
+// float vectors on one thread in microseconds, default / deterministic,
+// best of 7 runs:
+//
+//        16K            100K         1M (both)    16M (both)
+//   4.0-4.7 / 5.8-6.8   22-25 / 31-37    420-440      10.8-13.4 ms
+//
+// For 1M and 16M elements the two modes are within the run to run
+// variation; in the cache the deterministic mode is 25-50% slower.  The
+// cost with several threads has not been measured.
+const size_t blas_reduction_block_size = 1 << 13;
+
+inline size_t blas_num_parts(const size_t n, const size_t num_threads)
+{
+#if defined(CUSP_DETERMINISTIC_REDUCTIONS)
+    return std::max<size_t>(1, (n + blas_reduction_block_size - 1) / blas_reduction_block_size);
+#else
+    return num_threads;
+#endif
+}
+
+inline size_t blas_part_begin(const size_t n, const size_t part, const size_t num_parts)
+{
+#if defined(CUSP_DETERMINISTIC_REDUCTIONS)
+    return std::min(n, part * blas_reduction_block_size);
+#else
+    return partition_begin(n, part, num_parts);
+#endif
+}
+
+// Add the partial results of num_parts parts, each holding width values,
+// in a balanced tree.  The sums are left in the first part.
+template <typename ValueType>
+void blas_combine(std::vector<ValueType>& partials, const size_t num_parts, const size_t width)
+{
+    for (size_t stride = 1; stride < num_parts; stride *= 2)
+        for (size_t p = 0; p + stride < num_parts; p += 2 * stride)
+            for (size_t j = 0; j < width; j++)
+                partials[p * width + j] += partials[(p + stride) * width + j];
+}
+
+// Sum of kernel(begin, end) over the parts of [0,n)
+template <typename Kernel>
+typename Kernel::result_type blas_reduce(const size_t n, const Kernel& kernel)
+{
+    typedef typename Kernel::result_type ResultType;
+
+    const size_t T = num_threads(n, blas_grain_size);
+    const size_t P = blas_num_parts(n, T);
+
+    std::vector<ResultType> partials(P, ResultType(0));
+
+    #pragma omp parallel num_threads(T)
+    {
+        const long first = partition_begin(P, thread_num(),     team_size());
+        const long last  = partition_begin(P, thread_num() + 1, team_size());
+
+        for (long part = first; part < last; part++)
+            partials[part] = kernel(blas_part_begin(n, part,     P),
+                                    blas_part_begin(n, part + 1, P));
+    }
+
+    blas_combine(partials, P, 1);
+
+    return partials[0];
+}
+
+template <typename Iterator1, typename Iterator2, typename ScalarType>
+struct axpy_kernel
+{
+    Iterator1 x; Iterator2 y; ScalarType alpha;
+
+    axpy_kernel(Iterator1 x, Iterator2 y, ScalarType alpha) : x(x), y(y), alpha(alpha) {}
+
+    void operator()(const long begin, const long end) const
+    {
+        for (long i = begin; i < end; i++)
+            y[i] = alpha * x[i] + y[i];
+    }
+};
+
+template <typename Iterator1, typename Iterator2, typename Iterator3, typename ScalarType1, typename ScalarType2>
+struct axpby_kernel
+{
+    Iterator1 x; Iterator2 y; Iterator3 z; ScalarType1 alpha; ScalarType2 beta;
+
+    axpby_kernel(Iterator1 x, Iterator2 y, Iterator3 z, ScalarType1 alpha, ScalarType2 beta)
+        : x(x), y(y), z(z), alpha(alpha), beta(beta) {}
+
+    void operator()(const long begin, const long end) const
+    {
+        for (long i = begin; i < end; i++)
+            z[i] = alpha * x[i] + beta * y[i];
+    }
+};
+
+template <typename Iterator1, typename Iterator2, typename Iterator3, typename Iterator4,
+          typename ScalarType1, typename ScalarType2, typename ScalarType3>
+struct axpbypcz_kernel
+{
+    Iterator1 x; Iterator2 y; Iterator3 z; Iterator4 w; ScalarType1 alpha; ScalarType2 beta; ScalarType3 gamma;
+
+    axpbypcz_kernel(Iterator1 x, Iterator2 y, Iterator3 z, Iterator4 w, ScalarType1 alpha, ScalarType2 beta, ScalarType3 gamma)
+        : x(x), y(y), z(z), w(w), alpha(alpha), beta(beta), gamma(gamma) {}
+
+    void operator()(const long begin, const long end) const
+    {
+        for (long i = begin; i < end; i++)
+            w[i] = alpha * x[i] + beta * y[i] + gamma * z[i];
+    }
+};
+
+template <typename Iterator, typename ScalarType>
+struct scal_kernel
+{
+    Iterator x; ScalarType alpha;
+
+    scal_kernel(Iterator x, ScalarType alpha) : x(x), alpha(alpha) {}
+
+    void operator()(const long begin, const long end) const
+    {
+        for (long i = begin; i < end; i++)
+            x[i] = alpha * x[i];
+    }
+};
+
+// sum of x[i] * y[i], or conj(x[i]) * y[i] when Conjugate is true
+template <typename Iterator1, typename Iterator2, typename ValueType, bool Conjugate>
+struct dot_kernel
+{
+    typedef ValueType result_type;
+
+    Iterator1 x; Iterator2 y;
+
+    dot_kernel(Iterator1 x, Iterator2 y) : x(x), y(y) {}
+
+    ValueType product(const long i) const
+    {
+        return Conjugate ? ValueType(blas_conjugate(ValueType(x[i])) * y[i]) : ValueType(x[i] * y[i]);
+    }
+
+    ValueType operator()(const long begin, const long end) const
+    {
+        // four independent sums can be kept in separate vector lanes
+        ValueType sum0(0), sum1(0), sum2(0), sum3(0);
+
+        long i = begin;
+
+        for (; i + 4 <= end; i += 4)
+        {
+            sum0 += product(i);
+            sum1 += product(i + 1);
+            sum2 += product(i + 2);
+            sum3 += product(i + 3);
+        }
+
+        for (; i < end; i++)
+            sum0 += product(i);
+
+        return (sum0 + sum1) + (sum2 + sum3);
+    }
+};
+
+// sum of |x[i]|^2
+template <typename Iterator, typename RealType>
+struct nrm2_kernel
+{
+    typedef RealType result_type;
+
+    Iterator x;
+
+    nrm2_kernel(Iterator x) : x(x) {}
+
+    RealType operator()(const long begin, const long end) const
+    {
+        RealType sum0(0), sum1(0), sum2(0), sum3(0);
+
+        long i = begin;
+
+        for (; i + 4 <= end; i += 4)
+        {
+            sum0 += blas_abs_squared(x[i]);
+            sum1 += blas_abs_squared(x[i + 1]);
+            sum2 += blas_abs_squared(x[i + 2]);
+            sum3 += blas_abs_squared(x[i + 3]);
+        }
+
+        for (; i < end; i++)
+            sum0 += blas_abs_squared(x[i]);
+
+        return (sum0 + sum1) + (sum2 + sum3);
+    }
+};
+
+// y = alpha * x + y
+template <typename Iterator1, typename Iterator2, typename ScalarType>
+void axpy(Iterator1 x, Iterator2 y, const size_t n, ScalarType alpha)
+{
+    blas_for(n, axpy_kernel<Iterator1,Iterator2,ScalarType>(x, y, alpha));
+}
+
+// z = alpha * x + beta * y
+template <typename Iterator1, typename Iterator2, typename Iterator3, typename ScalarType1, typename ScalarType2>
+void axpby(Iterator1 x, Iterator2 y, Iterator3 z, const size_t n, ScalarType1 alpha, ScalarType2 beta)
+{
+    blas_for(n, axpby_kernel<Iterator1,Iterator2,Iterator3,ScalarType1,ScalarType2>(x, y, z, alpha, beta));
+}
+
+// w = alpha * x + beta * y + gamma * z
+template <typename Iterator1, typename Iterator2, typename Iterator3, typename Iterator4,
+          typename ScalarType1, typename ScalarType2, typename ScalarType3>
+void axpbypcz(Iterator1 x, Iterator2 y, Iterator3 z, Iterator4 w, const size_t n,
+              ScalarType1 alpha, ScalarType2 beta, ScalarType3 gamma)
+{
+    blas_for(n, axpbypcz_kernel<Iterator1,Iterator2,Iterator3,Iterator4,ScalarType1,ScalarType2,ScalarType3>(x, y, z, w, alpha, beta, gamma));
+}
+
+// x = alpha * x
+template <typename Iterator, typename ScalarType>
+void scal(Iterator x, const size_t n, ScalarType alpha)
+{
+    blas_for(n, scal_kernel<Iterator,ScalarType>(x, alpha));
+}
+
+template <typename ValueType, typename Iterator1, typename Iterator2>
+ValueType dot(Iterator1 x, Iterator2 y, const size_t n)
+{
+    return blas_reduce(n, dot_kernel<Iterator1,Iterator2,ValueType,false>(x, y));
+}
+
+template <typename ValueType, typename Iterator1, typename Iterator2>
+ValueType dotc(Iterator1 x, Iterator2 y, const size_t n)
+{
+    return blas_reduce(n, dot_kernel<Iterator1,Iterator2,ValueType,true>(x, y));
+}
+
+// squared Euclidean norm
+template <typename RealType, typename Iterator>
+RealType nrm2_squared(Iterator x, const size_t n)
+{
+    return blas_reduce(n, nrm2_kernel<Iterator,RealType>(x));
+}
+
+// Kernels on the k columns of a column-major n-by-k matrix walk the rows
+// of each thread in blocks short enough that the block of x (or y) stays
+// in cache while every column is processed.
+const long blas_row_block_size = 1024;
+
+// y[j] = sum of A(i,j) * x[i], or conj(A(i,j)) * x[i] when Conjugate is true
+template <bool Conjugate, typename ValueType, typename Iterator1, typename Iterator2, typename Iterator3>
+void mdot(Iterator1 A, const size_t pitch, Iterator2 x, Iterator3 y, const size_t n, const size_t k)
+{
+    typedef dot_kernel<Iterator1,Iterator2,ValueType,Conjugate> Kernel;
+
+    const size_t T = num_threads(n * k, blas_grain_size);
+    const size_t P = blas_num_parts(n, T);
+
+    std::vector<ValueType> partials(P * k, ValueType(0));
+
+    #pragma omp parallel num_threads(T)
+    {
+        const long first = partition_begin(P, thread_num(),     team_size());
+        const long last  = partition_begin(P, thread_num() + 1, team_size());
+
+        for (long part = first; part < last; part++)
+        {
+            const long begin = blas_part_begin(n, part,     P);
+            const long end   = blas_part_begin(n, part + 1, P);
+
+            ValueType * sums = &partials[0] + part * k;
+
+            for (long block = begin; block < end; block += blas_row_block_size)
+            {
+                const long block_end = std::min(block + blas_row_block_size, end);
+
+                for (size_t j = 0; j < k; j++)
+                    sums[j] += Kernel(A + j * pitch, x)(block, block_end);
+            }
+        }
+    }
+
+    blas_combine(partials, P, k);
+
+    for (size_t j = 0; j < k; j++)
+        y[j] = partials[j];
+}
+
+// y = alpha * A * x + y, adding the columns in order as successive axpy calls do
+template <typename ValueType, typename Iterator1, typename Iterator2, typename Iterator3, typename ScalarType>
+void maxpy(Iterator1 A, const size_t pitch, Iterator2 x, Iterator3 y, const size_t n, const size_t k, ScalarType alpha)
+{
+    std::vector<ValueType> coefficients(k);
+
+    for (size_t j = 0; j < k; j++)
+        coefficients[j] = alpha * ValueType(x[j]);
+
+    #pragma omp parallel num_threads(num_threads(n * k, blas_grain_size))
+    {
+        const long begin = partition_begin(n, thread_num(),     team_size());
+        const long end   = partition_begin(n, thread_num() + 1, team_size());
+
+        for (long block = begin; block < end; block += blas_row_block_size)
+        {
+            const long block_end = std::min(block + blas_row_block_size, end);
+
+            for (size_t j = 0; j < k; j++)
+                axpy_kernel<Iterator1,Iterator3,ValueType>(A + j * pitch, y, coefficients[j])(block, block_end);
+        }
+    }
+}
+
+} // end namespace host
+} // end namespace detail
+} // end namespace cusp
+
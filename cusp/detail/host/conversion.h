@@ -22,6 +22,8 @@
 #include <cusp/exception.h>
 
 #include <cusp/detail/host/conversion_utils.h>
+#include <cusp/detail/host/detail/coo.h>
+#include <cusp/detail/host/detail/csr.h>
 
 #include <thrust/fill.h>
 #include <thrust/extrema.h>
@@ -38,51 +40,29 @@ namespace host
 // COO Conversions //
 /////////////////////
     
+// The entries of each row of dst keep their order in src unless sort_columns
+// is set, in which case they are sorted by column index.  When
+// sum_duplicates is set entries with the same coordinates are combined.
+// With both set dst is in canonical form.
 template <typename Matrix1, typename Matrix2>
-void coo_to_csr(const Matrix1& src, Matrix2& dst)
+void coo_to_csr(const Matrix1& src, Matrix2& dst,
+                const bool sort_columns   = false,
+                const bool sum_duplicates = false)
 {
-    typedef typename Matrix2::index_type IndexType;
-    typedef typename Matrix2::value_type ValueType;
-
     dst.resize(src.num_rows, src.num_cols, src.num_entries);
-    
-    // compute number of non-zero entries per row of A 
-    thrust::fill(dst.row_offsets.begin(), dst.row_offsets.end(), IndexType(0));
 
-    for (size_t n = 0; n < src.num_entries; n++)
-        dst.row_offsets[src.row_indices[n]]++;
-
-    // cumsum the num_entries per row to get dst.row_offsets[]
-    IndexType cumsum = 0;
-    for(size_t i = 0; i < src.num_rows; i++)
-    {
-        IndexType temp = dst.row_offsets[i];
-        dst.row_offsets[i] = cumsum;
-        cumsum += temp;
-    }
-    dst.row_offsets[src.num_rows] = cumsum;
+    cusp::detail::host::detail::coo_to_csr
+        (src.num_rows, src.num_entries,
+         src.row_indices, src.column_indices, src.values,
+         dst.row_offsets, dst.column_indices, dst.values);
 
-    // write Aj,Ax into dst.column_indices,dst.values
-    for(size_t n = 0; n < src.num_entries; n++)
-    {
-        IndexType row  = src.row_indices[n];
-        IndexType dest = dst.row_offsets[row];
-
-        dst.column_indices[dest] = src.column_indices[n];
-        dst.values[dest]         = src.values[n];
-
-        dst.row_offsets[row]++;
-    }
-
-    IndexType last = 0; 
-    for(size_t i = 0; i <= src.num_rows; i++)
-    {
-        IndexType temp = dst.row_offsets[i];
-        dst.row_offsets[i]  = last;
-        last   = temp;
-    }
+    const size_t num_entries =
+        cusp::detail::host::detail::csr_canonicalize
+            (src.num_rows, src.num_cols,
+             dst.row_offsets, dst.column_indices, dst.values,
+             sort_columns, sum_duplicates);
 
-    //csr may contain duplicates
+    dst.resize(src.num_rows, src.num_cols, num_entries);
 }
 
 template <typename Matrix1, typename Matrix2>
@@ -106,18 +86,12 @@ void coo_to_array2d(const Matrix1& src, Matrix2& dst)
 template <typename Matrix1, typename Matrix2>
 void csr_to_coo(const Matrix1& src, Matrix2& dst)
 {
-    typedef typename Matrix2::index_type IndexType;
-    typedef typename Matrix2::value_type ValueType;
-
     dst.resize(src.num_rows, src.num_cols, src.num_entries);
-   
-    // TODO replace with offsets_to_indices
-    for(size_t i = 0; i < src.num_rows; i++)
-        for(IndexType jj = src.row_offsets[i]; jj < src.row_offsets[i + 1]; jj++)
-            dst.row_indices[jj] = i;
 
-    cusp::copy(src.column_indices, dst.column_indices);
-    cusp::copy(src.values,         dst.values);
+    cusp::detail::host::detail::csr_to_coo
+        (src.num_rows,
+         src.row_offsets, src.column_indices, src.values,
+         dst.row_indices, dst.column_indices, dst.values);
 }
 
 template <typename Matrix1, typename Matrix2>
@@ -127,53 +101,48 @@ void csr_to_dia(const Matrix1& src, Matrix2& dst,
     typedef typename Matrix2::index_type IndexType;
     typedef typename Matrix2::value_type ValueType;
 
-    // compute number of occupied diagonals and enumerate them
-    size_t num_diagonals = 0;
+    typedef cusp::detail::host::detail::bitmap_word bitmap_word;
 
-    cusp::array1d<IndexType,cusp::host_memory> diag_map(src.num_rows + src.num_cols, 0);
+    const size_t word_bits = cusp::detail::host::detail::bitmap_word_bits;
 
-    for(size_t i = 0; i < src.num_rows; i++)
-    {
-        for(IndexType jj = src.row_offsets[i]; jj < src.row_offsets[i+1]; jj++)
-        {
-            size_t j         = src.column_indices[jj];
-            size_t map_index = (src.num_rows - i) + j; //offset shifted by + num_rows
+    // compute number of occupied diagonals and enumerate them
+    cusp::array1d<bitmap_word,cusp::host_memory> occupied;
+    cusp::array1d<size_t,cusp::host_memory>      rank;
 
-            if(diag_map[map_index] == 0)
-            {
-                diag_map[map_index] = 1;
-                num_diagonals++;
-            }
-        }
-    }
-   
+    const size_t num_diagonals = cusp::detail::host::detail::diagonal_census(src, occupied, rank);
 
     // allocate DIA structure
     dst.resize(src.num_rows, src.num_cols, src.num_entries, num_diagonals, alignment);
 
     // fill in diagonal_offsets array
-    for(size_t n = 0, diag = 0; n < src.num_rows + src.num_cols; n++)
+    #pragma omp parallel for num_threads(num_threads(occupied.size()))
+    for(long w = 0; w < long(occupied.size()); w++)
     {
-        if(diag_map[n] == 1)
-        {
-            diag_map[n] = diag;
-            dst.diagonal_offsets[diag] = (IndexType) n - (IndexType) src.num_rows;
-            diag++;
-        }
+        size_t diag = rank[w];
+
+        for(size_t b = 0; b < word_bits; b++)
+            if ((occupied[w] >> b) & 1)
+                dst.diagonal_offsets[diag++] = (IndexType) (w * word_bits + b) - (IndexType) src.num_rows;
     }
 
     // fill in values array
-    thrust::fill(dst.values.values.begin(), dst.values.values.end(), ValueType(0));
+    parallel_fill(dst.values.values, ValueType(0));
 
-    for(size_t i = 0; i < src.num_rows; i++)
+    #pragma omp parallel num_threads(num_threads(src.num_entries))
     {
-        for(IndexType jj = src.row_offsets[i]; jj < src.row_offsets[i+1]; jj++)
+        const size_t begin = weighted_partition_begin(src.row_offsets, thread_num(),     team_size());
+        const size_t end   = weighted_partition_begin(src.row_offsets, thread_num() + 1, team_size());
+
+        for(size_t i = begin; i < end; i++)
         {
-            size_t j = src.column_indices[jj];
-            size_t map_index = (src.num_rows - i) + j; //offset shifted by + num_rows
-            size_t diag = diag_map[map_index];
-        
-            dst.values(i, diag) = src.values[jj];
+            for(IndexType jj = src.row_offsets[i]; jj < src.row_offsets[i+1]; jj++)
+            {
+                size_t j = src.column_indices[jj];
+                size_t map_index = (src.num_rows - i) + j; //offset shifted by + num_rows
+                size_t diag = cusp::detail::host::detail::diagonal_rank(occupied, rank, map_index);
+
+                dst.values(i, diag) = src.values[jj];
+            }
         }
     }
 }
@@ -191,12 +160,20 @@ void csr_to_hyb(const Matrix1& src, Matrix2& dst,
     // Nonzero values that do not fit within the ELL structure are placed in the 
     // COO format portion of the HYB matrix.
     
-    // compute number of nonzeros in the ELL and COO portions
-    size_t num_ell_entries = 0;
-    for(size_t i = 0; i < src.num_rows; i++)
-        num_ell_entries += thrust::min<size_t>(num_entries_per_row, src.row_offsets[i+1] - src.row_offsets[i]); 
+    // compute number of nonzeros in the COO portion of each row and
+    // scan them to find where each row starts in the COO
+    cusp::array1d<IndexType,cusp::host_memory> coo_offsets(src.num_rows + 1);
+
+    #pragma omp parallel for num_threads(num_threads(src.num_rows))
+    for(long i = 0; i < long(src.num_rows); i++)
+    {
+        size_t row_length = src.row_offsets[i+1] - src.row_offsets[i];
+        coo_offsets[i] = row_length - thrust::min<size_t>(num_entries_per_row, row_length);
+    }
+
+    IndexType num_coo_entries = counts_to_offsets(coo_offsets);
 
-    IndexType num_coo_entries = src.num_entries - num_ell_entries;
+    size_t num_ell_entries = src.num_entries - num_coo_entries;
 
     dst.resize(src.num_rows, src.num_cols, 
                num_ell_entries, num_coo_entries, 
@@ -205,29 +182,34 @@ void csr_to_hyb(const Matrix1& src, Matrix2& dst,
     const IndexType invalid_index = cusp::ell_matrix<IndexType, ValueType, cusp::host_memory>::invalid_index;
 
     // pad out ELL format with zeros
-    thrust::fill(dst.ell.column_indices.values.begin(), dst.ell.column_indices.values.end(), invalid_index);
-    thrust::fill(dst.ell.values.values.begin(),         dst.ell.values.values.end(),         ValueType(0));
+    parallel_fill(dst.ell.column_indices.values, invalid_index);
+    parallel_fill(dst.ell.values.values,         ValueType(0));
 
-    for(size_t i = 0, coo_nnz = 0; i < src.num_rows; i++)
+    #pragma omp parallel num_threads(num_threads(src.num_entries))
     {
-        size_t n = 0;
-        IndexType jj = src.row_offsets[i];
+        const size_t begin = weighted_partition_begin(src.row_offsets, thread_num(),     team_size());
+        const size_t end   = weighted_partition_begin(src.row_offsets, thread_num() + 1, team_size());
 
-        // copy up to num_cols_per_row values of row i into the ELL
-        while(jj < src.row_offsets[i+1] && n < num_entries_per_row)
+        for(size_t i = begin; i < end; i++)
         {
-            dst.ell.column_indices(i,n) = src.column_indices[jj];
-            dst.ell.values(i,n)         = src.values[jj];
-            jj++, n++;
-        }
+            size_t n = 0;
+            IndexType jj = src.row_offsets[i];
 
-        // copy any remaining values in row i into the COO
-        while(jj < src.row_offsets[i+1])
-        {
-            dst.coo.row_indices[coo_nnz]    = i;
-            dst.coo.column_indices[coo_nnz] = src.column_indices[jj];
-            dst.coo.values[coo_nnz]         = src.values[jj];
-            jj++; coo_nnz++;
+            // copy up to num_cols_per_row values of row i into the ELL
+            while(jj < src.row_offsets[i+1] && n < num_entries_per_row)
+            {
+                dst.ell.column_indices(i,n) = src.column_indices[jj];
+                dst.ell.values(i,n)         = src.values[jj];
+                jj++, n++;
+            }
+
+            // copy any remaining values in row i into the COO
+            for(IndexType coo_nnz = coo_offsets[i]; jj < src.row_offsets[i+1]; jj++, coo_nnz++)
+            {
+                dst.coo.row_indices[coo_nnz]    = i;
+                dst.coo.column_indices[coo_nnz] = src.column_indices[jj];
+                dst.coo.values[coo_nnz]         = src.values[jj];
+            }
         }
     }
 }
@@ -241,9 +223,10 @@ void csr_to_ell(const Matrix1& src, Matrix2& dst,
     typedef typename Matrix2::value_type ValueType;
 
     // compute number of nonzeros
-
     size_t num_entries = 0;
-    for(size_t i = 0; i < src.num_rows; i++)
+
+    #pragma omp parallel for num_threads(num_threads(src.num_rows)) reduction(+ : num_entries)
+    for(long i = 0; i < long(src.num_rows); i++)
         num_entries += thrust::min<size_t>(num_entries_per_row, src.row_offsets[i+1] - src.row_offsets[i]); 
 
     dst.resize(src.num_rows, src.num_cols, num_entries, num_entries_per_row, alignment);
@@ -251,20 +234,26 @@ void csr_to_ell(const Matrix1& src, Matrix2& dst,
     const IndexType invalid_index = cusp::ell_matrix<IndexType, ValueType, cusp::host_memory>::invalid_index;
 
     // pad out ELL format with zeros
-    thrust::fill(dst.column_indices.values.begin(), dst.column_indices.values.end(), invalid_index);
-    thrust::fill(dst.values.values.begin(),         dst.values.values.end(),         ValueType(0));
+    parallel_fill(dst.column_indices.values, invalid_index);
+    parallel_fill(dst.values.values,         ValueType(0));
 
-    for(size_t i = 0; i < src.num_rows; i++)
+    #pragma omp parallel num_threads(num_threads(src.num_entries))
     {
-        size_t n = 0;
-        IndexType jj = src.row_offsets[i];
+        const size_t begin = weighted_partition_begin(src.row_offsets, thread_num(),     team_size());
+        const size_t end   = weighted_partition_begin(src.row_offsets, thread_num() + 1, team_size());
 
-        // copy up to num_cols_per_row values of row i into the ELL
-        while(jj < src.row_offsets[i+1] && n < num_entries_per_row)
+        for(size_t i = begin; i < end; i++)
         {
-            dst.column_indices(i,n) = src.column_indices[jj];
-            dst.values(i,n)         = src.values[jj];
-            jj++, n++;
+            size_t n = 0;
+            IndexType jj = src.row_offsets[i];
+
+            // copy up to num_cols_per_row values of row i into the ELL
+            while(jj < src.row_offsets[i+1] && n < num_entries_per_row)
+            {
+                dst.column_indices(i,n) = src.column_indices[jj];
+                dst.values(i,n)         = src.values[jj];
+                jj++, n++;
+            }
         }
     }
 }
@@ -24,6 +24,8 @@
 #include <cusp/array1d.h>
 #include <cusp/csr_matrix.h>
 
+#include <cusp/detail/host/parallel.h>
+
 #include <thrust/count.h>
 
 // TODO remove std::
@@ -37,23 +39,96 @@ namespace host
 namespace detail
 {
 
-template <typename Matrix>
-size_t count_diagonals(const Matrix& csr, cusp::csr_format)
+typedef unsigned long long bitmap_word;
+
+const size_t bitmap_word_bits = 8 * sizeof(bitmap_word);
+
+// number of set bits in a word
+inline size_t popcount(bitmap_word x)
+{
+    x = x - ((x >> 1) & 0x5555555555555555ULL);
+    x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+    x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return (x * 0x0101010101010101ULL) >> 56;
+}
+
+// Parallel census of the occupied diagonals of a CSR matrix.  The diagonal
+// of entry (i,j) is recorded in bit (num_rows - i) + j of the bitmap
+// occupied.  Each thread marks its rows in a private bitmap and the bitmaps
+// are merged with a bitwise or; the number of private bitmaps is limited so
+// that they hold no more words than the matrix has entries.  On return
+// rank[w] is the number of occupied diagonals in words [0,w) of occupied.
+// Returns the number of occupied diagonals.
+template <typename Matrix, typename Array1, typename Array2>
+size_t diagonal_census(const Matrix& csr, Array1& occupied, Array2& rank)
 {
     typedef typename Matrix::index_type IndexType;
 
-    cusp::array1d<bool,cusp::host_memory> occupied_diagonals(csr.num_rows + csr.num_cols, false);
+    const size_t num_words = (csr.num_rows + csr.num_cols + bitmap_word_bits - 1) / bitmap_word_bits;
 
-    for(size_t i = 0; i < csr.num_rows; i++)
+    occupied.resize(num_words);
+    rank.resize(num_words + 1);
+
+    const size_t T = num_threads(csr.num_entries, std::max(parallel_grain_size, num_words));
+
+    std::vector< std::vector<bitmap_word> > bitmaps(T);
+
+    #pragma omp parallel num_threads(T)
     {
-        for(IndexType jj = csr.row_offsets[i]; jj < csr.row_offsets[i+1]; jj++){
-            IndexType j = csr.column_indices[jj];
-            IndexType diagonal_offset = (csr.num_rows - i) + j; //offset shifted by + num_rows
-            occupied_diagonals[diagonal_offset] = true;
+        const size_t tid  = thread_num();
+        const size_t size = team_size();
+
+        const size_t begin = weighted_partition_begin(csr.row_offsets, tid,     size);
+        const size_t end   = weighted_partition_begin(csr.row_offsets, tid + 1, size);
+
+        std::vector<bitmap_word>& bitmap = bitmaps[tid];
+        bitmap.assign(num_words, bitmap_word(0));
+
+        for(size_t i = begin; i < end; i++)
+        {
+            for(IndexType jj = csr.row_offsets[i]; jj < csr.row_offsets[i+1]; jj++)
+            {
+                size_t map_index = (csr.num_rows - i) + csr.column_indices[jj]; //offset shifted by + num_rows
+                bitmap[map_index / bitmap_word_bits] |= bitmap_word(1) << (map_index % bitmap_word_bits);
+            }
+        }
+
+        #pragma omp barrier
+
+        const size_t word_begin = partition_begin(num_words, tid,     size);
+        const size_t word_end   = partition_begin(num_words, tid + 1, size);
+
+        for(size_t w = word_begin; w < word_end; w++)
+        {
+            bitmap_word x = 0;
+            for(size_t t = 0; t < size; t++)
+                x |= bitmaps[t][w];
+
+            occupied[w] = x;
+            rank[w]     = popcount(x);
         }
     }
 
-    return thrust::count(occupied_diagonals.begin(), occupied_diagonals.end(), true);
+    return counts_to_offsets(rank);
+}
+
+// position of an occupied diagonal among all occupied diagonals
+template <typename Array1, typename Array2>
+size_t diagonal_rank(const Array1& occupied, const Array2& rank, const size_t map_index)
+{
+    const size_t w = map_index / bitmap_word_bits;
+    const size_t b = map_index % bitmap_word_bits;
+
+    return rank[w] + popcount(occupied[w] & ((bitmap_word(1) << b) - 1));
+}
+
+template <typename Matrix>
+size_t count_diagonals(const Matrix& csr, cusp::csr_format)
+{
+    cusp::array1d<bitmap_word,cusp::host_memory> occupied;
+    cusp::array1d<size_t,cusp::host_memory>      rank;
+
+    return diagonal_census(csr, occupied, rank);
 }
 
 template <typename Matrix>
@@ -0,0 +1,221 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file accumulator.h
+ *  \brief Sparse row accumulators used by host SpGEMM and elementwise kernels
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cstddef>
+#include <vector>
+
+namespace cusp
+{
+namespace detail
+{
+namespace host
+{
+namespace detail
+{
+
+// An accumulator collects the distinct column indices produced while a row
+// is being formed and assigns each one a slot in [0, size()) in the order
+// it was first seen.  find() returns the slot of a column, or -1 if the
+// column has not been inserted.  Callers keep the values for a row in a
+// compact array indexed by slot, so the memory touched per row is
+// proportional to the number of entries in the row rather than to the
+// width of the matrix.
+//
+// Two interchangeable implementations are provided:
+//   dense_accumulator - direct map from column to slot (O(num_cols) memory)
+//   hash_accumulator  - open-addressing table sized by an upper bound on the
+//                       number of distinct columns in the row
+
+template <typename IndexType>
+class dense_accumulator
+{
+    std::vector<IndexType> slots;
+    std::vector<IndexType> keys;
+
+public:
+    bool empty(void) const
+    {
+        return slots.empty();
+    }
+
+    void resize(const size_t num_cols)
+    {
+        slots.assign(num_cols, IndexType(-1));
+    }
+
+    void reserve(const size_t)
+    {
+    }
+
+    IndexType insert(const IndexType key)
+    {
+        IndexType& slot = slots[key];
+
+        if (slot == IndexType(-1))
+        {
+            slot = keys.size();
+            keys.push_back(key);
+        }
+
+        return slot;
+    }
+
+    IndexType find(const IndexType key) const
+    {
+        return slots[key];
+    }
+
+    size_t size(void) const
+    {
+        return keys.size();
+    }
+
+    IndexType key(const size_t slot) const
+    {
+        return keys[slot];
+    }
+
+    void clear(void)
+    {
+        for (size_t n = 0; n < keys.size(); n++)
+            slots[keys[n]] = IndexType(-1);
+
+        keys.clear();
+    }
+};
+
+template <typename IndexType>
+class hash_accumulator
+{
+    std::vector<IndexType> table_keys;
+    std::vector<IndexType> table_slots;
+    std::vector<size_t>    positions;
+    size_t                 mask;
+
+    size_t hash(const IndexType key) const
+    {
+        size_t h = static_cast<size_t>(key) * static_cast<size_t>(2654435769u);
+        return (h ^ (h >> 15)) & mask;
+    }
+
+public:
+    hash_accumulator(void) : mask(0) {}
+
+    // table size used for a row with at most bound distinct columns
+    // (load factor at most 1/2)
+    static size_t capacity(const size_t bound)
+    {
+        size_t n = 16;
+        while (n < 2 * bound)
+            n *= 2;
+        return n;
+    }
+
+    // prepare the table for a row with at most bound distinct columns
+    void reserve(const size_t bound)
+    {
+        const size_t n = capacity(bound);
+
+        if (table_keys.size() < n)
+        {
+            table_keys.assign(n, IndexType(-1));
+            table_slots.resize(n);
+        }
+
+        mask = n - 1;
+    }
+
+    IndexType insert(const IndexType key)
+    {
+        size_t h = hash(key);
+
+        while (true)
+        {
+            if (table_keys[h] == key)
+                return table_slots[h];
+
+            if (table_keys[h] == IndexType(-1))
+            {
+                table_keys[h]  = key;
+                table_slots[h] = positions.size();
+                positions.push_back(h);
+                return table_slots[h];
+            }
+
+            h = (h + 1) & mask;
+        }
+    }
+
+    IndexType find(const IndexType key) const
+    {
+        size_t h = hash(key);
+
+        while (table_keys[h] != key)
+        {
+            if (table_keys[h] == IndexType(-1))
+                return IndexType(-1);
+
+            h = (h + 1) & mask;
+        }
+
+        return table_slots[h];
+    }
+
+    size_t size(void) const
+    {
+        return positions.size();
+    }
+
+    IndexType key(const size_t slot) const
+    {
+        return table_keys[positions[slot]];
+    }
+
+    void clear(void)
+    {
+        for (size_t n = 0; n < positions.size(); n++)
+            table_keys[positions[n]] = IndexType(-1);
+
+        positions.clear();
+    }
+};
+
+// matrices narrower than this always use a dense accumulator
+const size_t hash_accumulator_min_cols = 4096;
+
+// Choose the accumulator for a row with at most bound distinct columns in a
+// matrix with num_cols columns.  The dense accumulator is faster per update,
+// but costs O(num_cols) memory per thread and scatters updates across it, so
+// rows that are short relative to the matrix width use the hash table.
+inline bool use_hash_accumulator(const size_t bound, const size_t num_cols)
+{
+    return num_cols > hash_accumulator_min_cols &&
+           16 * hash_accumulator<size_t>::capacity(bound) <= num_cols;
+}
+
+} // end namespace detail
+} // end namespace host
+} // end namespace detail
+} // end namespace cusp
+
@@ -0,0 +1,360 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file assembly.h
+ *  \brief Parallel assembly of CSR matrices from (i,j,v) triplets
+ */
+
+#pragma once
+
+#include <cusp/array1d.h>
+#include <cusp/exception.h>
+
+#include <cusp/detail/host/parallel.h>
+#include <cusp/detail/host/detail/csr.h>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace cusp
+{
+namespace detail
+{
+namespace host
+{
+namespace detail
+{
+
+// Triplets appended by one thread.  The padding keeps the vectors of
+// neighbouring buffers, which are grown by different threads, off the
+// same cache line.
+template <typename IndexType, typename ValueType>
+struct triplet_buffer
+{
+    std::vector<IndexType> row_indices;
+    std::vector<IndexType> column_indices;
+    std::vector<ValueType> values;
+
+    char padding[64];
+};
+
+// Assemble the triplets held in a set of buffers into a CSR matrix with
+// sorted column indices and duplicate entries summed.  Rather than sorting
+// all triplets, the rows are split into blocks (several per thread):
+//   1) each buffer counts its triplets per row block
+//   2) the counts are scanned in (block, buffer) order and every buffer
+//      scatters its triplets into a contiguous region per block
+//   3) each block is processed independently: a counting sort by row within
+//      the block, then a sort and sum of every row
+//   4) the row lengths are scanned and the blocks copied into place
+// Triplets from lower numbered buffers precede those from higher numbered
+// buffers in each row, so the result does not depend on the thread count.
+// Throws cusp::invalid_input_exception if a triplet lies outside the matrix.
+template <typename Buffer, typename Array1, typename Array2, typename Array3>
+size_t assemble_csr(const size_t num_rows, const size_t num_cols,
+                    const std::vector<Buffer>& buffers,
+                    Array1& row_offsets, Array2& column_indices, Array3& values)
+{
+    typedef typename Array1::value_type IndexType;
+    typedef typename Array3::value_type ValueType;
+
+    const size_t P = buffers.size();
+
+    size_t N = 0;
+    for(size_t p = 0; p < P; p++)
+        N += buffers[p].values.size();
+
+    const size_t T = num_threads(N);
+
+    const size_t rows_per_block = std::max<size_t>(1, (num_rows + 8 * T - 1) / (8 * T));
+    const size_t B              = (num_rows + rows_per_block - 1) / rows_per_block;
+
+    // counts[p * B + b] : number of triplets of buffer p in block b
+    std::vector<size_t> counts(P * B + 1, 0);
+
+    bool valid = true;
+
+    #pragma omp parallel for num_threads(std::min(P, T)) schedule(dynamic) reduction(&& : valid)
+    for(long p = 0; p < long(P); p++)
+    {
+        const Buffer& buffer = buffers[p];
+
+        size_t * count = &counts[p * B];
+
+        for(size_t n = 0; n < buffer.values.size(); n++)
+        {
+            const IndexType i = buffer.row_indices[n];
+            const IndexType j = buffer.column_indices[n];
+
+            if (i < 0 || size_t(i) >= num_rows || j < 0 || size_t(j) >= num_cols)
+            {
+                valid = false;
+                continue;
+            }
+
+            count[size_t(i) / rows_per_block]++;
+        }
+    }
+
+    if (!valid)
+        throw cusp::invalid_input_exception("triplet index exceeds matrix dimensions");
+
+    std::vector<size_t> block_offsets(B + 1);
+
+    size_t sum = 0;
+
+    for(size_t b = 0; b < B; b++)
+    {
+        block_offsets[b] = sum;
+
+        for(size_t p = 0; p < P; p++)
+        {
+            size_t temp = counts[p * B + b];
+            counts[p * B + b] = sum;
+            sum += temp;
+        }
+    }
+
+    block_offsets[B] = sum;
+
+    cusp::array1d<IndexType,cusp::host_memory> staging_rows(N);
+    cusp::array1d<IndexType,cusp::host_memory> staging_columns(N);
+    cusp::array1d<ValueType,cusp::host_memory> staging_values(N);
+
+    #pragma omp parallel for num_threads(std::min(P, T)) schedule(dynamic)
+    for(long p = 0; p < long(P); p++)
+    {
+        const Buffer& buffer = buffers[p];
+
+        size_t * cursor = &counts[p * B];
+
+        for(size_t n = 0; n < buffer.values.size(); n++)
+        {
+            const size_t dest = cursor[size_t(buffer.row_indices[n]) / rows_per_block]++;
+
+            staging_rows[dest]    = buffer.row_indices[n];
+            staging_columns[dest] = buffer.column_indices[n];
+            staging_values[dest]  = buffer.values[n];
+        }
+    }
+
+    row_offsets.resize(num_rows + 1);
+
+    size_t num_entries = 0;
+
+    #pragma omp parallel num_threads(T)
+    {
+        std::vector<size_t>    row_ends;
+        std::vector<IndexType> block_columns;
+        std::vector<ValueType> block_values;
+
+        std::vector< std::pair<IndexType,ValueType> > entries;
+
+        #pragma omp for schedule(dynamic)
+        for(long b = 0; b < long(B); b++)
+        {
+            const size_t first_row = b * rows_per_block;
+            const size_t last_row  = std::min(num_rows, first_row + rows_per_block);
+
+            const size_t begin = block_offsets[b];
+            const size_t end   = block_offsets[b + 1];
+
+            // counting sort of the block by row
+            row_ends.assign(last_row - first_row, 0);
+
+            for(size_t n = begin; n < end; n++)
+                row_ends[staging_rows[n] - first_row]++;
+
+            size_t offset = 0;
+            for(size_t k = 0; k < row_ends.size(); k++)
+            {
+                size_t temp = row_ends[k];
+                row_ends[k] = offset;
+                offset += temp;
+            }
+
+            block_columns.resize(end - begin);
+            block_values.resize(end - begin);
+
+            for(size_t n = begin; n < end; n++)
+            {
+                const size_t dest = row_ends[staging_rows[n] - first_row]++;
+
+                block_columns[dest] = staging_columns[n];
+                block_values[dest]  = staging_values[n];
+            }
+
+            // sort and sum each row, compacting the block in staging
+            size_t row_begin = 0;
+            size_t length    = 0;
+
+            for(size_t k = 0; k < row_ends.size(); k++)
+            {
+                const IndexType row_end = row_ends[k];
+
+                csr_sort_row(IndexType(row_begin), row_end, block_columns, block_values, entries);
+
+                const IndexType row_length =
+                    csr_sum_sorted_row(IndexType(row_begin), row_end, block_columns, block_values);
+
+                std::copy(block_columns.begin() + row_begin, block_columns.begin() + row_begin + row_length,
+                          staging_columns.begin() + begin + length);
+                std::copy(block_values.begin()  + row_begin, block_values.begin()  + row_begin + row_length,
+                          staging_values.begin()  + begin + length);
+
+                row_offsets[first_row + k] = row_length;
+
+                length   += row_length;
+                row_begin = row_end;
+            }
+        }
+
+        #pragma omp single
+        {
+            num_entries = counts_to_offsets(row_offsets);
+
+            column_indices.resize(num_entries);
+            values.resize(num_entries);
+        }
+
+        // copy each block into place
+        #pragma omp for schedule(dynamic)
+        for(long b = 0; b < long(B); b++)
+        {
+            const size_t first_row = b * rows_per_block;
+            const size_t last_row  = std::min(num_rows, first_row + rows_per_block);
+
+            const size_t begin  = block_offsets[b];
+            const size_t length = row_offsets[last_row] - row_offsets[first_row];
+
+            std::copy(staging_columns.begin() + begin, staging_columns.begin() + begin + length,
+                      column_indices.begin() + row_offsets[first_row]);
+            std::copy(staging_values.begin()  + begin, staging_values.begin()  + begin + length,
+                      values.begin()         + row_offsets[first_row]);
+        }
+    }
+
+    return num_entries;
+}
+
+// Map every triplet (row_indices[n], column_indices[n]) to the entry of a
+// CSR matrix with the same coordinates and store the inverse of that map:
+// entry k of the matrix receives triplets[offsets[k]] ... triplets[offsets[k+1]-1],
+// in increasing order.  Rows with sorted columns are binary searched.
+// Throws cusp::invalid_input_exception if a triplet is not an entry of the
+// matrix.
+template <typename Array1, typename Array2, typename Array3,
+          typename Array4, typename Array5, typename Array6>
+void csr_assembly_map(const size_t num_rows, const size_t num_cols,
+                      const Array1& row_offsets, const Array2& column_indices,
+                      const Array3& triplet_rows, const Array4& triplet_columns,
+                            Array5& offsets, Array6& triplets)
+{
+    typedef typename Array1::value_type IndexType;
+    typedef typename Array6::value_type TripletType;
+
+    const size_t N           = triplet_rows.size();
+    const size_t num_entries = row_offsets[num_rows];
+
+    const bool sorted = csr_has_sorted_rows(num_rows, row_offsets, column_indices);
+
+    cusp::array1d<IndexType,cusp::host_memory> positions(N);
+
+    bool valid = true;
+
+    #pragma omp parallel for num_threads(num_threads(N)) reduction(&& : valid)
+    for(long n = 0; n < long(N); n++)
+    {
+        const IndexType i = triplet_rows[n];
+        const IndexType j = triplet_columns[n];
+
+        if (i < 0 || size_t(i) >= num_rows || j < 0 || size_t(j) >= num_cols)
+        {
+            valid = false;
+            continue;
+        }
+
+        const IndexType row_begin = row_offsets[i];
+        const IndexType row_end   = row_offsets[i + 1];
+
+        IndexType jj = row_begin;
+
+        if (sorted)
+            jj = std::lower_bound(column_indices.begin() + row_begin,
+                                  column_indices.begin() + row_end, j) - column_indices.begin();
+        else
+            while (jj < row_end && column_indices[jj] != j)
+                jj++;
+
+        if (jj == row_end || column_indices[jj] != j)
+        {
+            valid = false;
+            continue;
+        }
+
+        positions[n] = jj;
+    }
+
+    if (!valid)
+        throw cusp::invalid_input_exception("triplet is not an entry of the matrix");
+
+    // counting sort of the triplets by position
+    offsets.resize(num_entries + 1);
+    triplets.resize(N);
+
+    parallel_fill(offsets, 0);
+
+    for(size_t n = 0; n < N; n++)
+        offsets[positions[n]]++;
+
+    counts_to_offsets(offsets);
+
+    std::vector<size_t> cursor(offsets.begin(), offsets.end() - 1);
+
+    for(size_t n = 0; n < N; n++)
+        triplets[cursor[positions[n]]++] = TripletType(n);
+}
+
+// Set every entry of a matrix to the sum of the triplet values mapped to it
+// by csr_assembly_map.  Entries are independent, so no synchronization is
+// needed, and each entry sums its triplets in a fixed order.
+template <typename Array1, typename Array2, typename Array3, typename Array4>
+void refresh_values(const Array1& offsets, const Array2& triplets,
+                    const Array3& triplet_values, Array4& values)
+{
+    typedef typename Array1::value_type IndexType;
+    typedef typename Array4::value_type ValueType;
+
+    const size_t num_entries = values.size();
+
+    #pragma omp parallel for num_threads(num_threads(triplets.size()))
+    for(long k = 0; k < long(num_entries); k++)
+    {
+        ValueType sum = 0;
+
+        for(IndexType t = offsets[k]; t < offsets[k + 1]; t++)
+            sum += triplet_values[triplets[t]];
+
+        values[k] = sum;
+    }
+}
+
+} // end namespace detail
+} // end namespace host
+} // end namespace detail
+} // end namespace cusp
+
@@ -19,8 +19,12 @@
 #include <cusp/array1d.h>
 
 #include <cusp/detail/format_utils.h>
+#include <cusp/detail/host/parallel.h>
+#include <cusp/detail/host/sort.h>
 #include <cusp/detail/host/detail/csr.h>
 
+#include <algorithm>
+
 namespace cusp
 {
 namespace detail
@@ -30,6 +34,246 @@ namespace host
 namespace detail
 {
 
+// true if the row indices of a COO matrix are non-decreasing
+template <typename Array>
+bool coo_is_sorted_by_row(const size_t num_entries, const Array& row_indices)
+{
+    bool sorted = true;
+
+    #pragma omp parallel num_threads(num_threads(num_entries)) reduction(&& : sorted)
+    {
+        const size_t begin = std::max<size_t>(1, partition_begin(num_entries, thread_num(), team_size()));
+        const size_t end   = partition_begin(num_entries, thread_num() + 1, team_size());
+
+        for(size_t n = begin; sorted && n < end; n++)
+            if (row_indices[n] < row_indices[n - 1])
+                sorted = false;
+    }
+
+    return sorted;
+}
+
+// Parallel COO to CSR conversion on arrays.  Entries of a row keep the order
+// they have in the COO arrays.  When the COO entries are sorted by row the
+// row offsets are found at the row boundaries and the remaining arrays are
+// copied.  Otherwise each thread histograms the rows of a contiguous block
+// of entries, the per-thread counts are scanned into starting positions and
+// each thread scatters its block.  The per-thread histograms hold num_rows
+// entries each, so the number of threads is limited to keep their total size
+// below num_entries.
+template <typename Array1, typename Array2, typename Array3,
+          typename Array4, typename Array5, typename Array6>
+void coo_to_csr(const size_t num_rows, const size_t num_entries,
+                const Array1& row_indices, const Array2& column_indices, const Array3& values,
+                      Array4& row_offsets,       Array5& csr_column_indices, Array6& csr_values)
+{
+    typedef typename Array4::value_type IndexType;
+
+    if (coo_is_sorted_by_row(num_entries, row_indices))
+    {
+        #pragma omp parallel num_threads(num_threads(num_entries))
+        {
+            const size_t begin = partition_begin(num_entries, thread_num(),     team_size());
+            const size_t end   = partition_begin(num_entries, thread_num() + 1, team_size());
+
+            // rows (row_indices[n-1], row_indices[n]] start at entry n
+            for(size_t n = begin; n < end; n++)
+            {
+                const size_t first = (n == 0) ? 0 : size_t(row_indices[n - 1]) + 1;
+
+                for(size_t i = first; i <= size_t(row_indices[n]); i++)
+                    row_offsets[i] = n;
+
+                csr_column_indices[n] = column_indices[n];
+                csr_values[n]         = values[n];
+            }
+        }
+
+        // rows after the last entry are empty
+        const size_t first = (num_entries == 0) ? 0 : size_t(row_indices[num_entries - 1]) + 1;
+
+        for(size_t i = first; i <= num_rows; i++)
+            row_offsets[i] = num_entries;
+
+        return;
+    }
+
+    const size_t T = num_threads(num_entries, std::max(parallel_grain_size, num_rows));
+
+    // cursors[t][i] counts, then positions, the entries of row i in block t
+    std::vector< std::vector<IndexType> > cursors(T);
+
+    #pragma omp parallel num_threads(T)
+    {
+        const size_t tid  = thread_num();
+        const size_t size = team_size();
+
+        const size_t begin = partition_begin(num_entries, tid,     size);
+        const size_t end   = partition_begin(num_entries, tid + 1, size);
+
+        std::vector<IndexType>& cursor = cursors[tid];
+        cursor.assign(num_rows, IndexType(0));
+
+        for(size_t n = begin; n < end; n++)
+            cursor[row_indices[n]]++;
+
+        #pragma omp barrier
+
+        // position of block t within each row, and the length of each row
+        const size_t row_begin = partition_begin(num_rows, tid,     size);
+        const size_t row_end   = partition_begin(num_rows, tid + 1, size);
+
+        for(size_t i = row_begin; i < row_end; i++)
+        {
+            IndexType sum = 0;
+            for(size_t t = 0; t < size; t++)
+            {
+                IndexType count = cursors[t][i];
+                cursors[t][i] = sum;
+                sum += count;
+            }
+            row_offsets[i] = sum;
+        }
+
+        #pragma omp barrier
+
+        #pragma omp single
+        counts_to_offsets(row_offsets);
+
+        for(size_t n = begin; n < end; n++)
+        {
+            const IndexType i    = row_indices[n];
+            const IndexType dest = row_offsets[i] + cursor[i]++;
+
+            csr_column_indices[dest] = column_indices[n];
+            csr_values[dest]         = values[n];
+        }
+    }
+}
+
+// Parallel expansion of CSR row offsets into COO row indices, with the
+// column indices and values copied alongside
+template <typename Array1, typename Array2, typename Array3,
+          typename Array4, typename Array5, typename Array6>
+void csr_to_coo(const size_t num_rows,
+                const Array1& row_offsets, const Array2& column_indices, const Array3& values,
+                      Array4& row_indices,       Array5& coo_column_indices, Array6& coo_values)
+{
+    typedef typename Array1::value_type IndexType;
+
+    #pragma omp parallel num_threads(num_threads(row_offsets[num_rows]))
+    {
+        const size_t begin = weighted_partition_begin(row_offsets, thread_num(),     team_size());
+        const size_t end   = weighted_partition_begin(row_offsets, thread_num() + 1, team_size());
+
+        for(size_t i = begin; i < end; i++)
+        {
+            for(IndexType jj = row_offsets[i]; jj < row_offsets[i + 1]; jj++)
+            {
+                row_indices[jj]        = i;
+                coo_column_indices[jj] = column_indices[jj];
+                coo_values[jj]         = values[jj];
+            }
+        }
+    }
+}
+
+// Parallel expansion of CSR row offsets into row indices
+template <typename Array1, typename Array2>
+void expand_row_offsets(const size_t num_rows, const Array1& row_offsets, Array2& row_indices)
+{
+    typedef typename Array1::value_type IndexType;
+
+    #pragma omp parallel num_threads(num_threads(row_offsets[num_rows]))
+    {
+        const size_t begin = weighted_partition_begin(row_offsets, thread_num(),     team_size());
+        const size_t end   = weighted_partition_begin(row_offsets, thread_num() + 1, team_size());
+
+        for(size_t i = begin; i < end; i++)
+            for(IndexType jj = row_offsets[i]; jj < row_offsets[i + 1]; jj++)
+                row_indices[jj] = i;
+    }
+}
+
+// Parallel transpose of a matrix held in coordinate arrays.  The result is
+// written as CSR arrays for A^T with sorted column indices; entries with
+// equal coordinates keep their relative order, so the output is the same
+// for any number of threads.  When the entries of A are sorted by row the
+// transpose is the stable counting sort of coo_to_csr.  That sort needs a
+// histogram of num_cols entries per thread, so for matrices much wider
+// than they are dense (or entries not sorted by row) the transposed
+// coordinates are radix sorted instead, which scales independently of the
+// width.
+template <typename Array1, typename Array2, typename Array3,
+          typename Array4, typename Array5, typename Array6>
+void coo_transpose(const size_t num_rows, const size_t num_cols, const size_t num_entries,
+                   const Array1& row_indices,     const Array2& column_indices, const Array3& values,
+                         Array4& At_row_offsets,        Array5& At_column_indices, Array6& At_values)
+{
+    typedef typename Array4::value_type IndexType;
+    typedef typename Array6::value_type ValueType;
+
+    const bool histogram =
+        num_threads(num_entries, std::max(parallel_grain_size, num_cols)) == num_threads(num_entries) &&
+        coo_is_sorted_by_row(num_entries, row_indices);
+
+    if (!histogram)
+    {
+        cusp::array1d<IndexType,cusp::host_memory> I(column_indices.begin(), column_indices.begin() + num_entries);
+        cusp::array1d<IndexType,cusp::host_memory> J(row_indices.begin(),    row_indices.begin()    + num_entries);
+        cusp::array1d<ValueType,cusp::host_memory> V(values.begin(),         values.begin()         + num_entries);
+
+        if (cusp::detail::host::radix_sort_by_row_and_column(I, J, V))
+        {
+            // the coordinates are sorted, so this only places them
+            coo_to_csr(num_cols, num_entries, I, J, V, At_row_offsets, At_column_indices, At_values);
+            return;
+        }
+    }
+
+    coo_to_csr(num_cols, num_entries, column_indices, row_indices, values,
+               At_row_offsets, At_column_indices, At_values);
+}
+
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3,
+          typename BinaryFunction>
+void coo_transform_elementwise(const Matrix1& A,
+                               const Matrix2& B,
+                                     Matrix3& C,
+                                     BinaryFunction op)
+{
+    typedef typename Matrix3::index_type IndexType;
+    typedef typename Matrix3::value_type ValueType;
+
+    // compute row offsets for A and B
+    cusp::array1d<typename Matrix1::index_type,cusp::host_memory> A_row_offsets(A.num_rows + 1);
+    cusp::array1d<typename Matrix2::index_type,cusp::host_memory> B_row_offsets(B.num_rows + 1);
+
+    cusp::detail::indices_to_offsets(A.row_indices, A_row_offsets);
+    cusp::detail::indices_to_offsets(B.row_indices, B_row_offsets);
+
+    // C may alias A or B, so the result is formed in temporaries
+    cusp::array1d<IndexType,cusp::host_memory> C_row_offsets;
+    cusp::array1d<IndexType,cusp::host_memory> C_column_indices;
+    cusp::array1d<ValueType,cusp::host_memory> C_values;
+
+    size_t num_nonzeros =
+        csr_transform_elementwise(A.num_rows, A.num_cols,
+                                  A_row_offsets, A.column_indices, A.values,
+                                  B_row_offsets, B.column_indices, B.values,
+                                  C_row_offsets, C_column_indices, C_values,
+                                  op);
+
+    assign_array(C_column_indices, C.column_indices);
+    assign_array(C_values,         C.values);
+
+    C.resize(A.num_rows, A.num_cols, num_nonzeros);
+
+    cusp::detail::offsets_to_indices(C_row_offsets, C.row_indices);
+}
+
 template <typename Matrix1,
           typename Matrix2,
           typename Matrix3>
@@ -47,23 +291,118 @@ void spmm_coo(const Matrix1& A,
     cusp::detail::indices_to_offsets(B.row_indices, B_row_offsets);
     
     typedef typename Matrix3::index_type IndexType;
-    
-    IndexType estimated_nonzeros = 
-        spmm_csr_pass1(A.num_rows, B.num_cols,
-                       A_row_offsets, A.column_indices,
-                       B_row_offsets, B.column_indices);
-                         
-    // Resize output
-    C.resize(A.num_rows, B.num_cols, estimated_nonzeros);
-    
-    IndexType true_nonzeros =
-        spmm_csr_pass2(A.num_rows, B.num_cols,
-                       A_row_offsets, A.column_indices, A.values,
-                       B_row_offsets, B.column_indices, B.values,
-                       C_row_offsets, C.column_indices, C.values);
-
-    // true_nonzeros may be less than estimated_nonzeros
-    C.resize(A.num_rows, B.num_cols, true_nonzeros);
+    typedef typename Matrix3::value_type ValueType;
+
+    cusp::array1d<IndexType,cusp::host_memory> C_column_indices;
+    cusp::array1d<ValueType,cusp::host_memory> C_values;
+
+    size_t num_nonzeros =
+        spmm_csr(A.num_rows, B.num_cols,
+                 A_row_offsets, A.column_indices, A.values,
+                 B_row_offsets, B.column_indices, B.values,
+                 C_row_offsets, C_column_indices, C_values);
+
+    assign_array(C_column_indices, C.column_indices);
+    assign_array(C_values,         C.values);
+
+    C.resize(A.num_rows, B.num_cols, num_nonzeros);
+
+    cusp::detail::offsets_to_indices(C_row_offsets, C.row_indices);
+}
+
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3>
+void spmm_coo_symbolic(const Matrix1& A,
+                       const Matrix2& B,
+                             Matrix3& C)
+{
+    typedef typename Matrix3::index_type IndexType;
+    typedef typename Matrix3::value_type ValueType;
+
+    cusp::array1d<typename Matrix1::index_type,cusp::host_memory> A_row_offsets(A.num_rows + 1);
+    cusp::array1d<typename Matrix2::index_type,cusp::host_memory> B_row_offsets(B.num_rows + 1);
+    cusp::array1d<IndexType,cusp::host_memory>                    C_row_offsets(A.num_rows + 1);
+
+    cusp::detail::indices_to_offsets(A.row_indices, A_row_offsets);
+    cusp::detail::indices_to_offsets(B.row_indices, B_row_offsets);
+
+    cusp::array1d<IndexType,cusp::host_memory> C_column_indices;
+
+    size_t num_nonzeros =
+        spmm_csr_symbolic(A.num_rows, B.num_cols,
+                          A_row_offsets, A.column_indices,
+                          B_row_offsets, B.column_indices,
+                          C_row_offsets, C_column_indices);
+
+    assign_array(C_column_indices, C.column_indices);
+
+    C.resize(A.num_rows, B.num_cols, num_nonzeros);
+
+    cusp::detail::offsets_to_indices(C_row_offsets, C.row_indices);
+
+    thrust::fill(C.values.begin(), C.values.end(), ValueType(0));
+}
+
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3>
+void spmm_coo_numeric(const Matrix1& A,
+                      const Matrix2& B,
+                            Matrix3& C)
+{
+    if (C.num_rows != A.num_rows || C.num_cols != B.num_cols || A.num_cols != B.num_rows)
+        throw cusp::invalid_input_exception("matrix dimensions do not match");
+
+    cusp::array1d<typename Matrix1::index_type,cusp::host_memory> A_row_offsets(A.num_rows + 1);
+    cusp::array1d<typename Matrix2::index_type,cusp::host_memory> B_row_offsets(B.num_rows + 1);
+    cusp::array1d<typename Matrix3::index_type,cusp::host_memory> C_row_offsets(C.num_rows + 1);
+
+    cusp::detail::indices_to_offsets(A.row_indices, A_row_offsets);
+    cusp::detail::indices_to_offsets(B.row_indices, B_row_offsets);
+    cusp::detail::indices_to_offsets(C.row_indices, C_row_offsets);
+
+    spmm_csr_numeric(A.num_rows, B.num_cols,
+                     A_row_offsets, A.column_indices, A.values,
+                     B_row_offsets, B.column_indices, B.values,
+                     C_row_offsets, C.column_indices, C.values);
+}
+
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3,
+          typename Matrix4>
+void spmm_coo_masked(const Matrix1& A,
+                     const Matrix2& B,
+                     const Matrix3& M,
+                           Matrix4& C)
+{
+    typedef typename Matrix4::index_type IndexType;
+    typedef typename Matrix4::value_type ValueType;
+
+    cusp::array1d<typename Matrix1::index_type,cusp::host_memory> A_row_offsets(A.num_rows + 1);
+    cusp::array1d<typename Matrix2::index_type,cusp::host_memory> B_row_offsets(B.num_rows + 1);
+    cusp::array1d<typename Matrix3::index_type,cusp::host_memory> M_row_offsets(M.num_rows + 1);
+
+    cusp::detail::indices_to_offsets(A.row_indices, A_row_offsets);
+    cusp::detail::indices_to_offsets(B.row_indices, B_row_offsets);
+    cusp::detail::indices_to_offsets(M.row_indices, M_row_offsets);
+
+    cusp::array1d<IndexType,cusp::host_memory> C_row_offsets;
+    cusp::array1d<IndexType,cusp::host_memory> C_column_indices;
+    cusp::array1d<ValueType,cusp::host_memory> C_values;
+
+    size_t num_nonzeros =
+        spmm_csr_masked(A.num_rows, B.num_cols,
+                        A_row_offsets, A.column_indices, A.values,
+                        B_row_offsets, B.column_indices, B.values,
+                        M_row_offsets, M.column_indices,
+                        C_row_offsets, C_column_indices, C_values);
+
+    assign_array(C_column_indices, C.column_indices);
+    assign_array(C_values,         C.values);
+
+    C.resize(A.num_rows, B.num_cols, num_nonzeros);
 
     cusp::detail::offsets_to_indices(C_row_offsets, C.row_indices);
 }
@@ -17,6 +17,17 @@
 #pragma once
 
 #include <cusp/array1d.h>
+#include <cusp/exception.h>
+
+#include <cusp/detail/host/parallel.h>
+#include <cusp/detail/host/detail/accumulator.h>
+
+#include <thrust/copy.h>
+#include <thrust/fill.h>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
 
 namespace cusp
 {
@@ -27,6 +38,515 @@ namespace host
 namespace detail
 {
 
+// transfer the contents of a temporary host array into dst
+template <typename Array1, typename Array2>
+void assign_array(Array1& src, Array2& dst)
+{
+    dst.resize(src.size());
+    thrust::copy(src.begin(), src.end(), dst.begin());
+}
+
+template <typename T>
+void assign_array(cusp::array1d<T,cusp::host_memory>& src,
+                  cusp::array1d<T,cusp::host_memory>& dst)
+{
+    dst.swap(src);
+}
+
+// true if the column indices of every row are strictly increasing
+template <typename Array1, typename Array2>
+bool csr_has_sorted_rows(const size_t num_rows,
+                         const Array1& row_offsets,
+                         const Array2& column_indices)
+{
+    typedef typename Array1::value_type IndexType;
+
+    bool sorted = true;
+
+    #pragma omp parallel num_threads(num_threads(num_rows)) reduction(&& : sorted)
+    {
+        const size_t begin = partition_begin(num_rows, thread_num(),     team_size());
+        const size_t end   = partition_begin(num_rows, thread_num() + 1, team_size());
+
+        for(size_t i = begin; sorted && i < end; i++)
+            for(IndexType jj = row_offsets[i] + 1; jj < row_offsets[i + 1]; jj++)
+                if (!(column_indices[jj - 1] < column_indices[jj]))
+                {
+                    sorted = false;
+                    break;
+                }
+    }
+
+    return sorted;
+}
+
+// orders (column, value) pairs by column alone
+template <typename IndexType, typename ValueType>
+struct column_less
+{
+    bool operator()(const std::pair<IndexType,ValueType>& a,
+                    const std::pair<IndexType,ValueType>& b) const
+    {
+        return a.first < b.first;
+    }
+};
+
+// Stable sort of the entries [begin,end) of a row by column index
+template <typename Array1, typename Array2, typename IndexType, typename ValueType>
+void csr_sort_row(const IndexType begin, const IndexType end,
+                  Array1& column_indices, Array2& values,
+                  std::vector< std::pair<IndexType,ValueType> >& entries)
+{
+    IndexType jj = begin + 1;
+    while (jj < end && !(column_indices[jj] < column_indices[jj - 1]))
+        jj++;
+
+    if (jj >= end)
+        return;
+
+    entries.resize(end - begin);
+
+    for(IndexType n = begin; n < end; n++)
+        entries[n - begin] = std::make_pair(IndexType(column_indices[n]), ValueType(values[n]));
+
+    std::stable_sort(entries.begin(), entries.end(), column_less<IndexType,ValueType>());
+
+    for(IndexType n = begin; n < end; n++)
+    {
+        column_indices[n] = entries[n - begin].first;
+        values[n]         = entries[n - begin].second;
+    }
+}
+
+// Combine the entries [begin,end) of a row that have equal column indices,
+// which are adjacent in a sorted row.  Returns the new length of the row.
+template <typename Array1, typename Array2, typename IndexType>
+IndexType csr_sum_sorted_row(const IndexType begin, const IndexType end,
+                             Array1& column_indices, Array2& values)
+{
+    IndexType last = begin;
+
+    for(IndexType jj = begin + 1; jj < end; jj++)
+    {
+        if (column_indices[jj] == column_indices[last])
+        {
+            values[last] += values[jj];
+        }
+        else
+        {
+            last++;
+            column_indices[last] = column_indices[jj];
+            values[last]         = values[jj];
+        }
+    }
+
+    return (begin < end) ? last + 1 - begin : 0;
+}
+
+// Combine the entries [begin,end) of an unsorted row that have equal column
+// indices with the given accumulator.  Each column keeps the position of its
+// first occurrence.  Returns the new length of the row.
+template <typename Array1, typename Array2, typename IndexType,
+          typename Accumulator, typename ValueType>
+IndexType csr_sum_row(const IndexType begin, const IndexType end,
+                      Array1& column_indices, Array2& values,
+                      Accumulator& accumulator,
+                      std::vector<ValueType>& sums)
+{
+    sums.resize(end - begin);
+
+    for(IndexType jj = begin; jj < end; jj++)
+    {
+        const size_t    length = accumulator.size();
+        const IndexType slot   = accumulator.insert(column_indices[jj]);
+
+        if (size_t(slot) == length)
+            sums[slot]  = values[jj];
+        else
+            sums[slot] += values[jj];
+    }
+
+    const IndexType length = accumulator.size();
+
+    for(IndexType slot = 0; slot < length; slot++)
+    {
+        column_indices[begin + slot] = accumulator.key(slot);
+        values[begin + slot]         = sums[slot];
+    }
+
+    accumulator.clear();
+
+    return length;
+}
+
+// Put CSR arrays into canonical form in parallel.  When sort_columns is set
+// the entries of each row are sorted by column index (stably, so duplicates
+// keep their relative order).  When sum_duplicates is set entries with equal
+// column indices are combined into one and the arrays are compacted.  With
+// both set the result satisfies csr_has_canonical_format.  Returns the
+// number of entries.
+template <typename Array1, typename Array2, typename Array3>
+size_t csr_canonicalize(const size_t num_rows, const size_t num_cols,
+                        Array1& row_offsets, Array2& column_indices, Array3& values,
+                        const bool sort_columns, const bool sum_duplicates)
+{
+    typedef typename Array1::value_type IndexType;
+    typedef typename Array3::value_type ValueType;
+
+    const size_t num_entries = row_offsets[num_rows];
+
+    if (!sort_columns && !sum_duplicates)
+        return num_entries;
+
+    // number of entries left in each row
+    cusp::array1d<IndexType,cusp::host_memory> row_lengths(num_rows + 1);
+
+    bool compact = false;
+
+    #pragma omp parallel num_threads(num_threads(num_entries)) reduction(|| : compact)
+    {
+        const size_t begin = weighted_partition_begin(row_offsets, thread_num(),     team_size());
+        const size_t end   = weighted_partition_begin(row_offsets, thread_num() + 1, team_size());
+
+        std::vector< std::pair<IndexType,ValueType> > entries;
+        std::vector<ValueType> sums;
+
+        dense_accumulator<IndexType> dense;
+        hash_accumulator<IndexType>  hash;
+
+        for(size_t i = begin; i < end; i++)
+        {
+            const IndexType row_begin = row_offsets[i];
+            const IndexType row_end   = row_offsets[i + 1];
+
+            IndexType length = row_end - row_begin;
+
+            if (sort_columns)
+                csr_sort_row(row_begin, row_end, column_indices, values, entries);
+
+            if (sum_duplicates && sort_columns)
+            {
+                length = csr_sum_sorted_row(row_begin, row_end, column_indices, values);
+            }
+            else if (sum_duplicates)
+            {
+                if (use_hash_accumulator(length, num_cols))
+                {
+                    hash.reserve(length);
+                    length = csr_sum_row(row_begin, row_end, column_indices, values, hash, sums);
+                }
+                else
+                {
+                    if (dense.empty())
+                        dense.resize(num_cols);
+                    length = csr_sum_row(row_begin, row_end, column_indices, values, dense, sums);
+                }
+            }
+
+            row_lengths[i] = length;
+
+            if (length != row_end - row_begin)
+                compact = true;
+        }
+    }
+
+    if (!compact)
+        return num_entries;
+
+    // move the remaining entries of each row into place
+    const size_t num_nonzeros = counts_to_offsets(row_lengths);
+
+    cusp::array1d<IndexType,cusp::host_memory> new_column_indices(num_nonzeros);
+    cusp::array1d<ValueType,cusp::host_memory> new_values(num_nonzeros);
+
+    #pragma omp parallel num_threads(num_threads(num_entries))
+    {
+        const size_t begin = weighted_partition_begin(row_offsets, thread_num(),     team_size());
+        const size_t end   = weighted_partition_begin(row_offsets, thread_num() + 1, team_size());
+
+        for(size_t i = begin; i < end; i++)
+        {
+            const IndexType length = row_lengths[i + 1] - row_lengths[i];
+
+            std::copy(column_indices.begin() + row_offsets[i], column_indices.begin() + row_offsets[i] + length,
+                      new_column_indices.begin() + row_lengths[i]);
+            std::copy(values.begin() + row_offsets[i], values.begin() + row_offsets[i] + length,
+                      new_values.begin() + row_lengths[i]);
+        }
+    }
+
+    thrust::copy(row_lengths.begin(), row_lengths.end(), row_offsets.begin());
+    assign_array(new_column_indices, column_indices);
+    assign_array(new_values,         values);
+
+    return num_nonzeros;
+}
+
+// Row i of op(A,B) for rows with strictly increasing column indices, formed
+// by a linear merge.  Nonzero results are written starting at position
+// offset of C when write is set.  Returns the number of nonzero results.
+template <typename Array1, typename Array2, typename Array3,
+          typename Array4, typename Array5, typename Array6,
+          typename Array7, typename Array8,
+          typename BinaryFunction>
+size_t csr_transform_elementwise_row_merge(const size_t i,
+                                           const Array1& A_row_offsets, const Array2& A_column_indices, const Array3& A_values,
+                                           const Array4& B_row_offsets, const Array5& B_column_indices, const Array6& B_values,
+                                                 Array7& C_column_indices, Array8& C_values,
+                                           const size_t offset,
+                                           const bool write,
+                                                 BinaryFunction op)
+{
+    typedef typename Array1::value_type IndexType1;
+    typedef typename Array4::value_type IndexType2;
+    typedef typename Array8::value_type ValueType;
+
+    IndexType1 A_pos = A_row_offsets[i];
+    IndexType1 A_end = A_row_offsets[i + 1];
+    IndexType2 B_pos = B_row_offsets[i];
+    IndexType2 B_end = B_row_offsets[i + 1];
+
+    size_t nnz = 0;
+
+    while (A_pos < A_end || B_pos < B_end)
+    {
+        // column of the next entry and its values in A and B
+        IndexType1 j;
+        ValueType  a = 0;
+        ValueType  b = 0;
+
+        if (B_pos == B_end || (A_pos < A_end && A_column_indices[A_pos] < B_column_indices[B_pos]))
+        {
+            j = A_column_indices[A_pos];
+            a = A_values[A_pos++];
+        }
+        else if (A_pos == A_end || B_column_indices[B_pos] < A_column_indices[A_pos])
+        {
+            j = B_column_indices[B_pos];
+            b = B_values[B_pos++];
+        }
+        else
+        {
+            j = A_column_indices[A_pos];
+            a = A_values[A_pos++];
+            b = B_values[B_pos++];
+        }
+
+        ValueType result = op(a, b);
+
+        if (result != ValueType(0))
+        {
+            if (write)
+            {
+                C_column_indices[offset + nnz] = j;
+                C_values[offset + nnz]         = result;
+            }
+            nnz++;
+        }
+    }
+
+    return nnz;
+}
+
+// Row i of op(A,B) for rows with duplicate and/or unsorted column indices,
+// formed with the given accumulator.  Otherwise as above.
+template <typename Array1, typename Array2, typename Array3,
+          typename Array4, typename Array5, typename Array6,
+          typename Array7, typename Array8,
+          typename BinaryFunction, typename Accumulator,
+          typename ValueType>
+size_t csr_transform_elementwise_row(const size_t i,
+                                     const Array1& A_row_offsets, const Array2& A_column_indices, const Array3& A_values,
+                                     const Array4& B_row_offsets, const Array5& B_column_indices, const Array6& B_values,
+                                           Array7& C_column_indices, Array8& C_values,
+                                     const size_t offset,
+                                     const bool write,
+                                           BinaryFunction op,
+                                           Accumulator& accumulator,
+                                           std::vector<ValueType>& A_row,
+                                           std::vector<ValueType>& B_row)
+{
+    typedef typename Array1::value_type IndexType1;
+    typedef typename Array4::value_type IndexType2;
+
+    size_t bound = (A_row_offsets[i + 1] - A_row_offsets[i]) +
+                   (B_row_offsets[i + 1] - B_row_offsets[i]);
+
+    if (A_row.size() < bound)
+    {
+        A_row.resize(bound, ValueType(0));
+        B_row.resize(bound, ValueType(0));
+    }
+
+    //add a row of A to A_row
+    for(IndexType1 jj = A_row_offsets[i]; jj < A_row_offsets[i + 1]; jj++)
+        A_row[accumulator.insert(A_column_indices[jj])] += A_values[jj];
+
+    //add a row of B to B_row
+    for(IndexType2 jj = B_row_offsets[i]; jj < B_row_offsets[i + 1]; jj++)
+        B_row[accumulator.insert(B_column_indices[jj])] += B_values[jj];
+
+    size_t nnz = 0;
+
+    // scan through columns where A or B has 
+    // contributed a non-zero entry
+    for(size_t slot = 0; slot < accumulator.size(); slot++)
+    {
+        ValueType result = op(A_row[slot], B_row[slot]);
+
+        if(result != ValueType(0))
+        {
+            if (write)
+            {
+                C_column_indices[offset + nnz] = accumulator.key(slot);
+                C_values[offset + nnz]         = result;
+            }
+            nnz++;
+        }
+
+        A_row[slot] = 0;
+        B_row[slot] = 0;
+    }
+
+    accumulator.clear();
+
+    return nnz;
+}
+
+// Process the rows [begin,end) of op(A,B).  When write is false the number
+// of nonzero results of each row is stored in C_row_offsets[i]; otherwise
+// row i is written starting at C_row_offsets[i].
+template <typename Array1, typename Array2, typename Array3,
+          typename Array4, typename Array5, typename Array6,
+          typename Array7, typename Array8, typename Array9,
+          typename BinaryFunction>
+void csr_transform_elementwise_rows(const size_t begin, const size_t end, const size_t num_cols,
+                                    const Array1& A_row_offsets, const Array2& A_column_indices, const Array3& A_values,
+                                    const Array4& B_row_offsets, const Array5& B_column_indices, const Array6& B_values,
+                                          Array7& C_row_offsets, Array8& C_column_indices, Array9& C_values,
+                                    const bool sorted,
+                                    const bool write,
+                                          BinaryFunction op)
+{
+    typedef typename Array7::value_type IndexType;
+    typedef typename Array9::value_type ValueType;
+
+    if (sorted)
+    {
+        for(size_t i = begin; i < end; i++)
+        {
+            size_t nnz = csr_transform_elementwise_row_merge(i,
+                                                             A_row_offsets, A_column_indices, A_values,
+                                                             B_row_offsets, B_column_indices, B_values,
+                                                             C_column_indices, C_values,
+                                                             write ? size_t(C_row_offsets[i]) : 0, write, op);
+            if (!write)
+                C_row_offsets[i] = nnz;
+        }
+
+        return;
+    }
+
+    dense_accumulator<IndexType> dense;
+    hash_accumulator<IndexType>  hash;
+
+    std::vector<ValueType> A_row;
+    std::vector<ValueType> B_row;
+
+    for(size_t i = begin; i < end; i++)
+    {
+        size_t bound  = (A_row_offsets[i + 1] - A_row_offsets[i]) +
+                        (B_row_offsets[i + 1] - B_row_offsets[i]);
+        size_t offset = write ? size_t(C_row_offsets[i]) : 0;
+        size_t nnz    = 0;
+
+        if (use_hash_accumulator(bound, num_cols))
+        {
+            hash.reserve(bound);
+            nnz = csr_transform_elementwise_row(i,
+                                                A_row_offsets, A_column_indices, A_values,
+                                                B_row_offsets, B_column_indices, B_values,
+                                                C_column_indices, C_values,
+                                                offset, write, op, hash, A_row, B_row);
+        }
+        else
+        {
+            if (dense.empty())
+                dense.resize(num_cols);
+            nnz = csr_transform_elementwise_row(i,
+                                                A_row_offsets, A_column_indices, A_values,
+                                                B_row_offsets, B_column_indices, B_values,
+                                                C_column_indices, C_values,
+                                                offset, write, op, dense, A_row, B_row);
+        }
+
+        if (!write)
+            C_row_offsets[i] = nnz;
+    }
+}
+
+// Two-pass elementwise operation C = op(A,B) on CSR arrays.  The first pass
+// counts the nonzero results of each row and the second writes them into
+// exactly sized output arrays.  Rows are merged linearly when both inputs
+// have sorted, duplicate-free rows (the output is then sorted as well) and
+// formed with accumulators otherwise.  Returns nnz(C).
+template <typename Array1, typename Array2, typename Array3,
+          typename Array4, typename Array5, typename Array6,
+          typename Array7, typename Array8, typename Array9,
+          typename BinaryFunction>
+size_t csr_transform_elementwise(const size_t num_rows, const size_t num_cols,
+                                 const Array1& A_row_offsets, const Array2& A_column_indices, const Array3& A_values,
+                                 const Array4& B_row_offsets, const Array5& B_column_indices, const Array6& B_values,
+                                       Array7& C_row_offsets, Array8& C_column_indices, Array9& C_values,
+                                       BinaryFunction op)
+{
+    const bool sorted = csr_has_sorted_rows(num_rows, A_row_offsets, A_column_indices) &&
+                        csr_has_sorted_rows(num_rows, B_row_offsets, B_column_indices);
+
+    // rows are balanced by the number of input entries
+    cusp::array1d<size_t,cusp::host_memory> work(num_rows + 1);
+
+    #pragma omp parallel for num_threads(num_threads(num_rows))
+    for(long i = 0; i < long(num_rows + 1); i++)
+        work[i] = size_t(A_row_offsets[i] - A_row_offsets[0]) + size_t(B_row_offsets[i] - B_row_offsets[0]);
+
+    C_row_offsets.resize(num_rows + 1);
+
+    size_t num_nonzeros = 0;
+
+    #pragma omp parallel num_threads(num_threads(work[num_rows]))
+    {
+        const size_t begin = weighted_partition_begin(work, thread_num(),     team_size());
+        const size_t end   = weighted_partition_begin(work, thread_num() + 1, team_size());
+
+        // pass 1: count nonzero results in each row
+        csr_transform_elementwise_rows(begin, end, num_cols,
+                                       A_row_offsets, A_column_indices, A_values,
+                                       B_row_offsets, B_column_indices, B_values,
+                                       C_row_offsets, C_column_indices, C_values,
+                                       sorted, false, op);
+
+        #pragma omp barrier
+
+        #pragma omp single
+        {
+            num_nonzeros = counts_to_offsets(C_row_offsets);
+
+            C_column_indices.resize(num_nonzeros);
+            C_values.resize(num_nonzeros);
+        }
+
+        // pass 2: write the results
+        csr_transform_elementwise_rows(begin, end, num_cols,
+                                       A_row_offsets, A_column_indices, A_values,
+                                       B_row_offsets, B_column_indices, B_values,
+                                       C_row_offsets, C_column_indices, C_values,
+                                       sorted, true, op);
+    }
+
+    return num_nonzeros;
+}
+
 template <typename Matrix1,
           typename Matrix2,
           typename Matrix3,
@@ -41,103 +561,484 @@ void csr_transform_elementwise(const Matrix1& A,
     typedef typename Matrix3::index_type IndexType;
     typedef typename Matrix3::value_type ValueType;
 
-    cusp::array1d<IndexType,cusp::host_memory>  next(A.num_cols, IndexType(-1));
-    cusp::array1d<ValueType,cusp::host_memory> A_row(A.num_cols, ValueType(0));
-    cusp::array1d<ValueType,cusp::host_memory> B_row(A.num_cols, ValueType(0));
-   
-    cusp::csr_matrix<IndexType,ValueType,cusp::host_memory> temp(A.num_rows, A.num_cols, A.num_entries + B.num_entries);
+    // C may alias A or B, so the result is formed in temporaries
+    cusp::array1d<IndexType,cusp::host_memory> C_row_offsets;
+    cusp::array1d<IndexType,cusp::host_memory> C_column_indices;
+    cusp::array1d<ValueType,cusp::host_memory> C_values;
 
-    size_t nnz = 0;
+    size_t num_nonzeros =
+        csr_transform_elementwise(A.num_rows, A.num_cols,
+                                  A.row_offsets, A.column_indices, A.values,
+                                  B.row_offsets, B.column_indices, B.values,
+                                  C_row_offsets, C_column_indices, C_values,
+                                  op);
 
-    temp.row_offsets[0] = 0;
-    
-    for(size_t i = 0; i < A.num_rows; i++)
+    // transfer the result into C without copying when possible
+    assign_array(C_row_offsets,    C.row_offsets);
+    assign_array(C_column_indices, C.column_indices);
+    assign_array(C_values,         C.values);
+
+    C.resize(A.num_rows, A.num_cols, num_nonzeros);
+} // csr_transform_elementwise
+
+
+// Upper bound on the work (multiply-adds) needed to form each row of
+// C = A * B.  Stored as cumulative offsets so that rows can be split into
+// blocks of equal work.
+template <typename Array1, typename Array2, typename Array3, typename Array4>
+void spmm_csr_row_work(const size_t num_rows,
+                       const Array1& A_row_offsets, const Array2& A_column_indices,
+                       const Array3& B_row_offsets,
+                             Array4& work)
+{
+    typedef typename Array1::value_type IndexType;
+    typedef typename Array4::value_type OffsetType;
+
+    work.resize(num_rows + 1);
+
+    #pragma omp parallel num_threads(num_threads(num_rows))
     {
-        IndexType head   = -2;
-        IndexType length =  0;
-    
-        //add a row of A to A_row
-        IndexType i_start = A.row_offsets[i];
-        IndexType i_end   = A.row_offsets[i + 1];
-        for(IndexType jj = i_start; jj < i_end; jj++)
+        const size_t begin = partition_begin(num_rows, thread_num(),     team_size());
+        const size_t end   = partition_begin(num_rows, thread_num() + 1, team_size());
+
+        for(size_t i = begin; i < end; i++)
         {
-            IndexType j = A.column_indices[jj];
-    
-            A_row[j] += A.values[jj];
-    
-            if(next[j] == -1) { next[j] = head; head = j; length++; }
+            OffsetType sum = 0;
+
+            for(IndexType jj = A_row_offsets[i]; jj < A_row_offsets[i+1]; jj++)
+            {
+                IndexType j = A_column_indices[jj];
+                sum += B_row_offsets[j+1] - B_row_offsets[j];
+            }
+
+            work[i] = sum;
         }
-    
-        //add a row of B to B_row
-        i_start = B.row_offsets[i];
-        i_end   = B.row_offsets[i + 1];
-        for(IndexType jj = i_start; jj < i_end; jj++)
+    }
+
+    counts_to_offsets(work);
+}
+
+// Number of distinct columns in row i of A * B
+template <typename Array1, typename Array2,
+          typename Array3, typename Array4,
+          typename Accumulator>
+size_t spmm_csr_row_count(const size_t i,
+                          const Array1& A_row_offsets, const Array2& A_column_indices,
+                          const Array3& B_row_offsets, const Array4& B_column_indices,
+                                Accumulator& accumulator)
+{
+    typedef typename Array1::value_type IndexType1;
+    typedef typename Array3::value_type IndexType2;
+
+    for(IndexType1 jj = A_row_offsets[i]; jj < A_row_offsets[i+1]; jj++)
+    {
+        IndexType1 j = A_column_indices[jj];
+
+        for(IndexType2 kk = B_row_offsets[j]; kk < B_row_offsets[j+1]; kk++)
+            accumulator.insert(B_column_indices[kk]);
+    }
+
+    size_t num_nonzeros = accumulator.size();
+
+    accumulator.clear();
+
+    return num_nonzeros;
+}
+
+// Compute the number of entries in each row of C (including explicit zeros)
+// and store the result in C_row_offsets as offsets.  Returns nnz(C).
+template <typename Array1, typename Array2,
+          typename Array3, typename Array4,
+          typename Array5, typename Array6>
+size_t spmm_csr_pass1(const size_t num_rows, const size_t num_cols,
+                      const Array1& A_row_offsets, const Array2& A_column_indices,
+                      const Array3& B_row_offsets, const Array4& B_column_indices,
+                      const Array5& work,
+                            Array6& C_row_offsets)
+{
+    typedef typename Array6::value_type IndexType;
+
+    C_row_offsets.resize(num_rows + 1);
+
+    #pragma omp parallel num_threads(num_threads(work[num_rows]))
+    {
+        const size_t begin = weighted_partition_begin(work, thread_num(),     team_size());
+        const size_t end   = weighted_partition_begin(work, thread_num() + 1, team_size());
+
+        // each thread owns private accumulators
+        dense_accumulator<IndexType> dense;
+        hash_accumulator<IndexType>  hash;
+
+        for(size_t i = begin; i < end; i++)
         {
-            IndexType j = B.column_indices[jj];
-    
-            B_row[j] += B.values[jj];
-    
-            if(next[j] == -1) { next[j] = head; head = j; length++;  }
+            size_t bound = work[i+1] - work[i];
+
+            if (use_hash_accumulator(bound, num_cols))
+            {
+                hash.reserve(bound);
+                C_row_offsets[i] = spmm_csr_row_count(i, A_row_offsets, A_column_indices,
+                                                         B_row_offsets, B_column_indices, hash);
+            }
+            else
+            {
+                if (dense.empty())
+                    dense.resize(num_cols);
+                C_row_offsets[i] = spmm_csr_row_count(i, A_row_offsets, A_column_indices,
+                                                         B_row_offsets, B_column_indices, dense);
+            }
         }
-   
-        // scan through columns where A or B has 
-        // contributed a non-zero entry
-        for(IndexType jj = 0; jj < length; jj++)
+    }
+
+    return counts_to_offsets(C_row_offsets);
+}
+
+// Compute row i of A * B with the given accumulator and write its nonzero
+// entries starting at C_row_offsets[i].  Returns the number of entries written.
+template <typename Array1, typename Array2, typename Array3,
+          typename Array4, typename Array5, typename Array6,
+          typename Array7, typename Array8, typename Array9,
+          typename Accumulator, typename IndexType, typename ValueType>
+size_t spmm_csr_row(const size_t i,
+                    const Array1& A_row_offsets, const Array2& A_column_indices, const Array3& A_values,
+                    const Array4& B_row_offsets, const Array5& B_column_indices, const Array6& B_values,
+                    const Array7& C_row_offsets,       Array8& C_column_indices,       Array9& C_values,
+                          Accumulator& accumulator,
+                          std::vector<ValueType>& sums,
+                          std::vector<IndexType>& columns,
+                    const bool sort_columns)
+{
+    typedef typename Array1::value_type IndexType1;
+    typedef typename Array4::value_type IndexType2;
+
+    const size_t length = C_row_offsets[i+1] - C_row_offsets[i];
+
+    if (sums.size() < length)
+        sums.resize(length, ValueType(0));
+
+    for(IndexType1 jj = A_row_offsets[i]; jj < A_row_offsets[i+1]; jj++)
+    {
+        IndexType1 j = A_column_indices[jj];
+        ValueType  v = A_values[jj];
+
+        for(IndexType2 kk = B_row_offsets[j]; kk < B_row_offsets[j+1]; kk++)
+            sums[accumulator.insert(B_column_indices[kk])] += v * B_values[kk];
+    }
+
+    IndexType offset = C_row_offsets[i];
+    IndexType nnz    = 0;
+
+    if (sort_columns)
+    {
+        columns.resize(length);
+
+        for(size_t slot = 0; slot < length; slot++)
+            columns[slot] = accumulator.key(slot);
+
+        std::sort(columns.begin(), columns.end());
+
+        for(size_t n = 0; n < length; n++)
+        {
+            IndexType slot = accumulator.find(columns[n]);
+
+            if(sums[slot] != ValueType(0))
+            {
+                C_column_indices[offset + nnz] = columns[n];
+                C_values[offset + nnz]         = sums[slot];
+                nnz++;
+            }
+        }
+    }
+    else
+    {
+        for(size_t slot = 0; slot < length; slot++)
         {
-            ValueType result = op(A_row[head], B_row[head]);
-    
-            if(result != 0)
+            if(sums[slot] != ValueType(0))
             {
-                temp.column_indices[nnz] = head;
-                temp.values[nnz]         = result;
+                C_column_indices[offset + nnz] = accumulator.key(slot);
+                C_values[offset + nnz]         = sums[slot];
                 nnz++;
             }
-    
-            IndexType prev = head;  head = next[head];  next[prev]  = -1;
+        }
+    }
+
+    // clear accumulator
+    for(size_t slot = 0; slot < length; slot++)
+        sums[slot] = ValueType(0);
+
+    accumulator.clear();
+
+    return nnz;
+}
+
+// Compute the entries of C.  Row i is written starting at C_row_offsets[i],
+// and the number of nonzero entries actually produced for row i (explicit
+// zeros are dropped) is stored in C_row_lengths[i].  Returns nnz(C).
+template <typename Array1, typename Array2, typename Array3,
+          typename Array4, typename Array5, typename Array6,
+          typename Array7, typename Array8, typename Array9,
+          typename Array10>
+size_t spmm_csr_pass2(const size_t num_rows, const size_t num_cols,
+                      const Array1& A_row_offsets, const Array2& A_column_indices, const Array3& A_values,
+                      const Array4& B_row_offsets, const Array5& B_column_indices, const Array6& B_values,
+                      const Array7& C_row_offsets,       Array8& C_column_indices,       Array9& C_values,
+                            Array10& C_row_lengths,
+                      const bool sort_columns)
+{
+    typedef typename Array7::value_type IndexType;
+    typedef typename Array9::value_type ValueType;
+
+    C_row_lengths.resize(num_rows + 1);
+
+    size_t num_nonzeros = 0;
+
+    #pragma omp parallel num_threads(num_threads(C_row_offsets[num_rows])) reduction(+ : num_nonzeros)
+    {
+        const size_t begin = weighted_partition_begin(C_row_offsets, thread_num(),     team_size());
+        const size_t end   = weighted_partition_begin(C_row_offsets, thread_num() + 1, team_size());
+
+        // each thread owns private accumulators
+        dense_accumulator<IndexType> dense;
+        hash_accumulator<IndexType>  hash;
+
+        std::vector<ValueType> sums;
+        std::vector<IndexType> columns;
+
+        for(size_t i = begin; i < end; i++)
+        {
+            // pass1 computed the exact number of distinct columns in row i
+            size_t bound = C_row_offsets[i+1] - C_row_offsets[i];
+            size_t nnz   = 0;
+
+            if (use_hash_accumulator(bound, num_cols))
+            {
+                hash.reserve(bound);
+                nnz = spmm_csr_row(i,
+                                   A_row_offsets, A_column_indices, A_values,
+                                   B_row_offsets, B_column_indices, B_values,
+                                   C_row_offsets, C_column_indices, C_values,
+                                   hash, sums, columns, sort_columns);
+            }
+            else
+            {
+                if (dense.empty())
+                    dense.resize(num_cols);
+                nnz = spmm_csr_row(i,
+                                   A_row_offsets, A_column_indices, A_values,
+                                   B_row_offsets, B_column_indices, B_values,
+                                   C_row_offsets, C_column_indices, C_values,
+                                   dense, sums, columns, sort_columns);
+            }
 
-            A_row[prev] =  0;                             
-            B_row[prev] =  0;
+            C_row_lengths[i] = nnz;
+            num_nonzeros += nnz;
         }
+    }
+
+    // XXX note: entries of C are unsorted within each row unless sort_columns is set
+
+    return num_nonzeros;
+}
+
+// Remove the gaps left in C by explicit zeros dropped during pass2.  On input
+// rows start at C_row_offsets[i] and hold C_row_lengths[i] entries; on output
+// C_row_offsets describes a compact CSR structure with num_nonzeros entries.
+template <typename Array1, typename Array2, typename Array3, typename Array4>
+void spmm_csr_compact(const size_t num_rows, const size_t num_nonzeros,
+                      Array1& C_row_offsets, Array2& C_column_indices, Array3& C_values,
+                      Array4& C_row_lengths)
+{
+    typedef typename Array1::value_type IndexType;
+    typedef typename Array3::value_type ValueType;
+
+    if (static_cast<size_t>(C_row_offsets[num_rows]) == num_nonzeros)
+        return;
+
+    counts_to_offsets(C_row_lengths);
+
+    cusp::array1d<IndexType,cusp::host_memory> column_indices(num_nonzeros);
+    cusp::array1d<ValueType,cusp::host_memory> values(num_nonzeros);
+
+    #pragma omp parallel num_threads(num_threads(num_nonzeros))
+    {
+        const size_t begin = weighted_partition_begin(C_row_lengths, thread_num(),     team_size());
+        const size_t end   = weighted_partition_begin(C_row_lengths, thread_num() + 1, team_size());
+
+        for(size_t i = begin; i < end; i++)
+        {
+            IndexType src = C_row_offsets[i];
 
-        temp.row_offsets[i + 1] = nnz;
+            for(IndexType dst = C_row_lengths[i]; dst < C_row_lengths[i+1]; dst++, src++)
+            {
+                column_indices[dst] = C_column_indices[src];
+                values[dst]         = C_values[src];
+            }
+        }
     }
 
-    // TODO replace with destructive assignment?
+    C_column_indices.swap(column_indices);
+    C_values.swap(values);
+    C_row_offsets.swap(C_row_lengths);
+}
 
-    temp.resize(A.num_rows, A.num_cols, nnz);
-    cusp::copy(temp, C);
-} // csr_transform_elementwise
+// Row-parallel two-phase (Gustavson) SpGEMM on CSR arrays.  The output arrays
+// are resized to hold exactly the nonzero entries of C.
+template <typename Array1, typename Array2, typename Array3,
+          typename Array4, typename Array5, typename Array6,
+          typename Array7, typename Array8, typename Array9>
+size_t spmm_csr(const size_t num_rows, const size_t num_cols,
+                const Array1& A_row_offsets, const Array2& A_column_indices, const Array3& A_values,
+                const Array4& B_row_offsets, const Array5& B_column_indices, const Array6& B_values,
+                      Array7& C_row_offsets,       Array8& C_column_indices,       Array9& C_values,
+                const bool sort_columns = false)
+{
+    typedef typename Array7::value_type IndexType;
+
+    cusp::array1d<size_t,cusp::host_memory> work;
+    spmm_csr_row_work(num_rows, A_row_offsets, A_column_indices, B_row_offsets, work);
+
+    size_t estimated_nonzeros =
+        spmm_csr_pass1(num_rows, num_cols,
+                       A_row_offsets, A_column_indices,
+                       B_row_offsets, B_column_indices,
+                       work, C_row_offsets);
+
+    C_column_indices.resize(estimated_nonzeros);
+    C_values.resize(estimated_nonzeros);
+
+    cusp::array1d<IndexType,cusp::host_memory> C_row_lengths;
+
+    size_t true_nonzeros =
+        spmm_csr_pass2(num_rows, num_cols,
+                       A_row_offsets, A_column_indices, A_values,
+                       B_row_offsets, B_column_indices, B_values,
+                       C_row_offsets, C_column_indices, C_values,
+                       C_row_lengths, sort_columns);
+
+    // pass2 omits explicit zeros
+    spmm_csr_compact(num_rows, true_nonzeros,
+                     C_row_offsets, C_column_indices, C_values,
+                     C_row_lengths);
+
+    return true_nonzeros;
+}
+
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3>
+void spmm_csr(const Matrix1& A,
+              const Matrix2& B,
+                    Matrix3& C,
+              const bool sort_columns = false)
+{
+    typedef typename Matrix3::index_type IndexType;
+    typedef typename Matrix3::value_type ValueType;
+
+    cusp::array1d<IndexType,cusp::host_memory> C_row_offsets;
+    cusp::array1d<IndexType,cusp::host_memory> C_column_indices;
+    cusp::array1d<ValueType,cusp::host_memory> C_values;
+
+    size_t num_nonzeros =
+        spmm_csr(A.num_rows, B.num_cols,
+                 A.row_offsets, A.column_indices, A.values,
+                 B.row_offsets, B.column_indices, B.values,
+                 C_row_offsets, C_column_indices, C_values,
+                 sort_columns);
+
+    assign_array(C_row_offsets,    C.row_offsets);
+    assign_array(C_column_indices, C.column_indices);
+    assign_array(C_values,         C.values);
+
+    C.resize(A.num_rows, B.num_cols, num_nonzeros);
+}
 
+////////////////////////////////
+// Symbolic and Numeric SpGEMM //
+////////////////////////////////
 
+// Write the sorted column indices of row i of A * B starting at
+// C_row_offsets[i].
 template <typename Array1, typename Array2,
-          typename Array3, typename Array4>
-size_t spmm_csr_pass1(const size_t num_rows, const size_t num_cols,
-                         const Array1& A_row_offsets, const Array2& A_column_indices,
-                         const Array3& B_row_offsets, const Array4& B_column_indices)
+          typename Array3, typename Array4,
+          typename Array5, typename Array6,
+          typename Accumulator>
+void spmm_csr_row_structure(const size_t i,
+                            const Array1& A_row_offsets, const Array2& A_column_indices,
+                            const Array3& B_row_offsets, const Array4& B_column_indices,
+                            const Array5& C_row_offsets,       Array6& C_column_indices,
+                                  Accumulator& accumulator)
 {
     typedef typename Array1::value_type IndexType1;
-    typedef typename Array2::value_type IndexType2;
-    
-    cusp::array1d<size_t, cusp::host_memory> mask(num_cols, static_cast<size_t>(-1));
+    typedef typename Array3::value_type IndexType2;
 
-    // Compute nnz in C (including explicit zeros)
-    size_t num_nonzeros = 0;
+    for(IndexType1 jj = A_row_offsets[i]; jj < A_row_offsets[i+1]; jj++)
+    {
+        IndexType1 j = A_column_indices[jj];
+
+        for(IndexType2 kk = B_row_offsets[j]; kk < B_row_offsets[j+1]; kk++)
+            accumulator.insert(B_column_indices[kk]);
+    }
+
+    const size_t offset = C_row_offsets[i];
+    const size_t length = accumulator.size();
 
-    for(size_t i = 0; i < num_rows; i++)
+    for(size_t slot = 0; slot < length; slot++)
+        C_column_indices[offset + slot] = accumulator.key(slot);
+
+    std::sort(C_column_indices.begin() + offset, C_column_indices.begin() + offset + length);
+
+    accumulator.clear();
+}
+
+// Compute the sparsity structure of C = A * B.  Every product term is kept,
+// even if it sums to zero, so the structure remains valid for any values of
+// A and B with the same sparsity.  Column indices are sorted within rows.
+template <typename Array1, typename Array2,
+          typename Array3, typename Array4,
+          typename Array5, typename Array6>
+size_t spmm_csr_symbolic(const size_t num_rows, const size_t num_cols,
+                         const Array1& A_row_offsets, const Array2& A_column_indices,
+                         const Array3& B_row_offsets, const Array4& B_column_indices,
+                               Array5& C_row_offsets,       Array6& C_column_indices)
+{
+    typedef typename Array5::value_type IndexType;
+
+    cusp::array1d<size_t,cusp::host_memory> work;
+    spmm_csr_row_work(num_rows, A_row_offsets, A_column_indices, B_row_offsets, work);
+
+    size_t num_nonzeros =
+        spmm_csr_pass1(num_rows, num_cols,
+                       A_row_offsets, A_column_indices,
+                       B_row_offsets, B_column_indices,
+                       work, C_row_offsets);
+
+    C_column_indices.resize(num_nonzeros);
+
+    #pragma omp parallel num_threads(num_threads(num_nonzeros))
     {
-        for(IndexType1 jj = A_row_offsets[i]; jj < A_row_offsets[i+1]; jj++)
+        const size_t begin = weighted_partition_begin(C_row_offsets, thread_num(),     team_size());
+        const size_t end   = weighted_partition_begin(C_row_offsets, thread_num() + 1, team_size());
+
+        dense_accumulator<IndexType> dense;
+        hash_accumulator<IndexType>  hash;
+
+        for(size_t i = begin; i < end; i++)
         {
-            IndexType1 j = A_column_indices[jj];
+            size_t bound = C_row_offsets[i+1] - C_row_offsets[i];
 
-            for(IndexType2 kk = B_row_offsets[j]; kk < B_row_offsets[j+1]; kk++)
+            if (use_hash_accumulator(bound, num_cols))
             {
-                IndexType2 k = B_column_indices[kk];
-
-                if(mask[k] != i)
-                {
-                    mask[k] = i;                        
-                    num_nonzeros++;
-                }
+                hash.reserve(bound);
+                spmm_csr_row_structure(i, A_row_offsets, A_column_indices,
+                                          B_row_offsets, B_column_indices,
+                                          C_row_offsets, C_column_indices, hash);
+            }
+            else
+            {
+                if (dense.empty())
+                    dense.resize(num_cols);
+                spmm_csr_row_structure(i, A_row_offsets, A_column_indices,
+                                          B_row_offsets, B_column_indices,
+                                          C_row_offsets, C_column_indices, dense);
             }
         }
     }
@@ -145,109 +1046,413 @@ size_t spmm_csr_pass1(const size_t num_rows, const size_t num_cols,
     return num_nonzeros;
 }
 
+// Refill the values of row i of C = A * B.  The accumulator maps each column
+// of the row to its position within the row.  Returns false if a product
+// term falls outside the structure of C.
 template <typename Array1, typename Array2, typename Array3,
           typename Array4, typename Array5, typename Array6,
-          typename Array7, typename Array8, typename Array9>
-size_t spmm_csr_pass2(const size_t num_rows, const size_t num_cols,
-                         const Array1& A_row_offsets, const Array2& A_column_indices, const Array3& A_values,
-                         const Array4& B_row_offsets, const Array5& B_column_indices, const Array6& B_values,
-                               Array7& C_row_offsets,       Array8& C_column_indices,       Array9& C_values)
+          typename Array7, typename Array8, typename Array9,
+          typename Accumulator>
+bool spmm_csr_row_numeric(const size_t i,
+                          const Array1& A_row_offsets, const Array2& A_column_indices, const Array3& A_values,
+                          const Array4& B_row_offsets, const Array5& B_column_indices, const Array6& B_values,
+                          const Array7& C_row_offsets, const Array8& C_column_indices,       Array9& C_values,
+                                Accumulator& accumulator)
 {
+    typedef typename Array1::value_type IndexType1;
+    typedef typename Array4::value_type IndexType2;
     typedef typename Array7::value_type IndexType;
     typedef typename Array9::value_type ValueType;
 
-    size_t num_nonzeros = 0;
+    const IndexType offset = C_row_offsets[i];
+    const IndexType length = C_row_offsets[i+1] - offset;
 
-    const IndexType unseen = static_cast<IndexType>(-1);
-    const IndexType init   = static_cast<IndexType>(-2);  
-
-    // Compute entries of C
-    cusp::array1d<IndexType,cusp::host_memory> next(num_cols, unseen);
-    cusp::array1d<ValueType,cusp::host_memory> sums(num_cols, ValueType(0));
-    
-    num_nonzeros = 0;
-    
-    C_row_offsets[0] = 0;
-    
-    for(size_t i = 0; i < num_rows; i++)
+    for(IndexType n = 0; n < length; n++)
     {
-        IndexType head   = init;
-        IndexType length =    0;
-    
-        IndexType jj_start = A_row_offsets[i];
-        IndexType jj_end   = A_row_offsets[i+1];
+        accumulator.insert(C_column_indices[offset + n]);
+        C_values[offset + n] = ValueType(0);
+    }
+
+    // duplicate column indices would break the slot to position mapping
+    bool valid = accumulator.size() == size_t(length);
 
-        for(IndexType jj = jj_start; jj < jj_end; jj++)
+    for(IndexType1 jj = A_row_offsets[i]; valid && jj < A_row_offsets[i+1]; jj++)
+    {
+        IndexType1 j = A_column_indices[jj];
+        ValueType  v = A_values[jj];
+
+        for(IndexType2 kk = B_row_offsets[j]; kk < B_row_offsets[j+1]; kk++)
         {
-            IndexType j = A_column_indices[jj];
-            ValueType v = A_values[jj];
-    
-            IndexType kk_start = B_row_offsets[j];
-            IndexType kk_end   = B_row_offsets[j+1];
+            IndexType slot = accumulator.find(B_column_indices[kk]);
 
-            for(IndexType kk = kk_start; kk < kk_end; kk++)
+            if (slot == IndexType(-1))
             {
-                IndexType k = B_column_indices[kk];
-    
-                sums[k] += v * B_values[kk];
-    
-                if(next[k] == unseen)
-                {
-                    next[k] = head;                        
-                    head  = k;
-                    length++;
-                }
+                valid = false;
+                break;
             }
+
+            C_values[offset + slot] += v * B_values[kk];
         }
-    
-        for(IndexType jj = 0; jj < length; jj++)
+    }
+
+    accumulator.clear();
+
+    return valid;
+}
+
+// Recompute the values of C = A * B, where C already holds the structure
+// produced by spmm_csr_symbolic for matrices with the same sparsity as A and B.
+// Only C_values is written.
+template <typename Array1, typename Array2, typename Array3,
+          typename Array4, typename Array5, typename Array6,
+          typename Array7, typename Array8, typename Array9>
+void spmm_csr_numeric(const size_t num_rows, const size_t num_cols,
+                      const Array1& A_row_offsets, const Array2& A_column_indices, const Array3& A_values,
+                      const Array4& B_row_offsets, const Array5& B_column_indices, const Array6& B_values,
+                      const Array7& C_row_offsets, const Array8& C_column_indices,       Array9& C_values)
+{
+    typedef typename Array7::value_type IndexType;
+
+    bool valid = true;
+
+    #pragma omp parallel num_threads(num_threads(C_row_offsets[num_rows]))
+    {
+        const size_t begin = weighted_partition_begin(C_row_offsets, thread_num(),     team_size());
+        const size_t end   = weighted_partition_begin(C_row_offsets, thread_num() + 1, team_size());
+
+        dense_accumulator<IndexType> dense;
+        hash_accumulator<IndexType>  hash;
+
+        bool thread_valid = true;
+
+        for(size_t i = begin; i < end; i++)
         {
-            if(sums[head] != ValueType(0))
+            size_t bound = C_row_offsets[i+1] - C_row_offsets[i];
+
+            if (use_hash_accumulator(bound, num_cols))
+            {
+                hash.reserve(bound);
+                thread_valid &= spmm_csr_row_numeric(i,
+                                                     A_row_offsets, A_column_indices, A_values,
+                                                     B_row_offsets, B_column_indices, B_values,
+                                                     C_row_offsets, C_column_indices, C_values,
+                                                     hash);
+            }
+            else
             {
-                C_column_indices[num_nonzeros] = head;
-                C_values[num_nonzeros]         = sums[head];
-                num_nonzeros++;
+                if (dense.empty())
+                    dense.resize(num_cols);
+                thread_valid &= spmm_csr_row_numeric(i,
+                                                     A_row_offsets, A_column_indices, A_values,
+                                                     B_row_offsets, B_column_indices, B_values,
+                                                     C_row_offsets, C_column_indices, C_values,
+                                                     dense);
             }
-    
-            IndexType temp = head; head = next[head];
-    
-            // clear arrays
-            next[temp] = unseen; 
-            sums[temp] = ValueType(0);                              
         }
-    
-        C_row_offsets[i+1] = num_nonzeros;
+
+        if (!thread_valid)
+        {
+            #pragma omp critical
+            valid = false;
+        }
     }
-    
-    // XXX note: entries of C are unsorted within each row
 
-    return num_nonzeros;
+    if (!valid)
+        throw cusp::invalid_input_exception("sparsity pattern of A * B does not match the structure of C");
 }
 
 template <typename Matrix1,
           typename Matrix2,
           typename Matrix3>
-void spmm_csr(const Matrix1& A,
-              const Matrix2& B,
-                    Matrix3& C)
+void spmm_csr_symbolic(const Matrix1& A,
+                       const Matrix2& B,
+                             Matrix3& C)
 {
     typedef typename Matrix3::index_type IndexType;
+    typedef typename Matrix3::value_type ValueType;
+
+    cusp::array1d<IndexType,cusp::host_memory> C_row_offsets;
+    cusp::array1d<IndexType,cusp::host_memory> C_column_indices;
+
+    size_t num_nonzeros =
+        spmm_csr_symbolic(A.num_rows, B.num_cols,
+                          A.row_offsets, A.column_indices,
+                          B.row_offsets, B.column_indices,
+                          C_row_offsets, C_column_indices);
+
+    assign_array(C_row_offsets,    C.row_offsets);
+    assign_array(C_column_indices, C.column_indices);
 
-    IndexType num_nonzeros = 
-        spmm_csr_pass1(A.num_rows, B.num_cols,
-                       A.row_offsets, A.column_indices,
-                       B.row_offsets, B.column_indices);
-                         
-    // Resize output
     C.resize(A.num_rows, B.num_cols, num_nonzeros);
-    
-    num_nonzeros =
-      spmm_csr_pass2(A.num_rows, B.num_cols,
+
+    thrust::fill(C.values.begin(), C.values.end(), ValueType(0));
+}
+
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3>
+void spmm_csr_numeric(const Matrix1& A,
+                      const Matrix2& B,
+                            Matrix3& C)
+{
+    if (C.num_rows != A.num_rows || C.num_cols != B.num_cols || A.num_cols != B.num_rows)
+        throw cusp::invalid_input_exception("matrix dimensions do not match");
+
+    spmm_csr_numeric(A.num_rows, B.num_cols,
                      A.row_offsets, A.column_indices, A.values,
                      B.row_offsets, B.column_indices, B.values,
                      C.row_offsets, C.column_indices, C.values);
+}
+
+///////////////////////
+// Blocked SpGEMM    //
+///////////////////////
+
+// Compute C = A * B one block of rows at a time.  Rows of A are grouped so
+// that an upper bound on the storage for each block of C stays within
+// max_bytes (a block always holds at least one row).  For each block f is
+// called with the index of the first row of the block and a CSR matrix
+// holding those rows of C, in order of increasing row index.
+template <typename Matrix1,
+          typename Matrix2,
+          typename BlockFunction>
+void spmm_csr_blocked(const Matrix1& A,
+                      const Matrix2& B,
+                            BlockFunction f,
+                      const size_t max_bytes)
+{
+    typedef typename Matrix1::index_type IndexType;
+    typedef typename Matrix1::value_type ValueType;
+
+    const size_t bytes_per_row   = sizeof(IndexType);
+    const size_t bytes_per_entry = sizeof(IndexType) + sizeof(ValueType);
+
+    // number of multiply-adds in each row of C bounds its length
+    cusp::array1d<size_t,cusp::host_memory> work;
+    spmm_csr_row_work(A.num_rows, A.row_offsets, A.column_indices, B.row_offsets, work);
+
+    cusp::csr_matrix<IndexType,ValueType,cusp::host_memory> C_block;
+
+    size_t begin = 0;
+
+    while (begin < A.num_rows)
+    {
+        // grow the block until the bound on its storage exceeds the budget
+        size_t end   = begin;
+        size_t bytes = bytes_per_row;
+
+        while (end < A.num_rows)
+        {
+            size_t bound = std::min<size_t>(work[end + 1] - work[end], B.num_cols);
+            size_t row_bytes = bytes_per_row + bound * bytes_per_entry;
+
+            if (end > begin && bytes + row_bytes > max_bytes)
+                break;
+
+            bytes += row_bytes;
+            end++;
+        }
+
+        const size_t num_rows = end - begin;
+
+        // offsets into A for this block of rows
+        cusp::array1d<IndexType,cusp::host_memory> A_row_offsets(A.row_offsets.begin() + begin,
+                                                                 A.row_offsets.begin() + end + 1);
+
+        size_t num_nonzeros =
+            spmm_csr(num_rows, B.num_cols,
+                     A_row_offsets,         A.column_indices,         A.values,
+                     B.row_offsets,         B.column_indices,         B.values,
+                     C_block.row_offsets,   C_block.column_indices,   C_block.values);
+
+        C_block.resize(num_rows, B.num_cols, num_nonzeros);
+
+        f(begin, C_block);
+
+        begin = end;
+    }
+}
+
+///////////////////
+// Masked SpGEMM //
+///////////////////
+
+// Compute the entries of row i of A * B that lie in row i of the mask M and
+// write the nonzero ones starting at position offset of C.  The accumulator
+// holds only the columns of the mask row, so product terms outside the mask
+// are discarded without being accumulated.  Returns the number written.
+template <typename Array1, typename Array2, typename Array3,
+          typename Array4, typename Array5, typename Array6,
+          typename Array7, typename Array8,
+          typename Array9, typename Array10,
+          typename Accumulator, typename ValueType>
+size_t spmm_csr_row_masked(const size_t i,
+                           const Array1& A_row_offsets, const Array2& A_column_indices, const Array3& A_values,
+                           const Array4& B_row_offsets, const Array5& B_column_indices, const Array6& B_values,
+                           const Array7& M_row_offsets, const Array8& M_column_indices,
+                                 Array9& C_column_indices,  Array10& C_values,
+                           const size_t offset,
+                                 Accumulator& accumulator,
+                                 std::vector<ValueType>& sums)
+{
+    typedef typename Array1::value_type IndexType1;
+    typedef typename Array4::value_type IndexType2;
+    typedef typename Array7::value_type IndexType;
+
+    const IndexType length = M_row_offsets[i+1] - M_row_offsets[i];
+
+    if (length == 0)
+        return 0;
+
+    if (sums.size() < size_t(length))
+        sums.resize(length, ValueType(0));
+
+    for(IndexType jj = M_row_offsets[i]; jj < M_row_offsets[i+1]; jj++)
+        accumulator.insert(M_column_indices[jj]);
+
+    for(IndexType1 jj = A_row_offsets[i]; jj < A_row_offsets[i+1]; jj++)
+    {
+        IndexType1 j = A_column_indices[jj];
+        ValueType  v = A_values[jj];
+
+        for(IndexType2 kk = B_row_offsets[j]; kk < B_row_offsets[j+1]; kk++)
+        {
+            IndexType slot = accumulator.find(B_column_indices[kk]);
+
+            if (slot != IndexType(-1))
+                sums[slot] += v * B_values[kk];
+        }
+    }
+
+    size_t nnz = 0;
+
+    for(size_t slot = 0; slot < accumulator.size(); slot++)
+    {
+        if (sums[slot] != ValueType(0))
+        {
+            C_column_indices[offset + nnz] = accumulator.key(slot);
+            C_values[offset + nnz]         = sums[slot];
+            nnz++;
+        }
+
+        sums[slot] = ValueType(0);
+    }
+
+    accumulator.clear();
+
+    return nnz;
+}
+
+// Masked SpGEMM C = (A * B) restricted to the sparsity pattern of M.  The
+// values of M are ignored.  C has no explicit zeros, and its rows follow
+// the column order of M.  The output arrays are sized exactly.
+template <typename Array1, typename Array2, typename Array3,
+          typename Array4, typename Array5, typename Array6,
+          typename Array7, typename Array8,
+          typename Array9, typename Array10, typename Array11>
+size_t spmm_csr_masked(const size_t num_rows, const size_t num_cols,
+                       const Array1& A_row_offsets, const Array2& A_column_indices, const Array3& A_values,
+                       const Array4& B_row_offsets, const Array5& B_column_indices, const Array6& B_values,
+                       const Array7& M_row_offsets, const Array8& M_column_indices,
+                             Array9& C_row_offsets, Array10& C_column_indices, Array11& C_values)
+{
+    typedef typename Array9::value_type  IndexType;
+    typedef typename Array11::value_type ValueType;
+
+    // the mask bounds the structure of C
+    const size_t num_entries = M_row_offsets[num_rows] - M_row_offsets[0];
+
+    C_row_offsets.resize(num_rows + 1);
+    C_column_indices.resize(num_entries);
+    C_values.resize(num_entries);
+
+    // balance rows by the work of forming them in full
+    cusp::array1d<size_t,cusp::host_memory> work;
+    spmm_csr_row_work(num_rows, A_row_offsets, A_column_indices, B_row_offsets, work);
+
+    cusp::array1d<IndexType,cusp::host_memory> C_row_lengths(num_rows + 1);
+
+    size_t num_nonzeros = 0;
+
+    #pragma omp parallel num_threads(num_threads(work[num_rows])) reduction(+ : num_nonzeros)
+    {
+        const size_t begin = weighted_partition_begin(work, thread_num(),     team_size());
+        const size_t end   = weighted_partition_begin(work, thread_num() + 1, team_size());
+
+        dense_accumulator<IndexType> dense;
+        hash_accumulator<IndexType>  hash;
+
+        std::vector<ValueType> sums;
+
+        for(size_t i = begin; i < end; i++)
+        {
+            size_t bound  = M_row_offsets[i+1] - M_row_offsets[i];
+            size_t offset = M_row_offsets[i]   - M_row_offsets[0];
+            size_t nnz    = 0;
+
+            C_row_offsets[i] = offset;
+
+            if (use_hash_accumulator(bound, num_cols))
+            {
+                hash.reserve(bound);
+                nnz = spmm_csr_row_masked(i,
+                                          A_row_offsets, A_column_indices, A_values,
+                                          B_row_offsets, B_column_indices, B_values,
+                                          M_row_offsets, M_column_indices,
+                                          C_column_indices, C_values, offset, hash, sums);
+            }
+            else
+            {
+                if (dense.empty())
+                    dense.resize(num_cols);
+                nnz = spmm_csr_row_masked(i,
+                                          A_row_offsets, A_column_indices, A_values,
+                                          B_row_offsets, B_column_indices, B_values,
+                                          M_row_offsets, M_column_indices,
+                                          C_column_indices, C_values, offset, dense, sums);
+            }
+
+            C_row_lengths[i] = nnz;
+            num_nonzeros += nnz;
+        }
+    }
+
+    C_row_offsets[num_rows] = num_entries;
+
+    spmm_csr_compact(num_rows, num_nonzeros,
+                     C_row_offsets, C_column_indices, C_values,
+                     C_row_lengths);
+
+    return num_nonzeros;
+}
+
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3,
+          typename Matrix4>
+void spmm_csr_masked(const Matrix1& A,
+                     const Matrix2& B,
+                     const Matrix3& M,
+                           Matrix4& C)
+{
+    typedef typename Matrix4::index_type IndexType;
+    typedef typename Matrix4::value_type ValueType;
+
+    cusp::array1d<IndexType,cusp::host_memory> C_row_offsets;
+    cusp::array1d<IndexType,cusp::host_memory> C_column_indices;
+    cusp::array1d<ValueType,cusp::host_memory> C_values;
+
+    size_t num_nonzeros =
+        spmm_csr_masked(A.num_rows, B.num_cols,
+                        A.row_offsets, A.column_indices, A.values,
+                        B.row_offsets, B.column_indices, B.values,
+                        M.row_offsets, M.column_indices,
+                        C_row_offsets, C_column_indices, C_values);
+
+    assign_array(C_row_offsets,    C.row_offsets);
+    assign_array(C_column_indices, C.column_indices);
+    assign_array(C_values,         C.values);
 
-    // Resize output again since pass2 omits explict zeros
     C.resize(A.num_rows, B.num_cols, num_nonzeros);
 }
 
@@ -0,0 +1,286 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include <cusp/array2d.h>
+
+#include <cusp/detail/host/blas.h>
+#include <cusp/detail/host/parallel.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace cusp
+{
+namespace detail
+{
+namespace host
+{
+namespace detail
+{
+
+// Element (i,j) of a dense matrix is values[i * row_stride + j * column_stride],
+// which covers both orientations and the pitch of array2d and array2d_view.
+template <typename Matrix>
+size_t row_stride(const Matrix& A, cusp::row_major)    { return A.pitch; }
+
+template <typename Matrix>
+size_t row_stride(const Matrix& A, cusp::column_major) { return 1; }
+
+template <typename Matrix>
+size_t column_stride(const Matrix& A, cusp::row_major)    { return 1; }
+
+template <typename Matrix>
+size_t column_stride(const Matrix& A, cusp::column_major) { return A.pitch; }
+
+//////////
+// GEMV //
+//////////
+
+// dot product of the n entries of a row with x
+template <typename ValueType, typename Iterator1, typename Iterator2>
+ValueType gemv_row(Iterator1 row, Iterator2 x, const size_t n)
+{
+    return dot_kernel<Iterator1,Iterator2,ValueType,false>(row, x)(0, n);
+}
+
+// y = A * x with A row-major: y[i] is the dot product of row i with x
+template <typename Matrix, typename Vector1, typename Vector2>
+void gemv(const Matrix& A, const Vector1& x, Vector2& y, cusp::row_major)
+{
+    typedef typename Vector2::value_type ValueType;
+
+    const long num_rows = A.num_rows;
+
+    #pragma omp parallel for num_threads(num_threads(A.num_rows * A.num_cols, blas_grain_size))
+    for (long i = 0; i < num_rows; i++)
+        y[i] = gemv_row<ValueType>(A.values.begin() + i * A.pitch, x.begin(), A.num_cols);
+}
+
+// y = A * x with A column-major: y accumulates x[j] times column j, for
+// all columns in one pass over each block of rows
+template <typename Matrix, typename Vector1, typename Vector2>
+void gemv(const Matrix& A, const Vector1& x, Vector2& y, cusp::column_major)
+{
+    typedef typename Vector2::value_type ValueType;
+
+    cusp::detail::host::parallel_fill(y, ValueType(0));
+
+    cusp::detail::host::maxpy<ValueType>(A.values.begin(), A.pitch, x.begin(), y.begin(),
+                                         A.num_rows, A.num_cols, ValueType(1));
+}
+
+//////////
+// GEMM //
+//////////
+
+// C = A * B is computed in tiles of C of gemm_mc rows and gemm_nc columns,
+// which are divided among the threads.  For each tile, panels of gemm_kc
+// columns of A and rows of B are packed into contiguous buffers, A in
+// slivers of MR rows and B in slivers of NR columns, so the innermost
+// kernel reads both operands with unit stride whatever the orientation of
+// A and B.  The kernel keeps an MR x NR block of C in registers while it
+// runs over a panel; the panel of A stays in the L2 cache while it is
+// multiplied with every sliver of B.
+//
+// Each entry of C is summed in the same order by a single thread, so the
+// result does not depend on the number of threads.
+
+// MR x NR register block, sized to fit the 16 SIMD registers of an x86-64
+// processor without AVX
+template <typename ValueType>
+struct gemm_block
+{
+    static const size_t mr = 4;
+    static const size_t nr = 4;
+};
+
+template <>
+struct gemm_block<float>
+{
+    static const size_t mr = 4;
+    static const size_t nr = 8;
+};
+
+template <typename T>
+struct gemm_block< cusp::complex<T> >
+{
+    static const size_t mr = 2;
+    static const size_t nr = 4;
+};
+
+const size_t gemm_kc = 256;
+const size_t gemm_mc = 64;
+const size_t gemm_nc = 512;
+
+// Copy the mc x kc block of a matrix starting at element (i0,p0) into
+// slivers of MR rows; sliver s holds rows [s * MR, (s + 1) * MR)
+// column by column.  Rows beyond mc are padded with zeros.
+template <typename Iterator, typename ValueType>
+void gemm_pack_A(Iterator values, const size_t rs, const size_t cs,
+                 const size_t i0, const size_t p0, const size_t mc, const size_t kc,
+                 ValueType * packed)
+{
+    const size_t MR = gemm_block<ValueType>::mr;
+
+    for (size_t s = 0; s < mc; s += MR)
+    {
+        const size_t mr = std::min(MR, mc - s);
+
+        for (size_t p = 0; p < kc; p++)
+        {
+            for (size_t i = 0; i < mr; i++)
+                packed[i] = values[(i0 + s + i) * rs + (p0 + p) * cs];
+            for (size_t i = mr; i < MR; i++)
+                packed[i] = ValueType(0);
+
+            packed += MR;
+        }
+    }
+}
+
+// Copy the kc x nc block of a matrix starting at element (p0,j0) into
+// slivers of NR columns; sliver s holds columns [s * NR, (s + 1) * NR)
+// row by row.  Columns beyond nc are padded with zeros.
+template <typename Iterator, typename ValueType>
+void gemm_pack_B(Iterator values, const size_t rs, const size_t cs,
+                 const size_t p0, const size_t j0, const size_t kc, const size_t nc,
+                 ValueType * packed)
+{
+    const size_t NR = gemm_block<ValueType>::nr;
+
+    for (size_t s = 0; s < nc; s += NR)
+    {
+        const size_t nr = std::min(NR, nc - s);
+
+        for (size_t p = 0; p < kc; p++)
+        {
+            for (size_t j = 0; j < nr; j++)
+                packed[j] = values[(p0 + p) * rs + (j0 + s + j) * cs];
+            for (size_t j = nr; j < NR; j++)
+                packed[j] = ValueType(0);
+
+            packed += NR;
+        }
+    }
+}
+
+// ab = a * b for a sliver a of MR x kc and a sliver b of kc x NR
+template <typename ValueType>
+void gemm_kernel(const size_t kc, const ValueType * a, const ValueType * b, ValueType * ab)
+{
+    const size_t MR = gemm_block<ValueType>::mr;
+    const size_t NR = gemm_block<ValueType>::nr;
+
+    ValueType c[MR * NR];
+
+    for (size_t k = 0; k < MR * NR; k++)
+        c[k] = ValueType(0);
+
+    for (size_t p = 0; p < kc; p++)
+    {
+        for (size_t i = 0; i < MR; i++)
+            for (size_t j = 0; j < NR; j++)
+                c[i * NR + j] += a[i] * b[j];
+
+        a += MR;
+        b += NR;
+    }
+
+    for (size_t k = 0; k < MR * NR; k++)
+        ab[k] = c[k];
+}
+
+template <typename Matrix1, typename Matrix2, typename Matrix3>
+void gemm(const Matrix1& A, const Matrix2& B, Matrix3& C)
+{
+    typedef typename Matrix3::value_type ValueType;
+
+    typedef typename Matrix1::orientation Orientation1;
+    typedef typename Matrix2::orientation Orientation2;
+    typedef typename Matrix3::orientation Orientation3;
+
+    const size_t MR = gemm_block<ValueType>::mr;
+    const size_t NR = gemm_block<ValueType>::nr;
+
+    const size_t M = A.num_rows;
+    const size_t N = B.num_cols;
+    const size_t K = A.num_cols;
+
+    const size_t A_rs = row_stride(A, Orientation1()), A_cs = column_stride(A, Orientation1());
+    const size_t B_rs = row_stride(B, Orientation2()), B_cs = column_stride(B, Orientation2());
+    const size_t C_rs = row_stride(C, Orientation3()), C_cs = column_stride(C, Orientation3());
+
+    const size_t row_tiles = (M + gemm_mc - 1) / gemm_mc;
+    const size_t col_tiles = (N + gemm_nc - 1) / gemm_nc;
+    const size_t num_tiles = row_tiles * col_tiles;
+
+    const size_t T = std::min(std::max<size_t>(num_tiles, 1),
+                              num_threads(M * N * std::max<size_t>(K, 1), gemm_mc * gemm_nc * gemm_kc));
+
+    #pragma omp parallel num_threads(T)
+    {
+        std::vector<ValueType> A_packed(gemm_mc * gemm_kc);
+        std::vector<ValueType> B_packed(gemm_kc * ((gemm_nc + NR - 1) / NR) * NR);
+        ValueType AB[MR * NR];
+
+        const size_t first = partition_begin(num_tiles, thread_num(),     team_size());
+        const size_t last  = partition_begin(num_tiles, thread_num() + 1, team_size());
+
+        for (size_t tile = first; tile < last; tile++)
+        {
+            const size_t i0 = (tile / col_tiles) * gemm_mc;
+            const size_t j0 = (tile % col_tiles) * gemm_nc;
+            const size_t mc = std::min(gemm_mc, M - i0);
+            const size_t nc = std::min(gemm_nc, N - j0);
+
+            for (size_t i = 0; i < mc; i++)
+                for (size_t j = 0; j < nc; j++)
+                    C.values[(i0 + i) * C_rs + (j0 + j) * C_cs] = ValueType(0);
+
+            for (size_t p0 = 0; p0 < K; p0 += gemm_kc)
+            {
+                const size_t kc = std::min(gemm_kc, K - p0);
+
+                gemm_pack_A(A.values.begin(), A_rs, A_cs, i0, p0, mc, kc, &A_packed[0]);
+                gemm_pack_B(B.values.begin(), B_rs, B_cs, p0, j0, kc, nc, &B_packed[0]);
+
+                for (size_t jr = 0; jr < nc; jr += NR)
+                {
+                    const size_t nr = std::min(NR, nc - jr);
+
+                    for (size_t ir = 0; ir < mc; ir += MR)
+                    {
+                        const size_t mr = std::min(MR, mc - ir);
+
+                        gemm_kernel(kc, &A_packed[ir * kc], &B_packed[jr * kc], AB);
+
+                        for (size_t i = 0; i < mr; i++)
+                            for (size_t j = 0; j < nr; j++)
+                                C.values[(i0 + ir + i) * C_rs + (j0 + jr + j) * C_cs] += AB[i * NR + j];
+                    }
+                }
+            }
+        }
+    }
+}
+
+} // end namespace detail
+} // end namespace host
+} // end namespace detail
+} // end namespace cusp
+
@@ -0,0 +1,302 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include <cusp/array1d.h>
+
+#include <cusp/detail/host/parallel.h>
+#include <cusp/detail/host/detail/accumulator.h>
+#include <cusp/detail/host/detail/csr.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace cusp
+{
+namespace detail
+{
+namespace host
+{
+namespace detail
+{
+
+// Per-thread state of the fused triple product: one accumulator for the
+// current row of R * A and one for the current row of (R * A) * P.
+template <typename IndexType, typename ValueType>
+struct galerkin_workspace
+{
+    dense_accumulator<IndexType> RA_dense;
+    hash_accumulator<IndexType>  RA_hash;
+    dense_accumulator<IndexType> RAP_dense;
+    hash_accumulator<IndexType>  RAP_hash;
+
+    std::vector<ValueType> RA_values;
+    std::vector<ValueType> RAP_values;
+    std::vector<IndexType> columns;
+};
+
+// Accumulate row i of R * A into the accumulator and RA_values.
+template <typename Array1, typename Array2, typename Array3,
+          typename Array4, typename Array5, typename Array6,
+          typename Accumulator, typename ValueType>
+void galerkin_row_RA(const size_t i,
+                     const Array1& R_row_offsets, const Array2& R_column_indices, const Array3& R_values,
+                     const Array4& A_row_offsets, const Array5& A_column_indices, const Array6& A_values,
+                           Accumulator& accumulator,
+                           std::vector<ValueType>& RA_values,
+                     const size_t bound)
+{
+    typedef typename Array1::value_type IndexType1;
+    typedef typename Array4::value_type IndexType2;
+
+    if (RA_values.size() < bound)
+        RA_values.resize(bound, ValueType(0));
+
+    for(IndexType1 jj = R_row_offsets[i]; jj < R_row_offsets[i+1]; jj++)
+    {
+        IndexType1 j = R_column_indices[jj];
+        ValueType  v = R_values[jj];
+
+        for(IndexType2 kk = A_row_offsets[j]; kk < A_row_offsets[j+1]; kk++)
+            RA_values[accumulator.insert(A_column_indices[kk])] += v * A_values[kk];
+    }
+}
+
+// Multiply the sparse row held in RA (accumulator and values) by P and
+// append the nonzero entries of the result, sorted by column, to the
+// output buffers.  RA is cleared.  Returns the number of entries appended.
+template <typename Array1, typename Array2, typename Array3,
+          typename Accumulator1, typename Accumulator2,
+          typename IndexType, typename ValueType>
+size_t galerkin_row_RAP(const Array1& P_row_offsets, const Array2& P_column_indices, const Array3& P_values,
+                              Accumulator1& RA,
+                              std::vector<ValueType>& RA_values,
+                              Accumulator2& RAP,
+                              std::vector<ValueType>& RAP_values,
+                              std::vector<IndexType>& columns,
+                        const size_t bound,
+                              std::vector<IndexType>& output_columns,
+                              std::vector<ValueType>& output_values)
+{
+    typedef typename Array1::value_type IndexType1;
+
+    if (RAP_values.size() < bound)
+        RAP_values.resize(bound, ValueType(0));
+
+    for(size_t slot = 0; slot < RA.size(); slot++)
+    {
+        IndexType1 k = RA.key(slot);
+        ValueType  v = RA_values[slot];
+
+        RA_values[slot] = ValueType(0);
+
+        if (v == ValueType(0))
+            continue;
+
+        for(IndexType1 pp = P_row_offsets[k]; pp < P_row_offsets[k+1]; pp++)
+            RAP_values[RAP.insert(P_column_indices[pp])] += v * P_values[pp];
+    }
+
+    RA.clear();
+
+    const size_t length = RAP.size();
+
+    columns.resize(length);
+
+    for(size_t slot = 0; slot < length; slot++)
+        columns[slot] = RAP.key(slot);
+
+    std::sort(columns.begin(), columns.end());
+
+    size_t nnz = 0;
+
+    for(size_t n = 0; n < length; n++)
+    {
+        IndexType slot = RAP.find(columns[n]);
+
+        if (RAP_values[slot] != ValueType(0))
+        {
+            output_columns.push_back(columns[n]);
+            output_values.push_back(RAP_values[slot]);
+            nnz++;
+        }
+    }
+
+    for(size_t slot = 0; slot < length; slot++)
+        RAP_values[slot] = ValueType(0);
+
+    RAP.clear();
+
+    return nnz;
+}
+
+// Select the accumulator for row i of (R * A) * P once row i of R * A is known
+template <typename Array1, typename Array2, typename Array3,
+          typename Accumulator, typename IndexType, typename ValueType>
+size_t galerkin_row_RAP(const size_t num_cols,
+                        const Array1& P_row_offsets, const Array2& P_column_indices, const Array3& P_values,
+                              Accumulator& RA,
+                              galerkin_workspace<IndexType,ValueType>& workspace,
+                              std::vector<IndexType>& output_columns,
+                              std::vector<ValueType>& output_values)
+{
+    // upper bound on the length of the row of RAP
+    size_t bound = 0;
+    for(size_t slot = 0; slot < RA.size(); slot++)
+        bound += P_row_offsets[RA.key(slot) + 1] - P_row_offsets[RA.key(slot)];
+
+    if (use_hash_accumulator(bound, num_cols))
+    {
+        workspace.RAP_hash.reserve(bound);
+        return galerkin_row_RAP(P_row_offsets, P_column_indices, P_values,
+                                RA, workspace.RA_values,
+                                workspace.RAP_hash, workspace.RAP_values,
+                                workspace.columns, bound,
+                                output_columns, output_values);
+    }
+    else
+    {
+        if (workspace.RAP_dense.empty())
+            workspace.RAP_dense.resize(num_cols);
+        return galerkin_row_RAP(P_row_offsets, P_column_indices, P_values,
+                                RA, workspace.RA_values,
+                                workspace.RAP_dense, workspace.RAP_values,
+                                workspace.columns, bound,
+                                output_columns, output_values);
+    }
+}
+
+// Fused Galerkin product RAP = R * A * P on CSR arrays.  Each row of RAP is
+// formed from the corresponding row of R * A, which only ever exists in a
+// per-thread accumulator, so neither R * A nor A * P is stored.  Rows of
+// RAP have sorted column indices and no explicit zeros.  The output arrays
+// are resized to hold exactly the nonzero entries of RAP.
+template <typename Array1, typename Array2, typename Array3,
+          typename Array4, typename Array5, typename Array6,
+          typename Array7, typename Array8, typename Array9,
+          typename Array10, typename Array11, typename Array12>
+size_t galerkin_product_csr(const size_t num_rows, const size_t num_inner, const size_t num_cols,
+                            const Array1& R_row_offsets, const Array2& R_column_indices, const Array3& R_values,
+                            const Array4& A_row_offsets, const Array5& A_column_indices, const Array6& A_values,
+                            const Array7& P_row_offsets, const Array8& P_column_indices, const Array9& P_values,
+                                  Array10& RAP_row_offsets, Array11& RAP_column_indices, Array12& RAP_values)
+{
+    typedef typename Array10::value_type IndexType;
+    typedef typename Array12::value_type ValueType;
+
+    // rows are balanced by the work needed to form R * A
+    cusp::array1d<size_t,cusp::host_memory> work;
+    spmm_csr_row_work(num_rows, R_row_offsets, R_column_indices, A_row_offsets, work);
+
+    RAP_row_offsets.resize(num_rows + 1);
+
+    size_t num_nonzeros = 0;
+
+    #pragma omp parallel num_threads(num_threads(work[num_rows]))
+    {
+        const size_t begin = weighted_partition_begin(work, thread_num(),     team_size());
+        const size_t end   = weighted_partition_begin(work, thread_num() + 1, team_size());
+
+        galerkin_workspace<IndexType,ValueType> workspace;
+
+        // rows of RAP computed by this thread
+        std::vector<IndexType> output_columns;
+        std::vector<ValueType> output_values;
+
+        for(size_t i = begin; i < end; i++)
+        {
+            size_t bound = work[i+1] - work[i];
+
+            if (use_hash_accumulator(bound, num_inner))
+            {
+                workspace.RA_hash.reserve(bound);
+                galerkin_row_RA(i, R_row_offsets, R_column_indices, R_values,
+                                   A_row_offsets, A_column_indices, A_values,
+                                   workspace.RA_hash, workspace.RA_values, bound);
+                RAP_row_offsets[i] =
+                    galerkin_row_RAP(num_cols, P_row_offsets, P_column_indices, P_values,
+                                     workspace.RA_hash, workspace, output_columns, output_values);
+            }
+            else
+            {
+                if (workspace.RA_dense.empty())
+                    workspace.RA_dense.resize(num_inner);
+                galerkin_row_RA(i, R_row_offsets, R_column_indices, R_values,
+                                   A_row_offsets, A_column_indices, A_values,
+                                   workspace.RA_dense, workspace.RA_values, bound);
+                RAP_row_offsets[i] =
+                    galerkin_row_RAP(num_cols, P_row_offsets, P_column_indices, P_values,
+                                     workspace.RA_dense, workspace, output_columns, output_values);
+            }
+        }
+
+        #pragma omp barrier
+
+        #pragma omp single
+        {
+            num_nonzeros = counts_to_offsets(RAP_row_offsets);
+
+            RAP_column_indices.resize(num_nonzeros);
+            RAP_values.resize(num_nonzeros);
+        }
+
+        // copy this thread's rows into place
+        if (begin < end)
+        {
+            std::copy(output_columns.begin(), output_columns.end(), RAP_column_indices.begin() + RAP_row_offsets[begin]);
+            std::copy(output_values.begin(),  output_values.end(),  RAP_values.begin()         + RAP_row_offsets[begin]);
+        }
+    }
+
+    return num_nonzeros;
+}
+
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3,
+          typename Matrix4>
+void galerkin_product_csr(const Matrix1& R,
+                          const Matrix2& A,
+                          const Matrix3& P,
+                                Matrix4& RAP)
+{
+    typedef typename Matrix4::index_type IndexType;
+    typedef typename Matrix4::value_type ValueType;
+
+    cusp::array1d<IndexType,cusp::host_memory> RAP_row_offsets;
+    cusp::array1d<IndexType,cusp::host_memory> RAP_column_indices;
+    cusp::array1d<ValueType,cusp::host_memory> RAP_values;
+
+    size_t num_nonzeros =
+        galerkin_product_csr(R.num_rows, A.num_cols, P.num_cols,
+                             R.row_offsets, R.column_indices, R.values,
+                             A.row_offsets, A.column_indices, A.values,
+                             P.row_offsets, P.column_indices, P.values,
+                             RAP_row_offsets, RAP_column_indices, RAP_values);
+
+    assign_array(RAP_row_offsets,    RAP.row_offsets);
+    assign_array(RAP_column_indices, RAP.column_indices);
+    assign_array(RAP_values,         RAP.values);
+
+    RAP.resize(R.num_rows, P.num_cols, num_nonzeros);
+}
+
+} // end namespace detail
+} // end namespace host
+} // end namespace detail
+} // end namespace cusp
+
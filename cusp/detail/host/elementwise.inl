@@ -18,6 +18,7 @@
 
 #include <cusp/format.h>
 #include <cusp/csr_matrix.h>
+#include <cusp/detail/host/detail/coo.h>
 #include <cusp/detail/host/detail/csr.h>
 
 namespace cusp
@@ -33,21 +34,20 @@ namespace dispatch
 // COO //
 /////////
 
-// TODO add COO version of transform_elementwise
-//template <typename Matrix1,
-//          typename Matrix2,
-//          typename Matrix3,
-//          typename BinaryFunction>
-//void transform_elementwise(const Matrix1& A,
-//                           const Matrix2& B,
-//                                 Matrix3& C,
-//                                 BinaryFunction op,
-//                           cusp::coo_format,
-//                           cusp::coo_format,
-//                           cusp::coo_format)
-//{
-//    cusp::detail::host::detail::transform_elementwise_coo(A, B, C, op); 
-//}
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3,
+          typename BinaryFunction>
+void transform_elementwise(const Matrix1& A,
+                           const Matrix2& B,
+                                 Matrix3& C,
+                                 BinaryFunction op,
+                           cusp::coo_format,
+                           cusp::coo_format,
+                           cusp::coo_format)
+{
+    cusp::detail::host::detail::coo_transform_elementwise(A, B, C, op); 
+}
 
 
 /////////
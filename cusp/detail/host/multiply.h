@@ -29,6 +29,8 @@
 
 #include <cusp/detail/host/detail/coo.h>
 #include <cusp/detail/host/detail/csr.h>
+#include <cusp/detail/host/detail/dense.h>
+#include <cusp/detail/host/detail/galerkin_product.h>
 
 namespace cusp
 {
@@ -50,17 +52,7 @@ void multiply(const Matrix&  A,
               cusp::array1d_format,
               cusp::array1d_format)
 {
-    typedef typename Vector2::value_type ValueType;
-
-    for(size_t i = 0; i < A.num_rows; i++)
-    {
-        ValueType sum = 0;
-        for(size_t j = 0; j < A.num_cols; j++)
-        {
-            sum += A(i,j) * B[j];
-        }
-        C[i] = sum;
-    }
+    cusp::detail::host::detail::gemv(A, B, C, typename Matrix::orientation());
 }
 
 ///////////////////////////////////
@@ -163,22 +155,9 @@ void multiply(const Matrix1&  A,
               cusp::array2d_format,
               cusp::array2d_format)
 {
-    typedef typename Matrix3::value_type ValueType;
-
     C.resize(A.num_rows, B.num_cols);
 
-    for(size_t i = 0; i < C.num_rows; i++)
-    {
-        for(size_t j = 0; j < C.num_cols; j++)
-        {
-            ValueType v = 0;
-
-            for(size_t k = 0; k < A.num_cols; k++)
-                v += A(i,k) * B(k,j);
-            
-            C(i,j) = v;
-        }
-    }
+    cusp::detail::host::detail::gemm(A, B, C);
 }
 
 /////////////////////////////////////////
@@ -230,6 +209,196 @@ void multiply(const Matrix1& A,
     cusp::convert(C_, C);
 }
   
+////////////////////////////////////////////////////
+// Symbolic and Numeric Matrix-Matrix Multiplication //
+////////////////////////////////////////////////////
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3>
+void multiply_symbolic(const Matrix1& A,
+                       const Matrix2& B,
+                             Matrix3& C,
+                       cusp::coo_format,
+                       cusp::coo_format,
+                       cusp::coo_format)
+{
+    cusp::detail::host::detail::spmm_coo_symbolic(A,B,C);
+}
+
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3>
+void multiply_symbolic(const Matrix1& A,
+                       const Matrix2& B,
+                             Matrix3& C,
+                       cusp::csr_format,
+                       cusp::csr_format,
+                       cusp::csr_format)
+{
+    cusp::detail::host::detail::spmm_csr_symbolic(A,B,C);
+}
+
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3>
+void multiply_numeric(const Matrix1& A,
+                      const Matrix2& B,
+                            Matrix3& C,
+                      cusp::coo_format,
+                      cusp::coo_format,
+                      cusp::coo_format)
+{
+    cusp::detail::host::detail::spmm_coo_numeric(A,B,C);
+}
+
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3>
+void multiply_numeric(const Matrix1& A,
+                      const Matrix2& B,
+                            Matrix3& C,
+                      cusp::csr_format,
+                      cusp::csr_format,
+                      cusp::csr_format)
+{
+    cusp::detail::host::detail::spmm_csr_numeric(A,B,C);
+}
+
+///////////////////////////////////////
+// Masked Matrix-Matrix Multiplication //
+///////////////////////////////////////
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3,
+          typename Matrix4>
+void multiply_masked(const Matrix1& A,
+                     const Matrix2& B,
+                     const Matrix3& M,
+                           Matrix4& C,
+                     cusp::coo_format,
+                     cusp::coo_format,
+                     cusp::coo_format,
+                     cusp::coo_format)
+{
+    cusp::detail::host::detail::spmm_coo_masked(A,B,M,C);
+}
+
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3,
+          typename Matrix4>
+void multiply_masked(const Matrix1& A,
+                     const Matrix2& B,
+                     const Matrix3& M,
+                           Matrix4& C,
+                     cusp::csr_format,
+                     cusp::csr_format,
+                     cusp::csr_format,
+                     cusp::csr_format)
+{
+    cusp::detail::host::detail::spmm_csr_masked(A,B,M,C);
+}
+
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3,
+          typename Matrix4>
+void multiply_masked(const Matrix1& A,
+                     const Matrix2& B,
+                     const Matrix3& M,
+                           Matrix4& C,
+                     cusp::sparse_format,
+                     cusp::sparse_format,
+                     cusp::sparse_format,
+                     cusp::sparse_format)
+{
+    // other formats use CSR * CSR
+    cusp::csr_matrix<typename Matrix1::index_type,typename Matrix1::value_type,cusp::host_memory> A_(A);
+    cusp::csr_matrix<typename Matrix2::index_type,typename Matrix2::value_type,cusp::host_memory> B_(B);
+    cusp::csr_matrix<typename Matrix3::index_type,typename Matrix3::value_type,cusp::host_memory> M_(M);
+    cusp::csr_matrix<typename Matrix4::index_type,typename Matrix4::value_type,cusp::host_memory> C_;
+
+    cusp::detail::host::detail::spmm_csr_masked(A_,B_,M_,C_);
+
+    cusp::convert(C_, C);
+}
+
+//////////////////////
+// Galerkin Product //
+//////////////////////
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3,
+          typename Matrix4>
+void galerkin_product(const Matrix1& R,
+                      const Matrix2& A,
+                      const Matrix3& P,
+                            Matrix4& RAP,
+                      cusp::csr_format,
+                      cusp::csr_format,
+                      cusp::csr_format,
+                      cusp::csr_format)
+{
+    cusp::detail::host::detail::galerkin_product_csr(R,A,P,RAP);
+}
+
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3,
+          typename Matrix4>
+void galerkin_product(const Matrix1& R,
+                      const Matrix2& A,
+                      const Matrix3& P,
+                            Matrix4& RAP,
+                      cusp::sparse_format,
+                      cusp::sparse_format,
+                      cusp::sparse_format,
+                      cusp::sparse_format)
+{
+    // other formats use CSR * CSR * CSR
+    cusp::csr_matrix<typename Matrix1::index_type,typename Matrix1::value_type,cusp::host_memory> R_(R);
+    cusp::csr_matrix<typename Matrix2::index_type,typename Matrix2::value_type,cusp::host_memory> A_(A);
+    cusp::csr_matrix<typename Matrix3::index_type,typename Matrix3::value_type,cusp::host_memory> P_(P);
+    cusp::csr_matrix<typename Matrix4::index_type,typename Matrix4::value_type,cusp::host_memory> RAP_;
+
+    cusp::detail::host::detail::galerkin_product_csr(R_,A_,P_,RAP_);
+
+    cusp::convert(RAP_, RAP);
+}
+
+/////////////////////
+// Blocked Product //
+/////////////////////
+template <typename Matrix1,
+          typename Matrix2,
+          typename BlockFunction>
+void multiply_blocked(const Matrix1& A,
+                      const Matrix2& B,
+                            BlockFunction f,
+                      const size_t max_bytes,
+                      cusp::csr_format,
+                      cusp::csr_format)
+{
+    cusp::detail::host::detail::spmm_csr_blocked(A, B, f, max_bytes);
+}
+
+template <typename Matrix1,
+          typename Matrix2,
+          typename BlockFunction>
+void multiply_blocked(const Matrix1& A,
+                      const Matrix2& B,
+                            BlockFunction f,
+                      const size_t max_bytes,
+                      cusp::sparse_format,
+                      cusp::sparse_format)
+{
+    // other formats use CSR * CSR
+    cusp::csr_matrix<typename Matrix1::index_type,typename Matrix1::value_type,cusp::host_memory> A_(A);
+    cusp::csr_matrix<typename Matrix2::index_type,typename Matrix2::value_type,cusp::host_memory> B_(B);
+
+    cusp::detail::host::detail::spmm_csr_blocked(A_, B_, f, max_bytes);
+}
+
 /////////////////
 // Entry Point //
 /////////////////
@@ -246,6 +415,77 @@ void multiply(const Matrix&  A,
                                typename MatrixOrVector2::format());
 }
 
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3>
+void multiply_symbolic(const Matrix1& A,
+                       const Matrix2& B,
+                             Matrix3& C)
+{
+  cusp::detail::host::multiply_symbolic(A, B, C,
+                                        typename Matrix1::format(),
+                                        typename Matrix2::format(),
+                                        typename Matrix3::format());
+}
+
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3>
+void multiply_numeric(const Matrix1& A,
+                      const Matrix2& B,
+                            Matrix3& C)
+{
+  cusp::detail::host::multiply_numeric(A, B, C,
+                                       typename Matrix1::format(),
+                                       typename Matrix2::format(),
+                                       typename Matrix3::format());
+}
+
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3,
+          typename Matrix4>
+void galerkin_product(const Matrix1& R,
+                      const Matrix2& A,
+                      const Matrix3& P,
+                            Matrix4& RAP)
+{
+  cusp::detail::host::galerkin_product(R, A, P, RAP,
+                                       typename Matrix1::format(),
+                                       typename Matrix2::format(),
+                                       typename Matrix3::format(),
+                                       typename Matrix4::format());
+}
+
+template <typename Matrix1,
+          typename Matrix2,
+          typename BlockFunction>
+void multiply_blocked(const Matrix1& A,
+                      const Matrix2& B,
+                            BlockFunction f,
+                      const size_t max_bytes)
+{
+  cusp::detail::host::multiply_blocked(A, B, f, max_bytes,
+                                       typename Matrix1::format(),
+                                       typename Matrix2::format());
+}
+
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3,
+          typename Matrix4>
+void multiply_masked(const Matrix1& A,
+                     const Matrix2& B,
+                     const Matrix3& M,
+                           Matrix4& C)
+{
+  cusp::detail::host::multiply_masked(A, B, M, C,
+                                      typename Matrix1::format(),
+                                      typename Matrix2::format(),
+                                      typename Matrix3::format(),
+                                      typename Matrix4::format());
+}
+
 } // end namespace host
 } // end namespace detail
 } // end namespace cusp
@@ -0,0 +1,201 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file parallel.h
+ *  \brief Thread partitioning helpers for host algorithms
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
+// Host algorithms are multithreaded with OpenMP when the translation unit
+// is compiled with OpenMP enabled (backend=omp or hostomp=1).  Without
+// OpenMP the pragmas are ignored and every parallel region below executes
+// on a single thread, so the same code path serves both configurations.
+
+namespace cusp
+{
+namespace detail
+{
+namespace host
+{
+
+// minimum amount of work (rows, entries, ...) worth handing to a thread
+const size_t parallel_grain_size = 4096;
+
+inline size_t max_threads(void)
+{
+#if defined(_OPENMP)
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+// number of threads to launch for a given amount of work
+inline size_t num_threads(const size_t work, const size_t grain_size = parallel_grain_size)
+{
+    return std::max<size_t>(1, std::min<size_t>(max_threads(), work / std::max<size_t>(1, grain_size)));
+}
+
+// index of the calling thread within the current parallel region
+inline size_t thread_num(void)
+{
+#if defined(_OPENMP)
+    return omp_get_thread_num();
+#else
+    return 0;
+#endif
+}
+
+// number of threads executing the current parallel region
+inline size_t team_size(void)
+{
+#if defined(_OPENMP)
+    return omp_get_num_threads();
+#else
+    return 1;
+#endif
+}
+
+// Static partition of [0,n) into num_parts contiguous blocks.  All host
+// kernels use this scheme so that a thread touches the same range of a
+// vector in every pass (first-touch NUMA placement is preserved).
+inline size_t partition_begin(const size_t n, const size_t part, const size_t num_parts)
+{
+    return (n / num_parts) * part + std::min(part, n % num_parts);
+}
+
+// Partition of [0,n) into num_parts contiguous blocks of roughly equal weight,
+// where offsets is a non-decreasing array of n + 1 cumulative weights.
+template <typename Array>
+size_t weighted_partition_begin(const Array& offsets, const size_t part, const size_t num_parts)
+{
+    typedef typename Array::value_type OffsetType;
+
+    const size_t n = offsets.size() - 1;
+
+    if (part == 0)         return 0;
+    if (part >= num_parts) return n;
+
+    const double total  = double(offsets[n]) - double(offsets[0]);
+    const OffsetType target = offsets[0] + OffsetType(total * double(part) / double(num_parts));
+
+    const size_t i = std::lower_bound(offsets.begin(), offsets.end(), target) - offsets.begin();
+
+    return std::min(i, n);
+}
+
+// Convert an array of n counts (stored in the first n entries of an array
+// of length n + 1) into offsets in place: offsets[i] = sum(counts[0,i)) and
+// offsets[n] = sum(counts).  Returns the total.
+template <typename Array>
+typename Array::value_type counts_to_offsets(Array& offsets)
+{
+    typedef typename Array::value_type OffsetType;
+
+    const size_t n = offsets.size() - 1;
+
+    const size_t T = num_threads(n);
+
+    // partial sums of each thread's block
+    std::vector<OffsetType> partials(T + 1, OffsetType(0));
+
+    OffsetType total = 0;
+
+    #pragma omp parallel num_threads(T)
+    {
+        const size_t tid  = thread_num();
+        const size_t size = team_size();
+
+        const size_t begin = partition_begin(n, tid, size);
+        const size_t end   = partition_begin(n, tid + 1, size);
+
+        OffsetType sum = 0;
+        for (size_t i = begin; i < end; i++)
+            sum += offsets[i];
+        partials[tid + 1] = sum;
+
+        #pragma omp barrier
+
+        #pragma omp single
+        {
+            for (size_t t = 0; t < size; t++)
+                partials[t + 1] += partials[t];
+
+            total = partials[size];
+        }
+
+        sum = partials[tid];
+        for (size_t i = begin; i < end; i++)
+        {
+            OffsetType temp = offsets[i];
+            offsets[i] = sum;
+            sum += temp;
+        }
+    }
+
+    offsets[n] = total;
+
+    return total;
+}
+
+// Atomically add value to x and return the previous value of x.  Compilers
+// without OpenMP 3.1 atomic capture fall back to a critical section.
+template <typename T>
+T fetch_and_add(T& x, const T value)
+{
+    T previous;
+
+#if defined(_OPENMP) && (_OPENMP >= 201107)
+    #pragma omp atomic capture
+    { previous = x; x += value; }
+#else
+    #pragma omp critical (cusp_fetch_and_add)
+    { previous = x; x += value; }
+#endif
+
+    return previous;
+}
+
+// Fill an array in parallel, each thread writing its static partition
+template <typename Array, typename T>
+void parallel_fill(Array& array, const T& value)
+{
+    const size_t n = array.size();
+
+    #pragma omp parallel num_threads(num_threads(n))
+    {
+        const size_t begin = partition_begin(n, thread_num(),     team_size());
+        const size_t end   = partition_begin(n, thread_num() + 1, team_size());
+
+        std::fill(array.begin() + begin, array.begin() + end, value);
+    }
+}
+
+} // end namespace host
+} // end namespace detail
+} // end namespace cusp
+
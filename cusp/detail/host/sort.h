@@ -0,0 +1,258 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file sort.h
+ *  \brief Parallel radix sort of sparse matrix coordinates on the host
+ */
+
+#pragma once
+
+#include <cusp/array1d.h>
+
+#include <cusp/detail/host/parallel.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace cusp
+{
+namespace detail
+{
+namespace host
+{
+namespace detail
+{
+
+typedef unsigned long long coordinate_key;
+
+// bits sorted per pass of the radix sort
+const size_t radix_bits_per_pass = 8;
+const size_t radix_buckets       = 1 << radix_bits_per_pass;
+
+// number of bits needed to represent n
+inline size_t significant_bits(coordinate_key n)
+{
+    size_t bits = 0;
+
+    while (n != 0)
+    {
+        bits++;
+        n >>= 1;
+    }
+
+    return bits;
+}
+
+// Single scan over the coordinates that finds the largest row and column
+// index, whether any index is negative and whether the entries are already
+// sorted by (row, column).
+template <typename Array1, typename Array2>
+void coordinate_range(const size_t N,
+                      const Array1& rows, const Array2& columns,
+                      coordinate_key& max_row, coordinate_key& max_column,
+                      bool& negative, bool& sorted)
+{
+    const size_t T = num_threads(N);
+
+    std::vector<coordinate_key> thread_max_row(T, 0);
+    std::vector<coordinate_key> thread_max_column(T, 0);
+
+    negative = false;
+    sorted   = true;
+
+    #pragma omp parallel num_threads(T) reduction(|| : negative) reduction(&& : sorted)
+    {
+        const size_t tid   = thread_num();
+        const size_t begin = partition_begin(N, tid,     team_size());
+        const size_t end   = partition_begin(N, tid + 1, team_size());
+
+        coordinate_key r_max = 0;
+        coordinate_key c_max = 0;
+
+        for(size_t n = begin; n < end; n++)
+        {
+            if (rows[n] < 0 || columns[n] < 0)
+            {
+                negative = true;
+                continue;
+            }
+
+            r_max = std::max<coordinate_key>(r_max, rows[n]);
+            c_max = std::max<coordinate_key>(c_max, columns[n]);
+
+            if (n > 0 && (rows[n] < rows[n - 1] || (rows[n] == rows[n - 1] && columns[n] < columns[n - 1])))
+                sorted = false;
+        }
+
+        thread_max_row[tid]    = r_max;
+        thread_max_column[tid] = c_max;
+    }
+
+    max_row    = *std::max_element(thread_max_row.begin(),    thread_max_row.end());
+    max_column = *std::max_element(thread_max_column.begin(), thread_max_column.end());
+}
+
+// One stable counting pass of the radix sort on the digit at the given
+// shift.  Each thread histograms a contiguous block of keys; the histograms
+// are scanned in (digit, thread) order and every thread scatters its block,
+// so the pass is stable.  When all keys share the same digit nothing is
+// moved and false is returned.
+template <typename KeyArray1, typename ValueArray1,
+          typename KeyArray2, typename ValueArray2>
+bool radix_sort_pass(const size_t N, const size_t shift,
+                     const KeyArray1& keys_in,  const ValueArray1& values_in,
+                           KeyArray2& keys_out,       ValueArray2& values_out)
+{
+    const size_t T = num_threads(N);
+
+    std::vector<size_t> counts(T * radix_buckets);
+
+    bool skip = false;
+
+    #pragma omp parallel num_threads(T)
+    {
+        const size_t tid  = thread_num();
+        const size_t size = team_size();
+
+        const size_t begin = partition_begin(N, tid,     size);
+        const size_t end   = partition_begin(N, tid + 1, size);
+
+        size_t * count = &counts[tid * radix_buckets];
+
+        std::fill(count, count + radix_buckets, size_t(0));
+
+        for(size_t n = begin; n < end; n++)
+            count[(keys_in[n] >> shift) & (radix_buckets - 1)]++;
+
+        #pragma omp barrier
+
+        #pragma omp single
+        {
+            size_t sum = 0;
+
+            for(size_t d = 0; d < radix_buckets; d++)
+            {
+                const size_t first = sum;
+
+                for(size_t t = 0; t < size; t++)
+                {
+                    size_t temp = counts[t * radix_buckets + d];
+                    counts[t * radix_buckets + d] = sum;
+                    sum += temp;
+                }
+
+                if (sum - first == N)
+                    skip = true;
+            }
+        }
+
+        if (!skip)
+        {
+            for(size_t n = begin; n < end; n++)
+            {
+                const size_t dest = count[(keys_in[n] >> shift) & (radix_buckets - 1)]++;
+
+                keys_out[dest]   = keys_in[n];
+                values_out[dest] = values_in[n];
+            }
+        }
+    }
+
+    return !skip;
+}
+
+} // end namespace detail
+
+// Sort coordinate arrays by (row, column) with a parallel LSD radix sort.
+// Each coordinate is packed into a 64-bit key holding only the bits needed
+// for the largest row and column index, so a matrix with R rows and C
+// columns takes ceil((log2 R + log2 C) / 8) passes, fewer when a digit is
+// the same for every key.  Values travel with the keys, so no permutation
+// is gathered.  Input that is already sorted is detected during the initial
+// scan and left untouched.  Returns false, without modifying the arrays, if
+// the coordinates cannot be packed (negative indices, more than 64 bits, or
+// column indices that need all 64 bits).
+template <typename Array1, typename Array2, typename Array3>
+bool radix_sort_by_row_and_column(Array1& rows, Array2& columns, Array3& values)
+{
+    typedef typename Array1::value_type IndexType;
+    typedef typename Array2::value_type ColumnType;
+    typedef typename Array3::value_type ValueType;
+    typedef detail::coordinate_key      KeyType;
+
+    const size_t N = rows.size();
+
+    KeyType max_row, max_column;
+    bool negative, sorted;
+
+    detail::coordinate_range(N, rows, columns, max_row, max_column, negative, sorted);
+
+    if (negative)
+        return false;
+
+    if (sorted)
+        return true;
+
+    const size_t column_bits = detail::significant_bits(max_column);
+    const size_t key_bits    = detail::significant_bits(max_row) + column_bits;
+
+    // a shift by the full width of the key is undefined
+    if (key_bits > 8 * sizeof(KeyType) || column_bits == 8 * sizeof(KeyType))
+        return false;
+
+    const KeyType column_mask = (KeyType(1) << column_bits) - 1;
+
+    cusp::array1d<KeyType,cusp::host_memory>   keys(N);
+    cusp::array1d<KeyType,cusp::host_memory>   temp_keys(N);
+    cusp::array1d<ValueType,cusp::host_memory> temp_values(N);
+
+    #pragma omp parallel for num_threads(num_threads(N))
+    for(long n = 0; n < long(N); n++)
+        keys[n] = (KeyType(rows[n]) << column_bits) | KeyType(columns[n]);
+
+    // the current keys and values are in (keys, values) or, after an odd
+    // number of passes, in (temp_keys, temp_values)
+    bool in_temp = false;
+
+    for(size_t shift = 0; shift < key_bits; shift += detail::radix_bits_per_pass)
+    {
+        bool moved = in_temp ?
+            detail::radix_sort_pass(N, shift, temp_keys, temp_values, keys, values) :
+            detail::radix_sort_pass(N, shift, keys, values, temp_keys, temp_values);
+
+        if (moved)
+            in_temp = !in_temp;
+    }
+
+    const cusp::array1d<KeyType,cusp::host_memory>& sorted_keys = in_temp ? temp_keys : keys;
+
+    #pragma omp parallel for num_threads(num_threads(N))
+    for(long n = 0; n < long(N); n++)
+    {
+        rows[n]    = IndexType(sorted_keys[n] >> column_bits);
+        columns[n] = ColumnType(sorted_keys[n] & column_mask);
+
+        if (in_temp)
+            values[n] = temp_values[n];
+    }
+
+    return true;
+}
+
+} // end namespace host
+} // end namespace detail
+} // end namespace cusp
+
@@ -22,6 +22,7 @@
 
 #include <cusp/detail/utils.h>
 #include <cusp/detail/format_utils.h>
+#include <cusp/detail/host/detail/coo.h>
 
 #include <thrust/functional.h>
 #include <thrust/gather.h>
@@ -44,33 +45,18 @@ void transpose(const MatrixType1& A, MatrixType2& At,
                cusp::coo_format,
                cusp::coo_format)
 {
+    typedef typename MatrixType2::index_type   IndexType;
+
     At.resize(A.num_cols, A.num_rows, A.num_entries);
 
-    typedef typename MatrixType2::index_type   IndexType;
-    
-    cusp::array1d<IndexType,cusp::host_memory> starting_pos(A.num_cols+1, 0);
-
-    if( A.num_entries > 0 )
-    {
-	for( size_t i = 0; i < A.num_entries; i++ )
-        {
-	   IndexType col = A.column_indices[i];
-	   starting_pos[col+1]++;
-        }
-
-	for( size_t i = 1; i < A.num_cols+1; i++ )
-	   starting_pos[i] += starting_pos[i-1];
-
-	for( size_t i = 0; i < A.num_entries; i++ )
-        {
-	   IndexType col = A.column_indices[i];
-           IndexType j = starting_pos[col]++;
-
-	   At.row_indices[j] = A.column_indices[i];
-	   At.column_indices[j] = A.row_indices[i];
-	   At.values[j] = A.values[i];
-        }
-    }
+    cusp::array1d<IndexType,cusp::host_memory> At_row_offsets(A.num_cols + 1);
+
+    cusp::detail::host::detail::coo_transpose
+        (A.num_rows, A.num_cols, A.num_entries,
+         A.row_indices, A.column_indices, A.values,
+         At_row_offsets, At.column_indices, At.values);
+
+    cusp::detail::host::detail::expand_row_offsets(At.num_rows, At_row_offsets, At.row_indices);
 }
 
 // CSR format
@@ -79,41 +65,18 @@ void transpose(const MatrixType1& A, MatrixType2& At,
                cusp::csr_format,
                cusp::csr_format)
 {
-    typedef typename MatrixType2::index_type   IndexType;
+    typedef typename MatrixType1::index_type   IndexType;
 
     At.resize(A.num_cols, A.num_rows, A.num_entries);
 
-    if( A.num_entries > 0 )
-    {
-	for( size_t i = 0; i < At.num_rows+1; i++ )
-	   At.row_offsets[i] = 0;
-
-	for( size_t i = 0; i < At.num_entries; i++ )
-	{
-	   IndexType col = A.column_indices[i];
-	   At.row_offsets[col+1]++;
-	}
-
-	for( size_t i = 1; i < At.num_rows+1; i++ )
-	   At.row_offsets[i] += At.row_offsets[i-1];
-
-	cusp::array1d<IndexType,cusp::host_memory> starting_pos( At.row_offsets );
-
-	for( size_t row = 0; row < A.num_rows; row++ )
-	{
-	   IndexType row_start = A.row_offsets[row];
-	   IndexType row_end   = A.row_offsets[row+1];
-
-	   for( IndexType i = row_start; i < row_end; i++ )
-           {
-	      IndexType col = A.column_indices[i];
-              IndexType j   = starting_pos[col]++;
-
-	      At.column_indices[j] = row;
-	      At.values[j] = A.values[i];
-           }
-	}
-    }
+    cusp::array1d<IndexType,cusp::host_memory> A_row_indices(A.num_entries);
+
+    cusp::detail::host::detail::expand_row_offsets(A.num_rows, A.row_offsets, A_row_indices);
+
+    cusp::detail::host::detail::coo_transpose
+        (A.num_rows, A.num_cols, A.num_entries,
+         A_row_indices, A.column_indices, A.values,
+         At.row_offsets, At.column_indices, At.values);
 }
 
 } // end namespace host
@@ -16,6 +16,7 @@
 
 #include <cusp/detail/dispatch/multiply.h>
 
+#include <cusp/exception.h>
 #include <cusp/linear_operator.h>
 #include <thrust/detail/type_traits.h>
 
@@ -71,5 +72,95 @@ void multiply(LinearOperator&  A,
                          typename LinearOperator::format());
 }
 
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3>
+void multiply_symbolic(const Matrix1& A,
+                       const Matrix2& B,
+                             Matrix3& C)
+{
+  CUSP_PROFILE_SCOPED();
+
+  if(A.num_cols != B.num_rows)
+    throw cusp::invalid_input_exception("matrix dimensions do not match");
+
+  cusp::detail::dispatch::multiply_symbolic(A, B, C,
+                                            typename Matrix1::memory_space(),
+                                            typename Matrix2::memory_space(),
+                                            typename Matrix3::memory_space());
+}
+
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3,
+          typename Matrix4>
+void multiply_masked(const Matrix1& A,
+                     const Matrix2& B,
+                     const Matrix3& M,
+                           Matrix4& C)
+{
+  CUSP_PROFILE_SCOPED();
+
+  if(A.num_cols != B.num_rows || M.num_rows != A.num_rows || M.num_cols != B.num_cols)
+    throw cusp::invalid_input_exception("matrix dimensions do not match");
+
+  cusp::detail::dispatch::multiply_masked(A, B, M, C,
+                                          typename Matrix1::memory_space());
+}
+
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3,
+          typename Matrix4>
+void galerkin_product(const Matrix1& R,
+                      const Matrix2& A,
+                      const Matrix3& P,
+                            Matrix4& RAP)
+{
+  CUSP_PROFILE_SCOPED();
+
+  if(R.num_cols != A.num_rows || A.num_cols != P.num_rows)
+    throw cusp::invalid_input_exception("matrix dimensions do not match");
+
+  cusp::detail::dispatch::galerkin_product(R, A, P, RAP,
+                                           typename Matrix2::memory_space());
+}
+
+template <typename Matrix1,
+          typename Matrix2,
+          typename BlockFunction>
+void multiply_blocked(const Matrix1& A,
+                      const Matrix2& B,
+                            BlockFunction f,
+                      const size_t max_bytes)
+{
+  CUSP_PROFILE_SCOPED();
+
+  if(A.num_cols != B.num_rows)
+    throw cusp::invalid_input_exception("matrix dimensions do not match");
+
+  cusp::detail::dispatch::multiply_blocked(A, B, f, max_bytes,
+                                           typename Matrix1::memory_space(),
+                                           typename Matrix2::memory_space());
+}
+
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3>
+void multiply_numeric(const Matrix1& A,
+                      const Matrix2& B,
+                            Matrix3& C)
+{
+  CUSP_PROFILE_SCOPED();
+
+  if(A.num_cols != B.num_rows)
+    throw cusp::invalid_input_exception("matrix dimensions do not match");
+
+  cusp::detail::dispatch::multiply_numeric(A, B, C,
+                                           typename Matrix1::memory_space(),
+                                           typename Matrix2::memory_space(),
+                                           typename Matrix3::memory_space());
+}
+
 } // end namespace cusp
 
@@ -0,0 +1,131 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#include <cusp/array1d.h>
+#include <cusp/exception.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/multiply.h>
+
+#include <cusp/detail/host/parallel.h>
+
+namespace cusp
+{
+namespace graph
+{
+namespace detail
+{
+
+////////////////
+// Host Paths //
+////////////////
+
+template <typename Matrix>
+size_t triangle_count(const Matrix& A,
+                      cusp::csr_format, cusp::host_memory)
+{
+  using namespace cusp::detail::host;
+
+  typedef typename Matrix::index_type IndexType;
+
+  const size_t N = A.num_rows;
+
+  // strictly lower triangular part of A with unit values
+  cusp::csr_matrix<IndexType,IndexType,cusp::host_memory> L(N, N, 0);
+
+  #pragma omp parallel for num_threads(num_threads(N))
+  for (long i = 0; i < long(N); i++)
+  {
+    IndexType count = 0;
+
+    for (IndexType jj = A.row_offsets[i]; jj < A.row_offsets[i + 1]; jj++)
+      if (A.column_indices[jj] < i)
+        count++;
+
+    L.row_offsets[i] = count;
+  }
+
+  size_t num_entries = counts_to_offsets(L.row_offsets);
+
+  L.resize(N, N, num_entries);
+
+  #pragma omp parallel for num_threads(num_threads(N))
+  for (long i = 0; i < long(N); i++)
+  {
+    IndexType n = L.row_offsets[i];
+
+    for (IndexType jj = A.row_offsets[i]; jj < A.row_offsets[i + 1]; jj++)
+    {
+      if (A.column_indices[jj] < i)
+      {
+        L.column_indices[n] = A.column_indices[jj];
+        L.values[n]         = 1;
+        n++;
+      }
+    }
+  }
+
+  // C(i,j) is the number of triangles i > k > j that close edge (i,j)
+  cusp::csr_matrix<IndexType,IndexType,cusp::host_memory> C;
+  cusp::multiply_masked(L, L, L, C);
+
+  size_t num_triangles = 0;
+
+  #pragma omp parallel for num_threads(num_threads(C.num_entries)) reduction(+ : num_triangles)
+  for (long n = 0; n < long(C.num_entries); n++)
+    num_triangles += C.values[n];
+
+  return num_triangles;
+}
+
+//////////////////
+// General Path //
+//////////////////
+
+template <typename Matrix,
+          typename Format, typename MemorySpace>
+size_t triangle_count(const Matrix& A,
+                      Format, MemorySpace)
+{
+  typedef typename Matrix::index_type   IndexType;
+  typedef typename Matrix::value_type   ValueType;
+
+  // convert matrix to CSR format and compute on the host
+  cusp::csr_matrix<IndexType,ValueType,cusp::host_memory> A_csr(A);
+
+  return cusp::graph::triangle_count(A_csr);
+}
+
+} // end namespace detail
+
+/////////////////
+// Entry Point //
+/////////////////
+
+template <typename Matrix>
+size_t triangle_count(const Matrix& A)
+{
+    CUSP_PROFILE_SCOPED();
+
+    if(A.num_rows != A.num_cols)
+        throw cusp::invalid_input_exception("matrix must be square");
+
+    return cusp::graph::detail::triangle_count(A, typename Matrix::format(), typename Matrix::memory_space());
+}
+
+} // end namespace graph
+} // end namespace cusp
+
@@ -0,0 +1,63 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+/*! \file triangle_count.h
+ *  \brief Number of triangles in a graph
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+namespace cusp
+{
+namespace graph
+{
+/*! \addtogroup algorithms Algorithms
+ *  \ingroup algorithms
+ *  \{
+ */
+
+/*! \p triangle_count : counts the triangles of an undirected graph.  A
+ * triangle is a set of three vertices that are pairwise adjacent.
+ *
+ * The graph is given by the sparsity pattern of a symmetric matrix; values
+ * and diagonal entries are ignored.  With \p L the strictly lower triangular
+ * part of \p A, the number of triangles is the sum of the entries of the
+ * masked product <tt>(L * L) .* L</tt>, which counts every triangle once.
+ * The product is computed with \p cusp::multiply_masked, so the full
+ * product <tt>L * L</tt> is never formed.
+ *
+ * \param A symmetric matrix that represents a graph
+ *
+ * \tparam Matrix matrix
+ *
+ * \return the number of triangles in the graph
+ *
+ *  \see http://en.wikipedia.org/wiki/Triangle_graph
+ */
+template <typename Matrix>
+size_t triangle_count(const Matrix& A);
+
+/*! \}
+ */
+
+
+} // end namespace graph
+} // end namespace cusp
+
+#include <cusp/graph/detail/triangle_count.inl>
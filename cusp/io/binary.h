@@ -0,0 +1,224 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file binary.h
+ *  \brief Binary file I/O
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/io/detail/binary.h>
+#include <cusp/io/detail/mapped_file.h>
+
+#include <string>
+
+namespace cusp
+{
+namespace io
+{
+
+/*! \addtogroup input_output Input/Output
+ *  \addtogroup binary Binary
+ *  \ingroup input_output
+ *  \{
+ */
+
+/*! \p write_binary_file : Write a matrix or array to a cusp binary file
+ *
+ * The binary format stores the arrays of any cusp container exactly as
+ * they are held in memory, together with the format, the index and value
+ * types, the dimensions and a checksum of each array.  Every array is
+ * aligned to 64 bytes so the file can be used in place by \p binary_file.
+ *
+ * \param mtx a matrix container (e.g. \p csr_matrix or \p array1d)
+ * \param filename file name of the binary file
+ * \tparam Matrix matrix container
+ *
+ * \note if the file already exists it will be overwritten
+ * \note binary files are only portable between machines with the same byte order
+ *
+ * \code
+ * #include <cusp/io/binary.h>
+ * #include <cusp/gallery/poisson.h>
+ * #include <cusp/csr_matrix.h>
+ *
+ * int main(void)
+ * {
+ *     cusp::csr_matrix<int, float, cusp::host_memory> A;
+ *     cusp::gallery::poisson5pt(A, 100, 100);
+ *
+ *     // save A into a binary file
+ *     cusp::io::write_binary_file(A, "A.bin");
+ *
+ *     return 0;
+ * }
+ * \endcode
+ *
+ * \see \p read_binary_file
+ * \see \p binary_file
+ */
+template <typename Matrix>
+void write_binary_file(const Matrix& mtx, const std::string& filename);
+
+/*! \p write_binary_stream : Write a matrix or array to a stream in the
+ * cusp binary format.
+ *
+ * \param mtx a matrix container (e.g. \p csr_matrix or \p array1d)
+ * \param output stream to which the binary contents will be written
+ * \tparam Matrix matrix container
+ * \tparam Stream stream type
+ *
+ * \see \p write_binary_file
+ */
+template <typename Matrix, typename Stream>
+void write_binary_stream(const Matrix& mtx, Stream& output);
+
+/*! \p read_binary_file : Read a cusp binary file into a container
+ *
+ * The matrix is converted to the format of \p mtx if the file holds a
+ * different format.  The index and value types of the file must match
+ * those of \p mtx.
+ *
+ * \param mtx a matrix container (e.g. \p csr_matrix or \p array1d)
+ * \param filename file name of the binary file
+ * \tparam Matrix matrix container
+ *
+ * \throws cusp::io_exception if the file is damaged or its types do not match \p mtx
+ *
+ * \note any contents of \p mtx will be overwritten
+ *
+ * \see \p write_binary_file
+ * \see \p binary_file
+ */
+template <typename Matrix>
+void read_binary_file(Matrix& mtx, const std::string& filename);
+
+/*! \p read_binary_stream : Read cusp binary data from a stream into a
+ * container.
+ *
+ * \param mtx a matrix container (e.g. \p csr_matrix or \p array1d)
+ * \param input stream from which to read the binary contents
+ * \tparam Matrix matrix container
+ * \tparam Stream stream type
+ *
+ * \see \p read_binary_file
+ */
+template <typename Matrix, typename Stream>
+void read_binary_stream(Matrix& mtx, Stream& input);
+
+/*! \p binary_file : Read-only memory mapping of a cusp binary file
+ *
+ * Opening a \p binary_file only maps the file and checks its header, so
+ * its contents are available immediately regardless of the size of the
+ * matrix.  Pages are read from disk when they are first accessed.
+ *
+ * The matrix is accessed through host views whose arrays point into the
+ * mapping, such as a \p csr_matrix_view or \p coo_matrix_view of
+ * <tt>array1d_view<const IndexType *></tt> arrays.  Views of
+ * \p array1d_view, \p array2d_view, \p coo_matrix_view and
+ * \p csr_matrix_view are supported; other formats can be read with
+ * \p read_binary_file.  The views remain valid for the lifetime of the
+ * \p binary_file.
+ *
+ * Only the header is checked when the file is opened.  Use \p verify to
+ * compare the contents of the arrays to their checksums.
+ *
+ * \code
+ * #include <cusp/io/binary.h>
+ * #include <cusp/csr_matrix.h>
+ * #include <cusp/multiply.h>
+ *
+ * int main(void)
+ * {
+ *     typedef cusp::array1d_view<const int *>   IndexArray;
+ *     typedef cusp::array1d_view<const float *> ValueArray;
+ *
+ *     // map A.bin (written by write_binary_file) into memory
+ *     cusp::io::binary_file file("A.bin");
+ *
+ *     // view the CSR matrix in place
+ *     cusp::csr_matrix_view<IndexArray, IndexArray, ValueArray> A;
+ *     file.view(A);
+ *
+ *     cusp::array1d<float, cusp::host_memory> x(A.num_cols, 1);
+ *     cusp::array1d<float, cusp::host_memory> y(A.num_rows);
+ *
+ *     cusp::multiply(A, x, y);
+ *
+ *     return 0;
+ * }
+ * \endcode
+ *
+ * \see \p write_binary_file
+ */
+class binary_file
+{
+  cusp::io::detail::mapped_file   file;
+  cusp::io::detail::binary_header header;
+
+  // not copyable
+  binary_file(const binary_file&);
+  binary_file& operator=(const binary_file&);
+
+  public:
+  /*! Map a binary file into memory and check its header.
+   *
+   * \param filename file name of the binary file
+   *
+   * \throws cusp::io_exception if the file is not a valid binary file
+   */
+  explicit binary_file(const std::string& filename);
+
+  /*! Number of rows of the matrix (the size of an \p array1d)
+   */
+  size_t num_rows(void) const;
+
+  /*! Number of columns of the matrix
+   */
+  size_t num_cols(void) const;
+
+  /*! Number of entries of the matrix
+   */
+  size_t num_entries(void) const;
+
+  /*! Compare the arrays of the file to their checksums.
+   *
+   * \throws cusp::io_exception if the contents of the file are damaged
+   */
+  void verify(void) const;
+
+  /*! Point a view to the matrix stored in the file.
+   *
+   * \param v view whose arrays are \p array1d_view of const pointers
+   * \tparam View view type
+   *
+   * \throws cusp::io_exception if the file holds a different format or the
+   * types of the file do not match those of \p v
+   */
+  template <typename View>
+  void view(View& v) const;
+};
+
+/*! \}
+ */
+
+} //end namespace io
+} //end namespace cusp
+
+#include <cusp/io/detail/binary.inl>
+
@@ -0,0 +1,344 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file binary.h
+ *  \brief Layout of the cusp binary container format
+ */
+
+#pragma once
+
+#include <cusp/complex.h>
+#include <cusp/exception.h>
+
+#include <cusp/detail/host/parallel.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace cusp
+{
+namespace io
+{
+namespace detail
+{
+
+// A binary file consists of a fixed size header followed by the arrays of
+// the matrix.  Every array starts on a 64 byte boundary and is stored in
+// the native byte order, so a mapping of the file can be used in place.
+//
+//   format     arrays (number of elements)
+//   ---------  ----------------------------------------------------------
+//   array1d    values (num_rows)
+//   array2d    values (pitch * major dimension)
+//   coo        row_indices, column_indices, values (num_entries)
+//   csr        row_offsets (num_rows + 1), column_indices, values (num_entries)
+//   dia        diagonal_offsets (num_diagonals), values (pitch * num_diagonals)
+//   ell        column_indices, values (pitch * num_entries_per_row)
+//   hyb        ell column_indices, ell values (pitch * num_entries_per_row),
+//              coo row_indices, coo column_indices, coo values (num_coo_entries)
+//
+// The parameters of the header hold the pitch and the other dimensions of
+// the dia, ell and hyb formats.  Each array has its own checksum and the
+// header has a checksum of everything that precedes it.
+
+typedef unsigned long long binary_word;
+
+const binary_word binary_version    = 1;
+const binary_word binary_byte_order = 0x0102030405060708ULL;
+const size_t      binary_alignment  = 64;
+const size_t      binary_max_arrays = 8;
+
+enum binary_format_code
+{
+  binary_array1d = 1,
+  binary_array2d = 2,
+  binary_coo     = 3,
+  binary_csr     = 4,
+  binary_dia     = 5,
+  binary_ell     = 6,
+  binary_hyb     = 7
+};
+
+enum binary_orientation_code
+{
+  binary_no_orientation = 0,
+  binary_row_major      = 1,
+  binary_column_major   = 2
+};
+
+enum binary_element_kind
+{
+  binary_signed_integer   = 1,
+  binary_unsigned_integer = 2,
+  binary_real             = 3,
+  binary_complex          = 4
+};
+
+template <typename T>
+struct binary_element
+{
+  static const binary_word kind =
+    std::numeric_limits<T>::is_integer ?
+      (std::numeric_limits<T>::is_signed ? binary_signed_integer : binary_unsigned_integer) :
+      binary_real;
+};
+
+template <typename T>
+struct binary_element< cusp::complex<T> >
+{
+  static const binary_word kind = binary_complex;
+};
+
+struct binary_array_entry
+{
+  binary_word offset;   // from the start of the file
+  binary_word size;     // in bytes
+  binary_word checksum;
+};
+
+struct binary_header
+{
+  char        magic[8];
+  binary_word version;
+  binary_word byte_order;
+  binary_word format;
+  binary_word orientation;
+  binary_word index_kind;
+  binary_word index_size;
+  binary_word value_kind;
+  binary_word value_size;
+  binary_word num_rows;
+  binary_word num_cols;
+  binary_word num_entries;
+  binary_word parameters[4];
+  binary_word num_arrays;
+  binary_array_entry arrays[binary_max_arrays];
+  binary_word header_checksum;
+};
+
+inline const char * binary_magic(void)
+{
+  return "CUSPBIN";
+}
+
+inline size_t binary_round_up(const size_t n)
+{
+  return (n + binary_alignment - 1) / binary_alignment * binary_alignment;
+}
+
+inline size_t binary_data_offset(void)
+{
+  return binary_round_up(sizeof(binary_header));
+}
+
+// FNV-1a over 64-bit words with four independent lanes
+inline binary_word binary_checksum_block(const char * data, const size_t size)
+{
+  const binary_word prime = 0x100000001b3ULL;
+
+  binary_word h[4] = { 0xcbf29ce484222325ULL, 0x84222325cbf29ce4ULL,
+                       0xcbf29ce484222325ULL ^ 1, 0x84222325cbf29ce4ULL ^ 1 };
+
+  size_t n = 0;
+
+  for(; n + 32 <= size; n += 32)
+  {
+    binary_word w[4];
+    std::memcpy(w, data + n, 32);
+
+    h[0] = (h[0] ^ w[0]) * prime;
+    h[1] = (h[1] ^ w[1]) * prime;
+    h[2] = (h[2] ^ w[2]) * prime;
+    h[3] = (h[3] ^ w[3]) * prime;
+  }
+
+  for(; n < size; n++)
+    h[0] = (h[0] ^ binary_word(static_cast<unsigned char>(data[n]))) * prime;
+
+  binary_word result = 0xcbf29ce484222325ULL;
+
+  for(size_t l = 0; l < 4; l++)
+    result = (result ^ h[l]) * prime;
+
+  return result;
+}
+
+// The data is hashed in fixed size blocks (in parallel) and the block
+// hashes are then combined in order, so the checksum does not depend on the
+// number of threads.
+inline binary_word binary_checksum(const char * data, const size_t size)
+{
+  using namespace cusp::detail::host;
+
+  const size_t block_size = 1 << 20;
+  const size_t num_blocks = (size + block_size - 1) / block_size;
+
+  std::vector<binary_word> hashes(num_blocks);
+
+  #pragma omp parallel for num_threads(num_threads(size, block_size))
+  for(long b = 0; b < long(num_blocks); b++)
+  {
+    const size_t begin = size_t(b) * block_size;
+    hashes[b] = binary_checksum_block(data + begin, std::min(block_size, size - begin));
+  }
+
+  binary_word result = 0xcbf29ce484222325ULL ^ binary_word(size);
+
+  for(size_t b = 0; b < num_blocks; b++)
+    result = (result ^ hashes[b]) * 0x100000001b3ULL;
+
+  return result;
+}
+
+inline binary_word binary_header_checksum(const binary_header& header)
+{
+  return binary_checksum(reinterpret_cast<const char *>(&header), offsetof(binary_header, header_checksum));
+}
+
+inline size_t binary_num_arrays(const binary_word format)
+{
+  switch(format)
+  {
+    case binary_array1d: return 1;
+    case binary_array2d: return 1;
+    case binary_coo:     return 3;
+    case binary_csr:     return 3;
+    case binary_dia:     return 2;
+    case binary_ell:     return 2;
+    case binary_hyb:     return 5;
+    default:             return 0;
+  }
+}
+
+// true if array k of the format holds indices rather than values
+inline bool binary_holds_indices(const binary_word format, const size_t k)
+{
+  switch(format)
+  {
+    case binary_coo: return k < 2;
+    case binary_csr: return k < 2;
+    case binary_dia: return k == 0;
+    case binary_ell: return k == 0;
+    case binary_hyb: return k != 1 && k != 4;
+    default:         return false;
+  }
+}
+
+// number of elements in array k
+inline binary_word binary_array_length(const binary_header& header, const size_t k)
+{
+  const binary_word * p = header.parameters;
+
+  switch(header.format)
+  {
+    case binary_array1d: return header.num_rows;
+    case binary_array2d: return p[0] * (header.orientation == binary_row_major ? header.num_rows : header.num_cols);
+    case binary_coo:     return header.num_entries;
+    case binary_csr:     return k == 0 ? header.num_rows + 1 : header.num_entries;
+    case binary_dia:     return k == 0 ? p[0] : p[1] * p[0];
+    case binary_ell:     return p[1] * p[0];
+    case binary_hyb:     return k < 2 ? p[1] * p[0] : p[3];
+    default:             return 0;
+  }
+}
+
+// size of the container described by header, including the padding of its
+// last array, so containers written one after another can be located
+inline size_t binary_size(const binary_header& header)
+{
+  size_t size = binary_data_offset();
+
+  for(size_t k = 0; k < header.num_arrays; k++)
+    size = std::max<size_t>(size, binary_round_up(header.arrays[k].offset + header.arrays[k].size));
+
+  return size;
+}
+
+inline void binary_error(const std::string& message)
+{
+  throw cusp::io_exception("invalid cusp binary file: " + message);
+}
+
+// check the header of the binary file [begin,end) and copy it to header
+inline void read_binary_header(binary_header& header, const char * begin, const char * end)
+{
+  const size_t size = end - begin;
+
+  if (size < sizeof(binary_header) || std::memcmp(begin, binary_magic(), 8) != 0)
+    binary_error("missing header");
+
+  std::memcpy(&header, begin, sizeof(binary_header));
+
+  if (header.byte_order != binary_byte_order)
+    binary_error("file was written with a different byte order");
+
+  if (header.version != binary_version)
+    binary_error("unsupported version");
+
+  if (header.header_checksum != binary_header_checksum(header))
+    binary_error("header checksum mismatch");
+
+  const size_t num_arrays = binary_num_arrays(header.format);
+
+  if (num_arrays == 0 || header.num_arrays != num_arrays)
+    binary_error("unknown matrix format");
+
+  if (header.format == binary_array2d)
+  {
+    const binary_word minor = header.orientation == binary_row_major ? header.num_cols : header.num_rows;
+
+    if ((header.orientation != binary_row_major && header.orientation != binary_column_major) || header.parameters[0] < minor)
+      binary_error("invalid array2d layout");
+  }
+
+  for(size_t k = 0; k < num_arrays; k++)
+  {
+    const binary_array_entry& array = header.arrays[k];
+
+    const binary_word element_size = binary_holds_indices(header.format, k) ? header.index_size : header.value_size;
+
+    if (array.offset % binary_alignment != 0 ||
+        array.offset < binary_data_offset() || array.offset > size || array.size > size - array.offset)
+      binary_error("array lies outside the file");
+
+    if (element_size == 0 || array.size != binary_array_length(header, k) * element_size)
+      binary_error("array size does not match the matrix dimensions");
+  }
+}
+
+// compare the checksums of the arrays to their contents
+inline void verify_binary_arrays(const binary_header& header, const char * begin)
+{
+  for(size_t k = 0; k < header.num_arrays; k++)
+    if (binary_checksum(begin + header.arrays[k].offset, header.arrays[k].size) != header.arrays[k].checksum)
+      binary_error("array checksum mismatch");
+}
+
+template <typename T>
+void check_binary_element(const binary_word kind, const binary_word size, const char * what)
+{
+  if (kind != binary_element<T>::kind || size != sizeof(T))
+    throw cusp::io_exception(std::string("cusp binary file ") + what + " type does not match");
+}
+
+} // end namespace detail
+} // end namespace io
+} // end namespace cusp
+
@@ -0,0 +1,540 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include <cusp/array1d.h>
+#include <cusp/array2d.h>
+#include <cusp/coo_matrix.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/dia_matrix.h>
+#include <cusp/ell_matrix.h>
+#include <cusp/hyb_matrix.h>
+#include <cusp/convert.h>
+#include <cusp/exception.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+namespace cusp
+{
+namespace io
+{
+namespace detail
+{
+
+inline binary_word binary_orientation(cusp::row_major)    { return binary_row_major; }
+inline binary_word binary_orientation(cusp::column_major) { return binary_column_major; }
+
+// collects the arrays of a host container and writes them to a stream
+class binary_writer
+{
+  binary_header header;
+  const char *  data[binary_max_arrays];
+
+  public:
+  binary_writer(binary_word format, size_t num_rows, size_t num_cols, size_t num_entries)
+  {
+    std::memset(&header, 0, sizeof(binary_header));
+    std::memcpy(header.magic, binary_magic(), 8);
+
+    header.version     = binary_version;
+    header.byte_order  = binary_byte_order;
+    header.format      = format;
+    header.num_rows    = num_rows;
+    header.num_cols    = num_cols;
+    header.num_entries = num_entries;
+  }
+
+  template <typename IndexType>
+  void index_type(void)
+  {
+    header.index_kind = binary_element<IndexType>::kind;
+    header.index_size = sizeof(IndexType);
+  }
+
+  template <typename ValueType>
+  void value_type(void)
+  {
+    header.value_kind = binary_element<ValueType>::kind;
+    header.value_size = sizeof(ValueType);
+  }
+
+  void orientation(binary_word orientation)
+  {
+    header.orientation = orientation;
+  }
+
+  void parameter(size_t n, binary_word value)
+  {
+    header.parameters[n] = value;
+  }
+
+  // the first length elements of a contiguous host array
+  template <typename Array>
+  void add(const Array& array, size_t length)
+  {
+    binary_array_entry& entry = header.arrays[header.num_arrays];
+
+    data[header.num_arrays] = length == 0 ? 0 : reinterpret_cast<const char *>(&array[0]);
+    entry.size              = length * sizeof(typename Array::value_type);
+
+    header.num_arrays++;
+  }
+
+  template <typename Stream>
+  void write(Stream& output)
+  {
+    const char padding[binary_alignment] = {0};
+
+    size_t offset = binary_data_offset();
+
+    for(size_t k = 0; k < header.num_arrays; k++)
+    {
+      binary_array_entry& entry = header.arrays[k];
+
+      entry.offset   = offset;
+      entry.checksum = binary_checksum(data[k], entry.size);
+
+      offset = binary_round_up(offset + entry.size);
+    }
+
+    header.header_checksum = binary_header_checksum(header);
+
+    output.write(reinterpret_cast<const char *>(&header), sizeof(binary_header));
+    output.write(padding, binary_data_offset() - sizeof(binary_header));
+
+    for(size_t k = 0; k < header.num_arrays; k++)
+    {
+      const size_t size = header.arrays[k].size;
+
+      if (size > 0)
+        output.write(data[k], size);
+
+      output.write(padding, binary_round_up(size) - size);
+    }
+
+    if (!output)
+      throw cusp::io_exception("unable to write cusp binary data");
+  }
+};
+
+template <typename Matrix>
+void describe_binary(binary_writer& writer, const Matrix& A, cusp::array1d_format)
+{
+  writer = binary_writer(binary_array1d, A.size(), 1, A.size());
+  writer.value_type<typename Matrix::value_type>();
+  writer.add(A, A.size());
+}
+
+template <typename Matrix>
+void describe_binary(binary_writer& writer, const Matrix& A, cusp::array2d_format)
+{
+  typedef typename Matrix::orientation Orientation;
+
+  writer = binary_writer(binary_array2d, A.num_rows, A.num_cols, A.num_entries);
+  writer.value_type<typename Matrix::value_type>();
+  writer.orientation(binary_orientation(Orientation()));
+  writer.parameter(0, A.pitch);
+  writer.add(A.values, A.pitch * cusp::detail::major_dimension(A.num_rows, A.num_cols, Orientation()));
+}
+
+template <typename Matrix>
+void describe_binary(binary_writer& writer, const Matrix& A, cusp::coo_format)
+{
+  writer = binary_writer(binary_coo, A.num_rows, A.num_cols, A.num_entries);
+  writer.index_type<typename Matrix::index_type>();
+  writer.value_type<typename Matrix::value_type>();
+  writer.add(A.row_indices,    A.num_entries);
+  writer.add(A.column_indices, A.num_entries);
+  writer.add(A.values,         A.num_entries);
+}
+
+template <typename Matrix>
+void describe_binary(binary_writer& writer, const Matrix& A, cusp::csr_format)
+{
+  writer = binary_writer(binary_csr, A.num_rows, A.num_cols, A.num_entries);
+  writer.index_type<typename Matrix::index_type>();
+  writer.value_type<typename Matrix::value_type>();
+  writer.add(A.row_offsets,    A.num_rows + 1);
+  writer.add(A.column_indices, A.num_entries);
+  writer.add(A.values,         A.num_entries);
+}
+
+template <typename Matrix>
+void describe_binary(binary_writer& writer, const Matrix& A, cusp::dia_format)
+{
+  const size_t num_diagonals = A.diagonal_offsets.size();
+
+  writer = binary_writer(binary_dia, A.num_rows, A.num_cols, A.num_entries);
+  writer.index_type<typename Matrix::index_type>();
+  writer.value_type<typename Matrix::value_type>();
+  writer.parameter(0, num_diagonals);
+  writer.parameter(1, A.values.pitch);
+  writer.add(A.diagonal_offsets, num_diagonals);
+  writer.add(A.values.values,    A.values.pitch * num_diagonals);
+}
+
+template <typename Matrix>
+void describe_binary(binary_writer& writer, const Matrix& A, cusp::ell_format)
+{
+  const size_t num_entries_per_row = A.column_indices.num_cols;
+  const size_t pitch               = A.column_indices.pitch;
+
+  if (A.values.pitch != pitch || A.values.num_cols != num_entries_per_row)
+    throw cusp::invalid_input_exception("ell_matrix column_indices and values have different shapes");
+
+  writer = binary_writer(binary_ell, A.num_rows, A.num_cols, A.num_entries);
+  writer.index_type<typename Matrix::index_type>();
+  writer.value_type<typename Matrix::value_type>();
+  writer.parameter(0, num_entries_per_row);
+  writer.parameter(1, pitch);
+  writer.add(A.column_indices.values, pitch * num_entries_per_row);
+  writer.add(A.values.values,         pitch * num_entries_per_row);
+}
+
+template <typename Matrix>
+void describe_binary(binary_writer& writer, const Matrix& A, cusp::hyb_format)
+{
+  const size_t num_entries_per_row = A.ell.column_indices.num_cols;
+  const size_t pitch               = A.ell.column_indices.pitch;
+
+  if (A.ell.values.pitch != pitch || A.ell.values.num_cols != num_entries_per_row)
+    throw cusp::invalid_input_exception("ell_matrix column_indices and values have different shapes");
+
+  writer = binary_writer(binary_hyb, A.num_rows, A.num_cols, A.num_entries);
+  writer.index_type<typename Matrix::index_type>();
+  writer.value_type<typename Matrix::value_type>();
+  writer.parameter(0, num_entries_per_row);
+  writer.parameter(1, pitch);
+  writer.parameter(2, A.ell.num_entries);
+  writer.parameter(3, A.coo.num_entries);
+  writer.add(A.ell.column_indices.values, pitch * num_entries_per_row);
+  writer.add(A.ell.values.values,         pitch * num_entries_per_row);
+  writer.add(A.coo.row_indices,           A.coo.num_entries);
+  writer.add(A.coo.column_indices,        A.coo.num_entries);
+  writer.add(A.coo.values,                A.coo.num_entries);
+}
+
+template <typename Matrix, typename Stream>
+void write_binary_stream(const Matrix& mtx, Stream& output, cusp::host_memory)
+{
+  binary_writer writer(0, 0, 0, 0);
+
+  describe_binary(writer, mtx, typename Matrix::format());
+
+  writer.write(output);
+}
+
+template <typename Matrix, typename Stream>
+void write_binary_stream(const Matrix& mtx, Stream& output, cusp::device_memory)
+{
+  // transfer to the host in the same format
+  typename Matrix::container::template rebind<cusp::host_memory>::type host(mtx);
+
+  write_binary_stream(host, output, cusp::host_memory());
+}
+
+// copy array k of the file into dst, which has the expected size
+template <typename Array>
+void copy_binary_array(Array& dst, const binary_header& header, const char * base, size_t k)
+{
+  typedef typename Array::value_type ValueType;
+
+  const ValueType * src = reinterpret_cast<const ValueType *>(base + header.arrays[k].offset);
+
+  std::copy(src, src + header.arrays[k].size / sizeof(ValueType), dst.begin());
+}
+
+template <typename ValueType>
+void read_binary_container(cusp::array1d<ValueType,cusp::host_memory>& A, const binary_header& header, const char * base)
+{
+  A.resize(header.num_rows);
+  copy_binary_array(A, header, base, 0);
+}
+
+template <typename ValueType, typename Orientation>
+void read_binary_container(cusp::array2d<ValueType,cusp::host_memory,Orientation>& A, const binary_header& header, const char * base)
+{
+  A.resize(header.num_rows, header.num_cols, header.parameters[0]);
+  copy_binary_array(A.values, header, base, 0);
+}
+
+template <typename IndexType, typename ValueType>
+void read_binary_container(cusp::coo_matrix<IndexType,ValueType,cusp::host_memory>& A, const binary_header& header, const char * base)
+{
+  A.resize(header.num_rows, header.num_cols, header.num_entries);
+  copy_binary_array(A.row_indices,    header, base, 0);
+  copy_binary_array(A.column_indices, header, base, 1);
+  copy_binary_array(A.values,         header, base, 2);
+}
+
+template <typename IndexType, typename ValueType>
+void read_binary_container(cusp::csr_matrix<IndexType,ValueType,cusp::host_memory>& A, const binary_header& header, const char * base)
+{
+  A.resize(header.num_rows, header.num_cols, header.num_entries);
+  copy_binary_array(A.row_offsets,    header, base, 0);
+  copy_binary_array(A.column_indices, header, base, 1);
+  copy_binary_array(A.values,         header, base, 2);
+}
+
+template <typename IndexType, typename ValueType>
+void read_binary_container(cusp::dia_matrix<IndexType,ValueType,cusp::host_memory>& A, const binary_header& header, const char * base)
+{
+  const size_t num_diagonals = header.parameters[0];
+  const size_t pitch         = header.parameters[1];
+
+  A.resize(header.num_rows, header.num_cols, header.num_entries, num_diagonals);
+  A.values.resize(header.num_rows, num_diagonals, pitch);
+  copy_binary_array(A.diagonal_offsets, header, base, 0);
+  copy_binary_array(A.values.values,    header, base, 1);
+}
+
+template <typename IndexType, typename ValueType>
+void read_binary_container(cusp::ell_matrix<IndexType,ValueType,cusp::host_memory>& A, const binary_header& header, const char * base)
+{
+  const size_t num_entries_per_row = header.parameters[0];
+  const size_t pitch               = header.parameters[1];
+
+  A.resize(header.num_rows, header.num_cols, header.num_entries, num_entries_per_row);
+  A.column_indices.resize(header.num_rows, num_entries_per_row, pitch);
+  A.values.resize(header.num_rows, num_entries_per_row, pitch);
+  copy_binary_array(A.column_indices.values, header, base, 0);
+  copy_binary_array(A.values.values,         header, base, 1);
+}
+
+template <typename IndexType, typename ValueType>
+void read_binary_container(cusp::hyb_matrix<IndexType,ValueType,cusp::host_memory>& A, const binary_header& header, const char * base)
+{
+  const size_t num_entries_per_row = header.parameters[0];
+  const size_t pitch               = header.parameters[1];
+
+  A.resize(header.num_rows, header.num_cols, header.parameters[2], header.parameters[3], num_entries_per_row);
+  A.ell.column_indices.resize(header.num_rows, num_entries_per_row, pitch);
+  A.ell.values.resize(header.num_rows, num_entries_per_row, pitch);
+  copy_binary_array(A.ell.column_indices.values, header, base, 0);
+  copy_binary_array(A.ell.values.values,         header, base, 1);
+  copy_binary_array(A.coo.row_indices,           header, base, 2);
+  copy_binary_array(A.coo.column_indices,        header, base, 3);
+  copy_binary_array(A.coo.values,                header, base, 4);
+}
+
+// read the contents of the file into a host container and move it to mtx
+template <typename Container, typename Matrix>
+void read_binary_as(Matrix& mtx, const binary_header& header, const char * base)
+{
+  Container temp;
+
+  read_binary_container(temp, header, base);
+
+  cusp::convert_inplace(temp, mtx);
+}
+
+template <typename Matrix, typename Format>
+void read_binary_buffer(Matrix& mtx, const char * begin, const char * end, Format)
+{
+  // general case
+  typedef typename Matrix::index_type IndexType;
+  typedef typename Matrix::value_type ValueType;
+
+  binary_header header;
+  read_binary_header(header, begin, end);
+  verify_binary_arrays(header, begin);
+
+  check_binary_element<ValueType>(header.value_kind, header.value_size, "value");
+
+  if (header.index_size != 0)
+    check_binary_element<IndexType>(header.index_kind, header.index_size, "index");
+
+  switch(header.format)
+  {
+    case binary_array2d:
+      if (header.orientation == binary_row_major)
+        read_binary_as< cusp::array2d<ValueType,cusp::host_memory,cusp::row_major> >(mtx, header, begin);
+      else
+        read_binary_as< cusp::array2d<ValueType,cusp::host_memory,cusp::column_major> >(mtx, header, begin);
+      break;
+    case binary_coo: read_binary_as< cusp::coo_matrix<IndexType,ValueType,cusp::host_memory> >(mtx, header, begin); break;
+    case binary_csr: read_binary_as< cusp::csr_matrix<IndexType,ValueType,cusp::host_memory> >(mtx, header, begin); break;
+    case binary_dia: read_binary_as< cusp::dia_matrix<IndexType,ValueType,cusp::host_memory> >(mtx, header, begin); break;
+    case binary_ell: read_binary_as< cusp::ell_matrix<IndexType,ValueType,cusp::host_memory> >(mtx, header, begin); break;
+    case binary_hyb: read_binary_as< cusp::hyb_matrix<IndexType,ValueType,cusp::host_memory> >(mtx, header, begin); break;
+    default:
+      throw cusp::io_exception("cusp binary file does not contain a matrix");
+  }
+}
+
+template <typename Matrix>
+void read_binary_buffer(Matrix& mtx, const char * begin, const char * end, cusp::array1d_format)
+{
+  // array1d case
+  typedef typename Matrix::value_type ValueType;
+
+  binary_header header;
+  read_binary_header(header, begin, end);
+  verify_binary_arrays(header, begin);
+
+  if (header.format != binary_array1d)
+    throw cusp::io_exception("cusp binary file does not contain an array1d");
+
+  check_binary_element<ValueType>(header.value_kind, header.value_size, "value");
+
+  read_binary_as< cusp::array1d<ValueType,cusp::host_memory> >(mtx, header, begin);
+}
+
+inline void check_binary_format(const binary_header& header, binary_word format, const char * name)
+{
+  if (header.format != format)
+    throw cusp::io_exception(std::string("cusp binary file does not contain a ") + name);
+}
+
+// view of array k of the file
+template <typename Array>
+Array binary_array_view(const binary_header& header, const char * base, size_t k)
+{
+  typedef typename Array::value_type ValueType;
+
+  const ValueType * first = reinterpret_cast<const ValueType *>(base + header.arrays[k].offset);
+
+  return Array(first, first + header.arrays[k].size / sizeof(ValueType));
+}
+
+template <typename View>
+void binary_view(View& v, const binary_header& header, const char * base, cusp::array1d_format)
+{
+  check_binary_format(header, binary_array1d, "array1d");
+  check_binary_element<typename View::value_type>(header.value_kind, header.value_size, "value");
+
+  v = binary_array_view<View>(header, base, 0);
+}
+
+template <typename View>
+void binary_view(View& v, const binary_header& header, const char * base, cusp::array2d_format)
+{
+  typedef typename View::values_array_type Array;
+  typedef typename View::orientation       Orientation;
+
+  check_binary_format(header, binary_array2d, "array2d");
+  check_binary_element<typename View::value_type>(header.value_kind, header.value_size, "value");
+
+  if (header.orientation != binary_orientation(Orientation()))
+    throw cusp::io_exception("cusp binary file array2d orientation does not match");
+
+  v = View(header.num_rows, header.num_cols, header.parameters[0], binary_array_view<Array>(header, base, 0));
+}
+
+template <typename View>
+void binary_view(View& v, const binary_header& header, const char * base, cusp::coo_format)
+{
+  check_binary_format(header, binary_coo, "coo_matrix");
+  check_binary_element<typename View::index_type>(header.index_kind, header.index_size, "index");
+  check_binary_element<typename View::value_type>(header.value_kind, header.value_size, "value");
+
+  v = View(header.num_rows, header.num_cols, header.num_entries,
+           binary_array_view<typename View::row_indices_array_type>   (header, base, 0),
+           binary_array_view<typename View::column_indices_array_type>(header, base, 1),
+           binary_array_view<typename View::values_array_type>        (header, base, 2));
+}
+
+template <typename View>
+void binary_view(View& v, const binary_header& header, const char * base, cusp::csr_format)
+{
+  check_binary_format(header, binary_csr, "csr_matrix");
+  check_binary_element<typename View::index_type>(header.index_kind, header.index_size, "index");
+  check_binary_element<typename View::value_type>(header.value_kind, header.value_size, "value");
+
+  v = View(header.num_rows, header.num_cols, header.num_entries,
+           binary_array_view<typename View::row_offsets_array_type>   (header, base, 0),
+           binary_array_view<typename View::column_indices_array_type>(header, base, 1),
+           binary_array_view<typename View::values_array_type>        (header, base, 2));
+}
+
+} // end namespace detail
+
+
+template <typename Matrix>
+void write_binary_file(const Matrix& mtx, const std::string& filename)
+{
+  std::ofstream file(filename.c_str(), std::ios::out | std::ios::binary);
+
+  if (!file)
+    throw cusp::io_exception(std::string("unable to open file \"") + filename + std::string("\" for writing"));
+
+  cusp::io::write_binary_stream(mtx, file);
+}
+
+template <typename Matrix, typename Stream>
+void write_binary_stream(const Matrix& mtx, Stream& output)
+{
+  cusp::io::detail::write_binary_stream(mtx, output, typename Matrix::memory_space());
+}
+
+template <typename Matrix>
+void read_binary_file(Matrix& mtx, const std::string& filename)
+{
+  cusp::io::detail::mapped_file file(filename);
+
+  cusp::io::detail::read_binary_buffer(mtx, file.begin(), file.end(), typename Matrix::format());
+}
+
+template <typename Matrix, typename Stream>
+void read_binary_stream(Matrix& mtx, Stream& input)
+{
+  // read the remaining contents of the stream into memory
+  std::vector<char> contents((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+
+  const char * begin = contents.empty() ? 0 : &contents[0];
+
+  cusp::io::detail::read_binary_buffer(mtx, begin, begin + contents.size(), typename Matrix::format());
+}
+
+inline binary_file::binary_file(const std::string& filename)
+  : file(filename)
+{
+  cusp::io::detail::read_binary_header(header, file.begin(), file.end());
+}
+
+inline size_t binary_file::num_rows(void) const
+{
+  return header.num_rows;
+}
+
+inline size_t binary_file::num_cols(void) const
+{
+  return header.num_cols;
+}
+
+inline size_t binary_file::num_entries(void) const
+{
+  return header.num_entries;
+}
+
+inline void binary_file::verify(void) const
+{
+  cusp::io::detail::verify_binary_arrays(header, file.begin());
+}
+
+template <typename View>
+void binary_file::view(View& v) const
+{
+  cusp::io::detail::binary_view(v, header, file.begin(), typename View::format());
+}
+
+} //end namespace io
+} //end namespace cusp
+
@@ -0,0 +1,252 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file gzip.h
+ *  \brief gzip compression of text files
+ */
+
+#pragma once
+
+#include <cusp/exception.h>
+
+#include <algorithm>
+#include <cstring>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+// gzip support requires zlib, which is enabled by defining CUSP_USE_ZLIB
+// (zlib=1 in the SCons build) and linking with -lz.  Without zlib,
+// compressed files are still recognized but reading or writing them throws
+// a cusp::io_exception.
+#if defined(CUSP_USE_ZLIB)
+#include <zlib.h>
+#endif
+
+namespace cusp
+{
+namespace io
+{
+namespace detail
+{
+
+// gzip data starts with the magic bytes 0x1f 0x8b
+inline bool is_gzip(const char * begin, const char * end)
+{
+  return end - begin >= 2 &&
+         static_cast<unsigned char>(begin[0]) == 0x1f &&
+         static_cast<unsigned char>(begin[1]) == 0x8b;
+}
+
+inline bool has_gzip_extension(const std::string& filename)
+{
+  return filename.size() >= 3 && filename.compare(filename.size() - 3, 3, ".gz") == 0;
+}
+
+inline void gzip_unavailable(void)
+{
+  throw cusp::io_exception("gzip compressed files require zlib (compile with CUSP_USE_ZLIB)");
+}
+
+#if defined(CUSP_USE_ZLIB)
+
+// zlib counts bytes with 32-bit integers, so large buffers are processed
+// in chunks
+const size_t gzip_chunk_size = size_t(1) << 30;
+
+// releases the state of an inflate stream on all paths
+struct gzip_inflate_stream
+{
+  z_stream stream;
+
+  gzip_inflate_stream(void)
+  {
+    std::memset(&stream, 0, sizeof(z_stream));
+
+    if (inflateInit2(&stream, 15 + 16) != Z_OK)
+      throw cusp::io_exception("unable to initialize zlib");
+  }
+
+  ~gzip_inflate_stream(void)
+  {
+    inflateEnd(&stream);
+  }
+};
+
+// Decompress the gzip data [begin,end), which may consist of several
+// concatenated members, into contents.  The data is decompressed in memory
+// in a single pass so the parser can work on the text in parallel.
+inline void gunzip(std::vector<char>& contents, const char * begin, const char * end)
+{
+  const size_t size = end - begin;
+
+  // the trailer of the last member holds its uncompressed size modulo 2^32,
+  // which is exact for most files and a good first guess otherwise
+  size_t capacity = 4 * size;
+
+  if (size >= 4)
+  {
+    const unsigned char * trailer = reinterpret_cast<const unsigned char *>(end - 4);
+
+    const size_t isize = size_t(trailer[0])       | (size_t(trailer[1]) << 8) |
+                        (size_t(trailer[2]) << 16) | (size_t(trailer[3]) << 24);
+
+    capacity = std::max(capacity, isize);
+  }
+
+  contents.resize(std::max<size_t>(capacity, 1));
+
+  gzip_inflate_stream inflater;
+  z_stream& stream = inflater.stream;
+
+  size_t in  = 0;
+  size_t out = 0;
+
+  while (true)
+  {
+    if (out == contents.size())
+      contents.resize(2 * contents.size());
+
+    const size_t avail_in  = std::min(size - in, gzip_chunk_size);
+    const size_t avail_out = std::min(contents.size() - out, gzip_chunk_size);
+
+    stream.next_in   = reinterpret_cast<Bytef *>(const_cast<char *>(begin + in));
+    stream.avail_in  = static_cast<uInt>(avail_in);
+    stream.next_out  = reinterpret_cast<Bytef *>(&contents[out]);
+    stream.avail_out = static_cast<uInt>(avail_out);
+
+    const int status = inflate(&stream, Z_NO_FLUSH);
+
+    in  += avail_in  - stream.avail_in;
+    out += avail_out - stream.avail_out;
+
+    if (status == Z_STREAM_END)
+    {
+      if (in == size)
+        break;
+
+      // another member follows
+      if (inflateReset(&stream) != Z_OK)
+        throw cusp::io_exception("invalid gzip data");
+
+      continue;
+    }
+
+    if (status != Z_OK && status != Z_BUF_ERROR)
+      throw cusp::io_exception("invalid gzip data");
+
+    if (in == size && stream.avail_out != 0)
+      throw cusp::io_exception("unexpected end of gzip data");
+  }
+
+  contents.resize(out);
+}
+
+// A stream buffer that compresses everything written to it and passes the
+// gzip data on to another stream.  finish() must be called after the last
+// write to complete the gzip data.
+class gzip_output_buffer : public std::streambuf
+{
+  std::ostream&     output;
+  z_stream          stream;
+  std::vector<char> input_buffer;
+  std::vector<char> output_buffer;
+  bool              failed;
+
+  // not copyable
+  gzip_output_buffer(const gzip_output_buffer&);
+  gzip_output_buffer& operator=(const gzip_output_buffer&);
+
+  // compress the pending input, returns false on failure
+  bool compress(const int flush)
+  {
+    stream.next_in  = reinterpret_cast<Bytef *>(pbase());
+    stream.avail_in = static_cast<uInt>(pptr() - pbase());
+
+    int status = Z_OK;
+
+    do
+    {
+      stream.next_out  = reinterpret_cast<Bytef *>(&output_buffer[0]);
+      stream.avail_out = static_cast<uInt>(output_buffer.size());
+
+      status = deflate(&stream, flush);
+
+      if (status == Z_STREAM_ERROR)
+        return false;
+
+      output.write(&output_buffer[0], output_buffer.size() - stream.avail_out);
+
+      if (!output)
+        return false;
+    }
+    while (stream.avail_out == 0 || (flush == Z_FINISH && status != Z_STREAM_END));
+
+    setp(&input_buffer[0], &input_buffer[0] + input_buffer.size());
+
+    return true;
+  }
+
+  protected:
+  int_type overflow(int_type c)
+  {
+    if (failed || !compress(Z_NO_FLUSH))
+    {
+      failed = true;
+      return traits_type::eof();
+    }
+
+    if (!traits_type::eq_int_type(c, traits_type::eof()))
+    {
+      *pptr() = traits_type::to_char_type(c);
+      pbump(1);
+    }
+
+    return traits_type::not_eof(c);
+  }
+
+  public:
+  explicit gzip_output_buffer(std::ostream& output, const int level = Z_DEFAULT_COMPRESSION)
+    : output(output), input_buffer(1 << 18), output_buffer(1 << 18), failed(false)
+  {
+    std::memset(&stream, 0, sizeof(z_stream));
+
+    if (deflateInit2(&stream, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+      throw cusp::io_exception("unable to initialize zlib");
+
+    setp(&input_buffer[0], &input_buffer[0] + input_buffer.size());
+  }
+
+  ~gzip_output_buffer(void)
+  {
+    deflateEnd(&stream);
+  }
+
+  // compress the remaining input and write the gzip trailer
+  void finish(void)
+  {
+    if (failed || !compress(Z_FINISH) || !output.flush())
+      throw cusp::io_exception("unable to write gzip data");
+  }
+};
+
+#endif // CUSP_USE_ZLIB
+
+} // end namespace detail
+} // end namespace io
+} // end namespace cusp
+
@@ -0,0 +1,125 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file mapped_file.h
+ *  \brief Read-only view of the contents of a file
+ */
+
+#pragma once
+
+#include <cusp/exception.h>
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iterator>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace cusp
+{
+namespace io
+{
+namespace detail
+{
+
+// The contents of a file as a contiguous range of characters.  Regular
+// files are memory mapped, so pages are read on demand (and concurrently by
+// the threads that touch them) without an intermediate copy.  Files that
+// cannot be mapped, such as pipes, and all files on platforms without mmap
+// are read into memory instead.
+class mapped_file
+{
+  const char *      data_;
+  size_t            size_;
+  bool              mapped_;
+  std::vector<char> buffer_;
+
+  // not copyable
+  mapped_file(const mapped_file&);
+  mapped_file& operator=(const mapped_file&);
+
+  void read_file(const std::string& filename)
+  {
+    std::ifstream file(filename.c_str(), std::ios::in | std::ios::binary);
+
+    if (!file)
+      throw cusp::io_exception(std::string("unable to open file \"") + filename + std::string("\" for reading"));
+
+    buffer_.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+    data_ = buffer_.empty() ? 0 : &buffer_[0];
+    size_ = buffer_.size();
+  }
+
+  public:
+  explicit mapped_file(const std::string& filename)
+    : data_(0), size_(0), mapped_(false)
+  {
+#if !defined(_WIN32)
+    int fd = open(filename.c_str(), O_RDONLY);
+
+    if (fd < 0)
+      throw cusp::io_exception(std::string("unable to open file \"") + filename + std::string("\" for reading"));
+
+    struct stat status;
+
+    const bool regular = fstat(fd, &status) == 0 && S_ISREG(status.st_mode);
+
+    if (regular && status.st_size > 0)
+    {
+      void * address = mmap(0, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+      if (address != MAP_FAILED)
+      {
+        data_   = static_cast<const char *>(address);
+        size_   = status.st_size;
+        mapped_ = true;
+      }
+    }
+
+    // the mapping remains valid after the descriptor is closed
+    close(fd);
+
+    if (mapped_ || (regular && status.st_size == 0))
+      return;
+#endif
+
+    read_file(filename);
+  }
+
+  ~mapped_file(void)
+  {
+#if !defined(_WIN32)
+    if (mapped_)
+      munmap(const_cast<char *>(data_), size_);
+#endif
+  }
+
+  const char * begin(void) const { return data_; }
+  const char * end(void)   const { return data_ + size_; }
+  size_t       size(void)  const { return size_; }
+};
+
+} // end namespace detail
+} // end namespace io
+} // end namespace cusp
+
@@ -19,10 +19,17 @@
 
 #include <cusp/array2d.h>
 #include <cusp/coo_matrix.h>
+#include <cusp/csr_matrix.h>
 #include <cusp/complex.h>
 #include <cusp/convert.h>
 #include <cusp/exception.h>
 
+#include <cusp/io/detail/gzip.h>
+#include <cusp/io/detail/mapped_file.h>
+#include <cusp/io/detail/matrix_market_cache.h>
+#include <cusp/io/detail/parse.h>
+#include <cusp/io/detail/print.h>
+
 #include <thrust/sort.h>
 
 #include <vector>
@@ -30,6 +37,7 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <iterator>
 
 namespace cusp
 {
@@ -66,14 +74,10 @@ struct matrix_market_banner
     std::string type;       // "complex", "real", "integer", or "pattern"
 };
 
-template <typename Stream>
-void read_matrix_market_banner(matrix_market_banner& banner, Stream& input)
+inline
+void parse_matrix_market_banner(matrix_market_banner& banner, const std::string& line)
 {
-  std::string line;
   std::vector<std::string> tokens;
-
-  // read first line
-  std::getline(input, line);
   detail::tokenize(tokens, line); 
 
   if (tokens.size() != 5 || tokens[0] != "%%MatrixMarket" || tokens[1] != "matrix")
@@ -95,6 +99,96 @@ void read_matrix_market_banner(matrix_market_banner& banner, Stream& input)
     throw cusp::io_exception("invalid MatrixMarket symmetry [" + banner.symmetry + "]");
 }
 
+template <typename Stream>
+void read_matrix_market_banner(matrix_market_banner& banner, Stream& input)
+{
+  std::string line;
+
+  // read first line
+  std::getline(input, line);
+
+  parse_matrix_market_banner(banner, line);
+}
+
+// read the banner at the start of [p,end) and advance p to the next line
+inline
+void read_matrix_market_banner(matrix_market_banner& banner, const char *& p, const char * end)
+{
+  const char * q = line_end(p, end);
+
+  parse_matrix_market_banner(banner, std::string(p, q));
+
+  p = next_line(q, end);
+}
+
+// Skip comment and blank lines, then read the integers on the size line
+// and advance p to the first data line.
+inline
+void read_matrix_market_dimensions(const char *& p, const char * end,
+                                   long long * dimensions, const size_t count,
+                                   const char * message)
+{
+  while (p != end)
+  {
+    const char * q = skip_blanks(p, end);
+
+    if (q != end && *q != '%' && *q != '\n')
+      break;
+
+    p = next_line(p, end);
+  }
+
+  const char * e = line_end(p, end);
+
+  for (size_t i = 0; i < count; i++)
+    if (!parse_integer(p, e, dimensions[i]) || dimensions[i] < 0)
+      throw cusp::io_exception(message);
+
+  if (skip_blanks(p, e) != e)
+    throw cusp::io_exception(message);
+
+  p = next_line(e, end);
+}
+
+// error codes returned by the line parsers
+enum matrix_market_parse_error
+{
+  invalid_entry = 1,
+  invalid_row_lower,
+  invalid_row_upper,
+  invalid_column_lower,
+  invalid_column_upper
+};
+
+inline
+void throw_parse_error(const int error)
+{
+  switch (error)
+  {
+    case invalid_row_lower:    throw cusp::io_exception("found invalid row index (index < 1)");
+    case invalid_column_lower: throw cusp::io_exception("found invalid column index (index < 1)");
+    case invalid_row_upper:    throw cusp::io_exception("found invalid row index (index > num_rows)");
+    case invalid_column_upper: throw cusp::io_exception("found invalid column index (index > num_columns)");
+    default:                   throw cusp::io_exception("invalid MatrixMarket entry");
+  }
+}
+
+// values stored on each line of a MatrixMarket file
+enum matrix_market_value_kind
+{
+  pattern_values,
+  real_values,
+  complex_values
+};
+
+inline
+matrix_market_value_kind value_kind(const matrix_market_banner& banner)
+{
+  if (banner.type == "pattern") return pattern_values;
+  if (banner.type == "complex") return complex_values;
+  return real_values;
+}
+
 
 
 template <typename ScalarType>
@@ -110,118 +204,302 @@ void assign_complex(cusp::complex<ScalarType>& value, double real, double imag)
   value.imag(imag);
 }
 
-template <typename Stream, typename ScalarType>
-void write_value(Stream& output, const ScalarType& value)
+
+// Parses the indices "i j" at the start of a coordinate line, checks them
+// against the dimensions and converts them from base-1 to base-0.
+inline
+int parse_coordinate(const char *& p, const char * end,
+                     const long long num_rows, const long long num_cols,
+                     long long& i, long long& j)
 {
-  output << value;
+  if (!parse_integer(p, end, i) || !parse_integer(p, end, j))
+    return invalid_entry;
+
+  if (i < 1)        return invalid_row_lower;
+  if (j < 1)        return invalid_column_lower;
+  if (i > num_rows) return invalid_row_upper;
+  if (j > num_cols) return invalid_column_upper;
+
+  i--;
+  j--;
+
+  return 0;
 }
 
-template <typename Stream, typename ScalarType>
-void write_value(Stream& output, const cusp::complex<ScalarType>& value)
+// Parses the value "[real [imag]]" that follows the indices
+template <typename ValueType>
+int parse_coordinate_value(const char *& p, const char * end,
+                           const matrix_market_value_kind kind, ValueType& value)
 {
-  output << value.real() << " " << value.imag();
-}
+  double real = 1;
+  double imag = 0;
+
+  if (kind != pattern_values && !parse_real(p, end, real))
+    return invalid_entry;
 
+  if (kind == complex_values && !parse_real(p, end, imag))
+    return invalid_entry;
 
-template <typename IndexType, typename ValueType, typename Stream>
-void read_coordinate_stream(cusp::coo_matrix<IndexType,ValueType,cusp::host_memory>& coo, Stream& input, const matrix_market_banner& banner)
+  assign_complex(value, real, imag);
+
+  return 0;
+}
+
+// Parses the line "i j [real [imag]]" into entry n of a coordinate matrix.
+// The indices are validated and converted from base-1 to base-0 as they
+// are read.
+template <typename IndexType, typename ValueType>
+struct coordinate_line_parser
 {
-  // read file contents line by line
-  std::string line;
-    
-  // skip over banner and comments
-  do
+  cusp::coo_matrix<IndexType,ValueType,cusp::host_memory>& coo;
+
+  const matrix_market_value_kind kind;
+  const long long num_rows;
+  const long long num_cols;
+
+  coordinate_line_parser(cusp::coo_matrix<IndexType,ValueType,cusp::host_memory>& coo,
+                         const matrix_market_value_kind kind)
+    : coo(coo), kind(kind), num_rows(coo.num_rows), num_cols(coo.num_cols) {}
+
+  int operator()(const size_t n, const char * p, const char * end)
   {
-    std::getline(input, line);
-  } while (line[0] == '%');
+    long long i, j;
 
-  // line contains [num_rows num_columns num_entries]
-  std::vector<std::string> tokens;
-  detail::tokenize(tokens, line); 
+    if (int error = parse_coordinate(p, end, num_rows, num_cols, i, j))
+      return error;
 
-  if (tokens.size() != 3)
-    throw cusp::io_exception("invalid MatrixMarket coordinate format");
+    coo.row_indices[n]    = IndexType(i);
+    coo.column_indices[n] = IndexType(j);
 
-  size_t num_rows, num_cols, num_entries;
+    return parse_coordinate_value(p, end, kind, coo.values[n]);
+  }
+};
 
-  std::istringstream(tokens[0]) >> num_rows;
-  std::istringstream(tokens[1]) >> num_cols;
-  std::istringstream(tokens[2]) >> num_entries;
-  
-  coo.resize(num_rows, num_cols, num_entries);
+// Counts the entries of each row of a coordinate file into counts[i],
+// including the mirrored entries of symmetric matrices.
+template <typename IndexType>
+struct coordinate_row_counter
+{
+  IndexType * counts;
 
-  size_t num_entries_read = 0;
+  const long long num_rows;
+  const long long num_cols;
+  const bool symmetric;
 
-  // read file contents
-  if (banner.type == "pattern")
+  coordinate_row_counter(IndexType * counts, const size_t num_rows, const size_t num_cols, const bool symmetric)
+    : counts(counts), num_rows(num_rows), num_cols(num_cols), symmetric(symmetric) {}
+
+  int operator()(const size_t, const char * p, const char * end)
   {
-    while(num_entries_read < coo.num_entries && !input.eof())
+    long long i, j;
+
+    if (int error = parse_coordinate(p, end, num_rows, num_cols, i, j))
+      return error;
+
+    #pragma omp atomic
+    counts[i] += 1;
+
+    if (symmetric && i != j)
     {
-      input >> coo.row_indices[num_entries_read];
-      input >> coo.column_indices[num_entries_read];
-      num_entries_read++;
+      #pragma omp atomic
+      counts[j] += 1;
     }
 
-    std::fill(coo.values.begin(), coo.values.end(), ValueType(1));
-  } 
-  else if (banner.type == "real" || banner.type == "integer")
+    return 0;
+  }
+};
+
+// Parses the line "i j [real [imag]]" and places the entry (and its mirror
+// for symmetric matrices) at the next free position of its CSR row.  The
+// cursors start at the row offsets and end at the offsets of the next rows.
+template <typename IndexType, typename ValueType>
+struct coordinate_csr_placer
+{
+  IndexType * cursors;
+  IndexType * column_indices;
+  ValueType * values;
+
+  const matrix_market_value_kind kind;
+  const long long num_rows;
+  const long long num_cols;
+  const bool symmetric;
+
+  coordinate_csr_placer(IndexType * cursors, IndexType * column_indices, ValueType * values,
+                        const matrix_market_value_kind kind,
+                        const size_t num_rows, const size_t num_cols, const bool symmetric)
+    : cursors(cursors), column_indices(column_indices), values(values),
+      kind(kind), num_rows(num_rows), num_cols(num_cols), symmetric(symmetric) {}
+
+  int operator()(const size_t, const char * p, const char * end)
   {
-    while(num_entries_read < coo.num_entries && !input.eof())
-    {
-      double real;
+    using cusp::detail::host::fetch_and_add;
 
-      input >> coo.row_indices[num_entries_read];
-      input >> coo.column_indices[num_entries_read];
-      input >> real;
+    long long i, j;
 
-      coo.values[num_entries_read] = real;
-      num_entries_read++;
-    }
-  } 
-  else if (banner.type == "complex")
-  {
-    while(num_entries_read < coo.num_entries && !input.eof())
-    {
-      double real, imag;
+    if (int error = parse_coordinate(p, end, num_rows, num_cols, i, j))
+      return error;
 
-      input >> coo.row_indices[num_entries_read];
-      input >> coo.column_indices[num_entries_read];
-      input >> real;
-      input >> imag;
+    ValueType value;
 
-      assign_complex(coo.values[num_entries_read], real, imag);
+    if (int error = parse_coordinate_value(p, end, kind, value))
+      return error;
 
-      num_entries_read++;
+    IndexType n = fetch_and_add(cursors[i], IndexType(1));
+
+    column_indices[n] = IndexType(j);
+    values[n]         = value;
+
+    if (symmetric && i != j)
+    {
+      n = fetch_and_add(cursors[j], IndexType(1));
+
+      column_indices[n] = IndexType(i);
+      values[n]         = value;
     }
+
+    return 0;
   }
-  else
+};
+
+// Strict weak ordering of values for std::sort: NaN is ordered after every
+// number and all NaNs are equivalent, where operator< alone would make NaN
+// equivalent to every value.
+template <typename ValueType>
+bool value_less(const ValueType& a, const ValueType& b)
+{
+  if (a != a)
+    return false;
+  if (b != b)
+    return true;
+  return a < b;
+}
+
+template <typename ScalarType>
+bool value_less(const cusp::complex<ScalarType>& a, const cusp::complex<ScalarType>& b)
+{
+  if (value_less(a.real(), b.real()))
+    return true;
+  if (value_less(b.real(), a.real()))
+    return false;
+  return value_less(a.imag(), b.imag());
+}
+
+// orders (column, value) pairs by column and duplicate columns by value
+template <typename IndexType, typename ValueType>
+struct coordinate_entry_less
+{
+  bool operator()(const std::pair<IndexType,ValueType>& a,
+                  const std::pair<IndexType,ValueType>& b) const
   {
-    throw cusp::io_exception("invalid MatrixMarket data type");
+    return a.first < b.first || (a.first == b.first && value_less(a.second, b.second));
   }
+};
 
-  if(num_entries_read != coo.num_entries)
-    throw cusp::io_exception("unexpected EOF while reading MatrixMarket entries");
+// Sort the entries of every row by column.  Entries are placed in a row in
+// whatever order the threads reach them, so duplicate entries are ordered
+// by value to make the result independent of the number of threads.
+template <typename IndexType, typename ValueType>
+void sort_coordinate_rows(cusp::csr_matrix<IndexType,ValueType,cusp::host_memory>& csr)
+{
+  using namespace cusp::detail::host;
+
+  typedef std::pair<IndexType,ValueType> Entry;
 
-  // check validity of row and column index data
-  if (coo.num_entries > 0)
+  coordinate_entry_less<IndexType,ValueType> less;
+
+  #pragma omp parallel num_threads(num_threads(csr.num_entries))
   {
-    size_t min_row_index = *std::min_element(coo.row_indices.begin(), coo.row_indices.end());
-    size_t max_row_index = *std::max_element(coo.row_indices.begin(), coo.row_indices.end());
-    size_t min_col_index = *std::min_element(coo.column_indices.begin(), coo.column_indices.end());
-    size_t max_col_index = *std::max_element(coo.column_indices.begin(), coo.column_indices.end());
-
-    if (min_row_index < 1)            throw cusp::io_exception("found invalid row index (index < 1)");
-    if (min_col_index < 1)            throw cusp::io_exception("found invalid column index (index < 1)");
-    if (max_row_index > coo.num_rows) throw cusp::io_exception("found invalid row index (index > num_rows)");
-    if (max_col_index > coo.num_cols) throw cusp::io_exception("found invalid column index (index > num_columns)");
+    const size_t begin = weighted_partition_begin(csr.row_offsets, thread_num(),     team_size());
+    const size_t end   = weighted_partition_begin(csr.row_offsets, thread_num() + 1, team_size());
+
+    std::vector<Entry> entries;
+
+    for (size_t i = begin; i < end; i++)
+    {
+      const IndexType row_begin = csr.row_offsets[i];
+      const IndexType row_end   = csr.row_offsets[i + 1];
+
+      IndexType jj = row_begin + 1;
+
+      while (jj < row_end && !less(Entry(csr.column_indices[jj],     csr.values[jj]),
+                                   Entry(csr.column_indices[jj - 1], csr.values[jj - 1])))
+        jj++;
+
+      if (jj >= row_end)
+        continue;
+
+      entries.resize(row_end - row_begin);
+
+      for (IndexType n = row_begin; n < row_end; n++)
+        entries[n - row_begin] = Entry(csr.column_indices[n], csr.values[n]);
+
+      std::sort(entries.begin(), entries.end(), less);
+
+      for (IndexType n = row_begin; n < row_end; n++)
+      {
+        csr.column_indices[n] = entries[n - row_begin].first;
+        csr.values[n]         = entries[n - row_begin].second;
+      }
+    }
   }
+}
+
+// Parses the line "real [imag]" into entry n of an array
+template <typename Array>
+struct array_line_parser
+{
+  Array& values;
 
-  // convert base-1 indices to base-0
-  for(size_t n = 0; n < coo.num_entries; n++)
+  const matrix_market_value_kind kind;
+
+  array_line_parser(Array& values, const matrix_market_value_kind kind)
+    : values(values), kind(kind) {}
+
+  int operator()(const size_t n, const char * p, const char * end)
   {
-    coo.row_indices[n]    -= 1;
-    coo.column_indices[n] -= 1;
+    double real;
+    double imag = 0;
+
+    if (!parse_real(p, end, real))
+      return invalid_entry;
+
+    if (kind == complex_values && !parse_real(p, end, imag))
+      return invalid_entry;
+
+    assign_complex(values[n], real, imag);
+
+    return 0;
   }
+};
+
+// Read the coordinate data in [p,end), which follows the banner
+template <typename IndexType, typename ValueType>
+void read_coordinate_buffer(cusp::coo_matrix<IndexType,ValueType,cusp::host_memory>& coo,
+                            const char * p, const char * end,
+                            const matrix_market_banner& banner)
+{
+  // size line contains [num_rows num_columns num_entries]
+  long long dimensions[3];
+  read_matrix_market_dimensions(p, end, dimensions, 3, "invalid MatrixMarket coordinate format");
+
+  size_t num_rows    = dimensions[0];
+  size_t num_cols    = dimensions[1];
+  size_t num_entries = dimensions[2];
+
+  coo.resize(num_rows, num_cols, num_entries);
+
+  // parse entries in parallel directly into coo
+  coordinate_line_parser<IndexType,ValueType> parser(coo, value_kind(banner));
+
+  size_t num_entries_read;
+
+  int error = parse_lines(p, end, num_entries, parser, num_entries_read);
+
+  if (error != 0)
+    throw_parse_error(error);
+
+  if(num_entries_read != coo.num_entries)
+    throw cusp::io_exception("unexpected EOF while reading MatrixMarket entries");
 
   // expand symmetric formats to "general" format
   if (banner.symmetry != "general")
@@ -277,202 +555,372 @@ void read_coordinate_stream(cusp::coo_matrix<IndexType,ValueType,cusp::host_memo
   coo.sort_by_row_and_column();
 } 
 
-template <typename ValueType, typename Stream>
-void read_array_stream(cusp::array2d<ValueType,cusp::host_memory>& mtx, Stream& input, const matrix_market_banner& banner)
+// Read the coordinate data in [p,end), which follows the banner, directly
+// into a CSR matrix.  A first pass over the file counts the entries of each
+// row and a second pass parses the entries into their rows, so no
+// coordinate copy of the matrix is ever held in memory.
+template <typename IndexType, typename ValueType>
+void read_coordinate_buffer(cusp::csr_matrix<IndexType,ValueType,cusp::host_memory>& csr,
+                            const char * p, const char * end,
+                            const matrix_market_banner& banner)
 {
-  // read file contents line by line
-  std::string line;
-    
-  // skip over banner and comments
-  do
-  {
-    std::getline(input, line);
-  } while (line[0] == '%');
+  using namespace cusp::detail::host;
 
-  std::vector<std::string> tokens;
-  detail::tokenize(tokens, line); 
+  // size line contains [num_rows num_columns num_entries]
+  long long dimensions[3];
+  read_matrix_market_dimensions(p, end, dimensions, 3, "invalid MatrixMarket coordinate format");
 
-  if (tokens.size() != 2)
-    throw cusp::io_exception("invalid MatrixMarket array format");
+  size_t num_rows    = dimensions[0];
+  size_t num_cols    = dimensions[1];
+  size_t num_entries = dimensions[2];
 
-  size_t num_rows, num_cols;
+  if (banner.symmetry == "hermitian")
+    throw cusp::not_implemented_exception("MatrixMarket I/O does not currently support hermitian matrices");
 
-  std::istringstream(tokens[0]) >> num_rows;
-  std::istringstream(tokens[1]) >> num_cols;
+  if (banner.symmetry == "skew-symmetric")
+    throw cusp::not_implemented_exception("MatrixMarket I/O does not currently support skew-symmetric matrices");
 
-  cusp::array2d<ValueType,cusp::host_memory,cusp::column_major> dense(num_rows, num_cols);
+  // off-diagonal entries of symmetric matrices are stored in both triangles
+  const bool symmetric = banner.symmetry == "symmetric";
 
-  size_t num_entries = num_rows * num_cols;
+  // count the entries of each row
+  csr.row_offsets.resize(num_rows + 1);
+  parallel_fill(csr.row_offsets, IndexType(0));
 
-  size_t num_entries_read = 0;
+  coordinate_row_counter<IndexType> counter(&csr.row_offsets[0], num_rows, num_cols, symmetric);
 
-  // read file contents
-  if (banner.type == "pattern")
-  {
-    throw cusp::not_implemented_exception("pattern array MatrixMarket format is not supported");
-  } 
-  else if (banner.type == "real" || banner.type == "integer")
-  {
-    while(num_entries_read < num_entries && !input.eof())
-    {
-      double real;
+  size_t num_entries_read;
 
-      input >> real;
+  int error = parse_lines(p, end, num_entries, counter, num_entries_read);
 
-      dense.values[num_entries_read] = real;
+  if (error != 0)
+    throw_parse_error(error);
 
-      num_entries_read++;
-    }
-  } 
-  else if (banner.type == "complex")
-  {
-    while(num_entries_read < num_entries && !input.eof())
-    {
-      double real, imag;
-        
-      input >> real;
-      input >> imag;
+  if (num_entries_read != num_entries)
+    throw cusp::io_exception("unexpected EOF while reading MatrixMarket entries");
 
-      assign_complex(dense.values[num_entries_read], real, imag);
+  size_t general_num_entries = counts_to_offsets(csr.row_offsets);
 
-      num_entries_read++;
-    }
-  }
-  else
+  csr.resize(num_rows, num_cols, general_num_entries);
+
+  // place the entries, advancing each row offset to the start of the next row
+  if (general_num_entries > 0)
   {
-    throw cusp::io_exception("invalid MatrixMarket data type");
+    coordinate_csr_placer<IndexType,ValueType> placer(&csr.row_offsets[0], &csr.column_indices[0], &csr.values[0],
+                                                      value_kind(banner), num_rows, num_cols, symmetric);
+
+    error = parse_lines(p, end, num_entries, placer, num_entries_read);
+
+    if (error != 0)
+      throw_parse_error(error);
   }
 
-  if(num_entries_read != num_entries)
-    throw cusp::io_exception("unexpected EOF while reading MatrixMarket entries");
+  std::copy_backward(csr.row_offsets.begin(), csr.row_offsets.end() - 1, csr.row_offsets.end());
+  csr.row_offsets[0] = 0;
+
+  sort_coordinate_rows(csr);
+}
+
+// Read the array data in [p,end), which follows the banner
+template <typename ValueType>
+void read_array_buffer(cusp::array2d<ValueType,cusp::host_memory>& mtx,
+                       const char * p, const char * end,
+                       const matrix_market_banner& banner)
+{
+  // size line contains [num_rows num_columns]
+  long long dimensions[2];
+  read_matrix_market_dimensions(p, end, dimensions, 2, "invalid MatrixMarket array format");
+
+  size_t num_rows = dimensions[0];
+  size_t num_cols = dimensions[1];
+
+  if (banner.type == "pattern")
+    throw cusp::not_implemented_exception("pattern array MatrixMarket format is not supported");
 
   if (banner.symmetry != "general")
     throw cusp::not_implemented_exception("only general array symmetric MatrixMarket format is supported");
 
+  cusp::array2d<ValueType,cusp::host_memory,cusp::column_major> dense(num_rows, num_cols);
+
+  size_t num_entries = num_rows * num_cols;
+
+  array_line_parser< cusp::array1d<ValueType,cusp::host_memory> > parser(dense.values, value_kind(banner));
+
+  size_t num_entries_read;
+
+  int error = parse_lines(p, end, num_entries, parser, num_entries_read);
+
+  if (error != 0)
+    throw_parse_error(error);
+
+  if(num_entries_read != num_entries)
+    throw cusp::io_exception("unexpected EOF while reading MatrixMarket entries");
+
   cusp::copy(dense, mtx);
 }
 
 
 
-template <typename IndexType, typename ValueType, typename Stream>
-void write_coordinate_stream(const cusp::coo_matrix<IndexType,ValueType,cusp::host_memory>& coo, Stream& output)
+template <typename Matrix>
+struct coordinate_line_printer
 {
-  bool is_complex = thrust::detail::is_same<ValueType, cusp::complex<typename norm_type<ValueType>::type> >::value;
+  const Matrix& coo;
 
-  if (is_complex)
-    output << "%%MatrixMarket matrix coordinate complex general\n";
-  else
-    output << "%%MatrixMarket matrix coordinate real general\n";
+  coordinate_line_printer(const Matrix& coo) : coo(coo) {}
 
-  output << "\t" << coo.num_rows << "\t" << coo.num_cols << "\t" << coo.num_entries << "\n";
+  char * operator()(const size_t n, char * p) const
+  {
+    p = print_integer(p, static_cast<long long>(coo.row_indices[n]) + 1);
+    *p++ = ' ';
+    p = print_integer(p, static_cast<long long>(coo.column_indices[n]) + 1);
+    *p++ = ' ';
+    p = print_value(p, coo.values[n]);
+    *p++ = '\n';
+    return p;
+  }
+};
+
+template <typename Matrix>
+struct array1d_line_printer
+{
+  const Matrix& array;
+
+  array1d_line_printer(const Matrix& array) : array(array) {}
 
-  for(size_t i = 0; i < coo.num_entries; i++)
+  char * operator()(const size_t n, char * p) const
   {
-    output << (coo.row_indices[i]    + 1) << " ";
-    output << (coo.column_indices[i] + 1) << " ";
-    cusp::io::detail::write_value(output, coo.values[i]);
-    output << "\n";
+    p = print_value(p, array[n]);
+    *p++ = '\n';
+    return p;
   }
+};
+
+// entries of array2d files are stored in column-major order
+template <typename Matrix>
+struct array2d_line_printer
+{
+  const Matrix& array;
+
+  array2d_line_printer(const Matrix& array) : array(array) {}
+
+  char * operator()(const size_t n, char * p) const
+  {
+    p = print_value(p, array(n % array.num_rows, n / array.num_rows));
+    *p++ = '\n';
+    return p;
+  }
+};
+
+template <typename ValueType, typename Stream>
+void write_matrix_market_banner(Stream& output, const char * storage)
+{
+  bool is_complex = thrust::detail::is_same<ValueType, cusp::complex<typename norm_type<ValueType>::type> >::value;
+
+  output << "%%MatrixMarket matrix " << storage << (is_complex ? " complex general\n" : " real general\n");
+}
+
+// The entries are formatted in parallel and written in large blocks (see
+// print_lines).  Real values are printed with the fewest digits that read
+// back to the same value.
+template <typename Matrix, typename Stream>
+void write_coordinate_stream(const Matrix& coo, Stream& output, cusp::host_memory)
+{
+  write_matrix_market_banner<typename Matrix::value_type>(output, "coordinate");
+
+  output << "\t" << coo.num_rows << "\t" << coo.num_cols << "\t" << coo.num_entries << "\n";
+
+  print_lines(output, coo.num_entries, coordinate_line_printer<Matrix>(coo));
 }
 
+template <typename Matrix, typename Stream>
+void write_array_stream(const Matrix& mtx, Stream& output, cusp::array1d_format, cusp::host_memory)
+{
+  write_matrix_market_banner<typename Matrix::value_type>(output, "array");
+
+  output << "\t" << mtx.size() << "\t1\n";
+
+  print_lines(output, mtx.size(), array1d_line_printer<Matrix>(mtx));
+}
 
-template <typename Matrix, typename Stream, typename Format>
-void read_matrix_market_stream(Matrix& mtx, Stream& input, Format)
+template <typename Matrix, typename Stream>
+void write_array_stream(const Matrix& mtx, Stream& output, cusp::array2d_format, cusp::host_memory)
+{
+  write_matrix_market_banner<typename Matrix::value_type>(output, "array");
+
+  output << "\t" << mtx.num_rows << "\t" << mtx.num_cols << "\n";
+
+  print_lines(output, mtx.num_rows * mtx.num_cols, array2d_line_printer<Matrix>(mtx));
+}
+
+
+// COO matrices are read into a COO matrix
+template <typename Matrix>
+void read_coordinate_buffer(Matrix& mtx, const char * p, const char * end,
+                            const matrix_market_banner& banner, cusp::coo_format)
 {
-  // general case
   typedef typename Matrix::index_type IndexType;
   typedef typename Matrix::value_type ValueType;
 
+  cusp::coo_matrix<IndexType,ValueType,cusp::host_memory> temp;
+
+  read_coordinate_buffer(temp, p, end, banner);
+
+  cusp::convert_inplace(temp, mtx);
+}
+
+// all other formats are converted from a CSR matrix, which is assembled
+// directly from the file
+template <typename Matrix, typename Format>
+void read_coordinate_buffer(Matrix& mtx, const char * p, const char * end,
+                            const matrix_market_banner& banner, Format)
+{
+  typedef typename Matrix::index_type IndexType;
+  typedef typename Matrix::value_type ValueType;
+
+  cusp::csr_matrix<IndexType,ValueType,cusp::host_memory> temp;
+
+  read_coordinate_buffer(temp, p, end, banner);
+
+  cusp::convert_inplace(temp, mtx);
+}
+
+template <typename Matrix, typename Format>
+void read_matrix_market_buffer(Matrix& mtx, const char * begin, const char * end, Format)
+{
+  // general case
+  typedef typename Matrix::value_type ValueType;
+
   // read banner 
   matrix_market_banner banner;
-  read_matrix_market_banner(banner, input);
+  read_matrix_market_banner(banner, begin, end);
 
   if (banner.storage == "coordinate")
   {
-    cusp::coo_matrix<IndexType,ValueType,cusp::host_memory> temp;
-
-    read_coordinate_stream(temp, input, banner);
-
-    cusp::convert(temp, mtx);
+    read_coordinate_buffer(mtx, begin, end, banner, Format());
   }
   else // banner.storage == "array"
   {
     cusp::array2d<ValueType,cusp::host_memory> temp;
 
-    read_array_stream(temp, input, banner);
+    read_array_buffer(temp, begin, end, banner);
 
-    cusp::convert(temp, mtx);
+    cusp::convert_inplace(temp, mtx);
   }
 }
 
-template <typename Matrix, typename Stream>
-void read_matrix_market_stream(Matrix& mtx, Stream& input, cusp::array1d_format)
+template <typename Matrix>
+void read_matrix_market_buffer(Matrix& mtx, const char * begin, const char * end, cusp::array1d_format)
 {
   // array1d case
   typedef typename Matrix::value_type ValueType;
 
   cusp::array2d<ValueType,cusp::host_memory> temp;
 
-  cusp::io::read_matrix_market_stream(temp, input);
+  read_matrix_market_buffer(temp, begin, end, cusp::array2d_format());
 
-  cusp::convert(temp, mtx);
+  cusp::convert_inplace(temp, mtx);
 }
 
-template <typename Matrix, typename Stream>
-void write_matrix_market_stream(const Matrix& mtx, Stream& output, cusp::sparse_format)
+// gzip compressed contents are decompressed in memory before parsing
+template <typename Matrix>
+void read_matrix_market_contents(Matrix& mtx, const char * begin, const char * end)
+{
+  if (is_gzip(begin, end))
+  {
+#if defined(CUSP_USE_ZLIB)
+    std::vector<char> contents;
+    gunzip(contents, begin, end);
+
+    const char * text = contents.empty() ? 0 : &contents[0];
+
+    read_matrix_market_buffer(mtx, text, text + contents.size(), typename Matrix::format());
+#else
+    gzip_unavailable();
+#endif
+  }
+  else
+  {
+    read_matrix_market_buffer(mtx, begin, end, typename Matrix::format());
+  }
+}
+
+template <typename Matrix>
+void write_matrix_market_gzip(const Matrix& mtx, const std::string& filename)
+{
+#if defined(CUSP_USE_ZLIB)
+  std::ofstream file(filename.c_str(), std::ios::out | std::ios::binary);
+
+  if (!file)
+    throw cusp::io_exception(std::string("unable to open file \"") + filename + std::string("\" for writing"));
+
+  gzip_output_buffer buffer(file);
+  std::ostream output(&buffer);
+
+  cusp::io::write_matrix_market_stream(mtx, output);
+
+  buffer.finish();
+#else
+  gzip_unavailable();
+#endif
+}
+
+// containers in other memory spaces are copied to the host
+template <typename Matrix, typename Stream, typename MemorySpace>
+void write_coordinate_stream(const Matrix& mtx, Stream& output, MemorySpace)
 {
-  // general sparse case
   typedef typename Matrix::index_type IndexType;
   typedef typename Matrix::value_type ValueType;
 
   cusp::coo_matrix<IndexType,ValueType,cusp::host_memory> coo(mtx);
 
-  cusp::io::detail::write_coordinate_stream(coo, output);
+  write_coordinate_stream(coo, output, cusp::host_memory());
 }
 
-template <typename Matrix, typename Stream>
-void write_matrix_market_stream(const Matrix& mtx, Stream& output, cusp::array1d_format)
+template <typename Matrix, typename Stream, typename MemorySpace>
+void write_array_stream(const Matrix& mtx, Stream& output, cusp::array1d_format, MemorySpace)
 {
-  typedef typename Matrix::value_type ValueType;
-
-  bool is_complex = thrust::detail::is_same<ValueType, cusp::complex<typename norm_type<ValueType>::type> >::value;
+  cusp::array1d<typename Matrix::value_type,cusp::host_memory> host(mtx);
 
-  if (is_complex)
-    output << "%%MatrixMarket matrix array complex general\n";
-  else
-    output << "%%MatrixMarket matrix array real general\n";
+  write_array_stream(host, output, cusp::array1d_format(), cusp::host_memory());
+}
 
-  output << "\t" << mtx.size() << "\t1\n";
+template <typename Matrix, typename Stream, typename MemorySpace>
+void write_array_stream(const Matrix& mtx, Stream& output, cusp::array2d_format, MemorySpace)
+{
+  cusp::array2d<typename Matrix::value_type,cusp::host_memory,typename Matrix::orientation> host(mtx);
 
-  for(size_t i = 0; i < mtx.size(); i++)
-  {
-    write_value(output, mtx[i]);
-    output << "\n";
-  }
+  write_array_stream(host, output, cusp::array2d_format(), cusp::host_memory());
 }
 
 template <typename Matrix, typename Stream>
-void write_matrix_market_stream(const Matrix& mtx, Stream& output, cusp::array2d_format)
+void write_matrix_market_stream(const Matrix& mtx, Stream& output, cusp::sparse_format)
 {
+  // general sparse case
+  typedef typename Matrix::index_type IndexType;
   typedef typename Matrix::value_type ValueType;
 
-  bool is_complex = thrust::detail::is_same<ValueType, cusp::complex<typename norm_type<ValueType>::type> >::value;
+  cusp::coo_matrix<IndexType,ValueType,cusp::host_memory> coo(mtx);
 
-  if (is_complex)
-    output << "%%MatrixMarket matrix array complex general\n";
-  else
-    output << "%%MatrixMarket matrix array real general\n";
+  cusp::io::detail::write_coordinate_stream(coo, output, cusp::host_memory());
+}
 
-  output << "\t" << mtx.num_rows << "\t" << mtx.num_cols << "\n";
+template <typename Matrix, typename Stream>
+void write_matrix_market_stream(const Matrix& mtx, Stream& output, cusp::coo_format)
+{
+  // COO matrices in host memory are written without a copy
+  write_coordinate_stream(mtx, output, typename Matrix::memory_space());
+}
 
-  for(size_t j = 0; j < mtx.num_cols; j++)
-  {
-    for(size_t i = 0; i < mtx.num_rows; i++)
-    {
-      write_value(output, mtx(i,j));
-      output << "\n";
-    }
-  }
+template <typename Matrix, typename Stream>
+void write_matrix_market_stream(const Matrix& mtx, Stream& output, cusp::array1d_format)
+{
+  write_array_stream(mtx, output, cusp::array1d_format(), typename Matrix::memory_space());
+}
+
+template <typename Matrix, typename Stream>
+void write_matrix_market_stream(const Matrix& mtx, Stream& output, cusp::array2d_format)
+{
+  write_array_stream(mtx, output, cusp::array2d_format(), typename Matrix::memory_space());
 }
 
 } // end namespace detail
@@ -481,34 +929,47 @@ void write_matrix_market_stream(const Matrix& mtx, Stream& output, cusp::array2d
 template <typename Matrix>
 void read_matrix_market_file(Matrix& mtx, const std::string& filename)
 {
-  std::ifstream file(filename.c_str());
+  // load the binary snapshot of a previous read when the cache is enabled
+  std::string snapshot;
+  cusp::io::detail::matrix_market_cache_key key;
 
-  if (!file)
-    throw cusp::io_exception(std::string("unable to open file \"") + filename + std::string("\" for reading"));
+  const bool cached = cusp::io::detail::find_matrix_market_snapshot<Matrix>(filename, snapshot, key);
 
-#ifdef __APPLE__
-  // WAR OSX-specific issue using rdbuf
-  std::stringstream file_string (std::stringstream::in | std::stringstream::out);
-  std::vector<char> buffer(file.rdbuf()->pubseekoff(0, std::ios::end,std::ios::in));
-  file.rdbuf()->pubseekpos(0, std::ios::in);
-  file.rdbuf()->sgetn(&buffer[0], buffer.size());
-  file_string.write(&buffer[0], buffer.size());
+  if (cached && cusp::io::detail::read_matrix_market_snapshot(mtx, snapshot, key))
+    return;
 
-  cusp::io::read_matrix_market_stream(mtx, file_string);
-#else
-  cusp::io::read_matrix_market_stream(mtx, file);
-#endif
+  {
+    // the file is mapped into memory and parsed in place
+    cusp::io::detail::mapped_file file(filename);
+
+    cusp::io::detail::read_matrix_market_contents(mtx, file.begin(), file.end());
+  }
+
+  if (cached)
+    cusp::io::detail::write_matrix_market_snapshot(mtx, snapshot, key);
 }
 
 template <typename Matrix, typename Stream>
 void read_matrix_market_stream(Matrix& mtx, Stream& input)
 {
-  cusp::io::detail::read_matrix_market_stream(mtx, input, typename Matrix::format());
+  // read the remaining contents of the stream and parse them in memory
+  std::string contents((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+
+  const char * begin = contents.data();
+
+  cusp::io::detail::read_matrix_market_contents(mtx, begin, begin + contents.size());
 }
 
 template <typename Matrix>
 void write_matrix_market_file(const Matrix& mtx, const std::string& filename)
 {
+  // files named *.gz are compressed
+  if (cusp::io::detail::has_gzip_extension(filename))
+  {
+    cusp::io::detail::write_matrix_market_gzip(mtx, filename);
+    return;
+  }
+
   std::ofstream file(filename.c_str());
 
   if (!file)
@@ -532,6 +993,19 @@ void write_matrix_market_stream(const Matrix& mtx, Stream& output)
   cusp::io::detail::write_matrix_market_stream(mtx, output, typename Matrix::format());
 }
 
+inline void enable_matrix_market_cache(const std::string& directory)
+{
+  cusp::io::detail::matrix_market_cache_settings& settings = cusp::io::detail::matrix_market_cache();
+
+  settings.enabled   = true;
+  settings.directory = directory;
+}
+
+inline void disable_matrix_market_cache(void)
+{
+  cusp::io::detail::matrix_market_cache().enabled = false;
+}
+
 } //end namespace io
 } //end namespace cusp
 
@@ -0,0 +1,302 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file matrix_market_cache.h
+ *  \brief Binary snapshots of parsed MatrixMarket files
+ */
+
+#pragma once
+
+#include <cusp/exception.h>
+#include <cusp/format.h>
+
+#include <cusp/detail/host/parallel.h>
+
+#include <cusp/io/binary.h>
+#include <cusp/io/detail/binary.h>
+#include <cusp/io/detail/mapped_file.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#endif
+
+namespace cusp
+{
+namespace io
+{
+namespace detail
+{
+
+// When the cache is enabled, read_matrix_market_file stores the matrix it
+// has parsed in a binary file (a snapshot) and later reads of the same file
+// into the same kind of container load the snapshot instead.  The name of
+// the snapshot is derived from the absolute path of the source and the
+// format, types and orientation of the container.  The snapshot starts with
+// a key that records the size and modification time of the source, followed
+// by the matrix in the cusp binary format, so a modified source is detected
+// and its snapshot is rewritten.
+
+struct matrix_market_cache_settings
+{
+  bool        enabled;
+  std::string directory;  // empty to store snapshots next to the source
+};
+
+// CUSP_MATRIX_MARKET_CACHE enables the cache: "1" or an empty value stores
+// the snapshots next to the source files, any other value except "0" is the
+// directory that holds them
+inline matrix_market_cache_settings matrix_market_cache_environment(void)
+{
+  matrix_market_cache_settings settings;
+
+  const char * value = std::getenv("CUSP_MATRIX_MARKET_CACHE");
+
+  settings.enabled = value != 0 && std::strcmp(value, "0") != 0;
+
+  if (settings.enabled && std::strcmp(value, "1") != 0)
+    settings.directory = value;
+
+  return settings;
+}
+
+inline matrix_market_cache_settings& matrix_market_cache(void)
+{
+  static matrix_market_cache_settings settings = matrix_market_cache_environment();
+  return settings;
+}
+
+struct matrix_market_cache_key
+{
+  char        magic[8];
+  binary_word source_size;
+  binary_word source_seconds;
+  binary_word source_nanoseconds;
+  binary_word format;
+  binary_word index_kind;
+  binary_word index_size;
+  binary_word value_kind;
+  binary_word value_size;
+  binary_word orientation;
+};
+
+inline const char * matrix_market_cache_magic(void)
+{
+  return "CUSPMMC";
+}
+
+// the binary data follows the key, aligned like the arrays it contains
+inline size_t matrix_market_cache_offset(void)
+{
+  return binary_round_up(sizeof(matrix_market_cache_key));
+}
+
+inline binary_word matrix_market_cache_format(cusp::array1d_format) { return binary_array1d; }
+inline binary_word matrix_market_cache_format(cusp::array2d_format) { return binary_array2d; }
+inline binary_word matrix_market_cache_format(cusp::coo_format)     { return binary_coo; }
+inline binary_word matrix_market_cache_format(cusp::csr_format)     { return binary_csr; }
+inline binary_word matrix_market_cache_format(cusp::dia_format)     { return binary_dia; }
+inline binary_word matrix_market_cache_format(cusp::ell_format)     { return binary_ell; }
+inline binary_word matrix_market_cache_format(cusp::hyb_format)     { return binary_hyb; }
+
+template <typename Matrix>
+void matrix_market_cache_types(matrix_market_cache_key& key, cusp::array1d_format)
+{
+  key.value_kind = binary_element<typename Matrix::value_type>::kind;
+  key.value_size = sizeof(typename Matrix::value_type);
+}
+
+template <typename Matrix>
+void matrix_market_cache_types(matrix_market_cache_key& key, cusp::array2d_format)
+{
+  key.index_kind  = binary_element<typename Matrix::index_type>::kind;
+  key.index_size  = sizeof(typename Matrix::index_type);
+  key.value_kind  = binary_element<typename Matrix::value_type>::kind;
+  key.value_size  = sizeof(typename Matrix::value_type);
+  key.orientation = binary_orientation(typename Matrix::orientation());
+}
+
+template <typename Matrix, typename Format>
+void matrix_market_cache_types(matrix_market_cache_key& key, Format)
+{
+  key.index_kind = binary_element<typename Matrix::index_type>::kind;
+  key.index_size = sizeof(typename Matrix::index_type);
+  key.value_kind = binary_element<typename Matrix::value_type>::kind;
+  key.value_size = sizeof(typename Matrix::value_type);
+}
+
+inline std::string absolute_path(const std::string& filename)
+{
+#if !defined(_WIN32)
+  if (!filename.empty() && filename[0] != '/')
+  {
+    std::vector<char> buffer(4096);
+
+    if (getcwd(&buffer[0], buffer.size()) != 0)
+      return std::string(&buffer[0]) + "/" + filename;
+  }
+#endif
+
+  return filename;
+}
+
+// Determine the key of the file and the name of its snapshot.  Returns
+// false if the cache is disabled or the file cannot be cached.
+template <typename Matrix>
+bool find_matrix_market_snapshot(const std::string& filename, std::string& snapshot, matrix_market_cache_key& key)
+{
+#if defined(_WIN32)
+  return false;
+#else
+  typedef typename Matrix::format Format;
+
+  const matrix_market_cache_settings& settings = matrix_market_cache();
+
+  if (!settings.enabled)
+    return false;
+
+  struct stat status;
+
+  if (stat(filename.c_str(), &status) != 0 || !S_ISREG(status.st_mode))
+    return false;
+
+  std::memset(&key, 0, sizeof(matrix_market_cache_key));
+  std::memcpy(key.magic, matrix_market_cache_magic(), 8);
+
+  key.source_size    = status.st_size;
+  key.source_seconds = status.st_mtime;
+#if defined(__APPLE__)
+  key.source_nanoseconds = status.st_mtimespec.tv_nsec;
+#else
+  key.source_nanoseconds = status.st_mtim.tv_nsec;
+#endif
+  key.format = matrix_market_cache_format(Format());
+  matrix_market_cache_types<Matrix>(key, Format());
+
+  // snapshots of the same source differ in the format, types and orientation
+  const std::string path = absolute_path(filename);
+
+  std::string identity(path);
+  identity.append(reinterpret_cast<const char *>(&key.format), 6 * sizeof(binary_word));
+
+  std::ostringstream name;
+  name << std::hex << std::setw(16) << std::setfill('0') << binary_checksum(identity.data(), identity.size());
+
+  const std::string::size_type slash = path.find_last_of('/');
+
+  const std::string base = slash == std::string::npos ? path : path.substr(slash + 1);
+
+  std::string directory = settings.directory;
+
+  if (directory.empty())
+    directory = slash == std::string::npos ? std::string(".") : path.substr(0, slash);
+
+  snapshot = directory + "/" + base + "." + name.str() + ".cusp";
+
+  return true;
+#endif
+}
+
+// Read the snapshot into mtx.  Returns false if the snapshot does not exist,
+// belongs to another version of the source or is damaged.
+template <typename Matrix>
+bool read_matrix_market_snapshot(Matrix& mtx, const std::string& snapshot, const matrix_market_cache_key& key)
+{
+  try
+  {
+    mapped_file file(snapshot);
+
+    const size_t offset = matrix_market_cache_offset();
+
+    if (file.size() < offset || std::memcmp(file.begin(), &key, sizeof(matrix_market_cache_key)) != 0)
+      return false;
+
+    read_binary_buffer(mtx, file.begin() + offset, file.end(), typename Matrix::format());
+  }
+  catch (cusp::io_exception&)
+  {
+    return false;
+  }
+
+  return true;
+}
+
+// Write mtx to the snapshot.  The cache is only an optimization, so a
+// snapshot that cannot be written is silently skipped.  The snapshot is
+// written to a temporary file which is then renamed, so concurrent readers
+// never see a partial snapshot.  The name of the temporary file holds the
+// process id, the stack address of the writing thread and a counter, so
+// concurrent writers never share it.
+template <typename Matrix>
+void write_matrix_market_snapshot(const Matrix& mtx, const std::string& snapshot, const matrix_market_cache_key& key)
+{
+#if !defined(_WIN32)
+  const matrix_market_cache_settings& settings = matrix_market_cache();
+
+  if (!settings.directory.empty())
+    mkdir(settings.directory.c_str(), 0777);
+
+  static size_t writes = 0;
+
+  std::ostringstream temporary;
+  temporary << snapshot << ".tmp" << getpid()
+            << "." << reinterpret_cast<size_t>(&temporary)
+            << "." << cusp::detail::host::fetch_and_add(writes, size_t(1));
+
+  try
+  {
+    std::ofstream file(temporary.str().c_str(), std::ios::out | std::ios::binary);
+
+    if (!file)
+      return;
+
+    const char padding[binary_alignment] = {0};
+
+    file.write(reinterpret_cast<const char *>(&key), sizeof(matrix_market_cache_key));
+    file.write(padding, matrix_market_cache_offset() - sizeof(matrix_market_cache_key));
+
+    cusp::io::write_binary_stream(mtx, file);
+
+    file.close();
+
+    if (!file)
+      throw cusp::io_exception("unable to write MatrixMarket snapshot");
+  }
+  catch (cusp::io_exception&)
+  {
+    std::remove(temporary.str().c_str());
+    return;
+  }
+
+  if (std::rename(temporary.str().c_str(), snapshot.c_str()) != 0)
+    std::remove(temporary.str().c_str());
+#endif
+}
+
+} // end namespace detail
+} // end namespace io
+} // end namespace cusp
+
@@ -0,0 +1,356 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file parse.h
+ *  \brief Locale independent number parsing and parallel line scanning
+ */
+
+#pragma once
+
+#include <cusp/detail/host/parallel.h>
+
+#include <algorithm>
+#include <clocale>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <locale>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace cusp
+{
+namespace io
+{
+namespace detail
+{
+
+// minimum number of bytes worth handing to a parsing thread
+const size_t parse_grain_size = 1 << 20;
+
+inline bool is_blank(const char c)
+{
+  return c == ' ' || c == '\t' || c == '\r';
+}
+
+inline bool is_digit(const char c)
+{
+  return c >= '0' && c <= '9';
+}
+
+// advance p past spaces and tabs (but not newlines)
+inline const char * skip_blanks(const char * p, const char * end)
+{
+  while (p != end && is_blank(*p))
+    p++;
+  return p;
+}
+
+// start of the line following the one containing p
+inline const char * next_line(const char * p, const char * end)
+{
+  if (p == end)
+    return end;
+
+  const char * newline = static_cast<const char *>(std::memchr(p, '\n', end - p));
+  return newline ? newline + 1 : end;
+}
+
+// end of the line containing p (the newline or the end of the buffer)
+inline const char * line_end(const char * p, const char * end)
+{
+  if (p == end)
+    return end;
+
+  const char * newline = static_cast<const char *>(std::memchr(p, '\n', end - p));
+  return newline ? newline : end;
+}
+
+// true if the token ending at p is followed by a separator
+inline bool at_separator(const char * p, const char * end)
+{
+  return p == end || is_blank(*p) || *p == '\n';
+}
+
+// Parse a signed decimal integer at p.  On success p is advanced past the
+// integer and true is returned.  Integers too large for IntegerType are
+// rejected.
+template <typename IntegerType>
+bool parse_integer(const char *& p, const char * end, IntegerType& value)
+{
+  const char * q = skip_blanks(p, end);
+
+  bool negative = false;
+
+  if (q != end && (*q == '-' || *q == '+'))
+    negative = (*q++ == '-');
+
+  if (q == end || !is_digit(*q))
+    return false;
+
+  const IntegerType max_value = std::numeric_limits<IntegerType>::max();
+
+  IntegerType result = 0;
+
+  while (q != end && is_digit(*q))
+  {
+    const IntegerType digit = IntegerType(*q++ - '0');
+
+    // the value does not fit in IntegerType
+    if (result > (max_value - digit) / 10)
+      return false;
+
+    result = 10 * result + digit;
+  }
+
+  if (!at_separator(q, end))
+    return false;
+
+  value = negative ? IntegerType(-result) : result;
+  p     = q;
+
+  return true;
+}
+
+// Parse a real number at p.  Numbers whose significant digits fit in 53
+// bits and whose power of ten is exactly representable (the common case for
+// data written with printf) are converted with a single multiplication or
+// division, which is correctly rounded.  Anything else (long mantissas,
+// large exponents, inf and nan) is converted with strtod, or with a stream
+// imbued with the classic locale when the global locale does not use '.' as
+// the decimal point, so the result never depends on the locale.
+inline bool parse_real(const char *& p, const char * end, double& value)
+{
+  static const double powers_of_ten[] =
+    { 1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+      1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+  const char * start = skip_blanks(p, end);
+  const char * q     = start;
+
+  bool negative = false;
+
+  if (q != end && (*q == '-' || *q == '+'))
+    negative = (*q++ == '-');
+
+  unsigned long long mantissa = 0;
+  int  significant_digits = 0;
+  int  exponent           = 0;
+  bool any_digits         = false;
+
+  while (q != end && is_digit(*q))
+  {
+    if (significant_digits < 19)
+    {
+      mantissa = 10 * mantissa + (*q - '0');
+      if (mantissa != 0) significant_digits++;
+    }
+    else
+    {
+      exponent++;
+    }
+
+    any_digits = true;
+    q++;
+  }
+
+  if (q != end && *q == '.')
+  {
+    q++;
+
+    while (q != end && is_digit(*q))
+    {
+      if (significant_digits < 19)
+      {
+        mantissa = 10 * mantissa + (*q - '0');
+        if (mantissa != 0) significant_digits++;
+        exponent--;
+      }
+
+      any_digits = true;
+      q++;
+    }
+  }
+
+  bool exact = any_digits;
+
+  if (exact && q != end && (*q == 'e' || *q == 'E'))
+  {
+    q++;
+
+    bool negative_exponent = false;
+
+    if (q != end && (*q == '-' || *q == '+'))
+      negative_exponent = (*q++ == '-');
+
+    if (q == end || !is_digit(*q))
+      return false;
+
+    int e = 0;
+
+    while (q != end && is_digit(*q))
+    {
+      if (e < 100000)
+        e = 10 * e + (*q - '0');
+      q++;
+    }
+
+    exponent += negative_exponent ? -e : e;
+  }
+
+  exact = exact && at_separator(q, end) && mantissa <= (1ULL << 53) && exponent >= -22 && exponent <= 22;
+
+  if (exact)
+  {
+    double result = double(mantissa);
+
+    if (exponent < 0)
+      result /= powers_of_ten[-exponent];
+    else
+      result *= powers_of_ten[exponent];
+
+    value = negative ? -result : result;
+    p     = q;
+
+    return true;
+  }
+
+  // otherwise convert the whole token with the C library
+  q = start;
+  while (!at_separator(q, end))
+    q++;
+
+  if (q == start)
+    return false;
+
+  double result;
+
+  if (q - start < 64 && std::localeconv()->decimal_point[0] == '.')
+  {
+    char token[64];
+    std::memcpy(token, start, q - start);
+    token[q - start] = '\0';
+
+    char * token_end;
+    result = std::strtod(token, &token_end);
+
+    if (token_end != token + (q - start))
+      return false;
+  }
+  else
+  {
+    // strtod would use the decimal point of the global locale
+    std::istringstream stream(std::string(start, q));
+    stream.imbue(std::locale::classic());
+
+    if (!(stream >> result) || stream.rdbuf()->in_avail() != 0)
+      return false;
+  }
+
+  value = result;
+  p     = q;
+
+  return true;
+}
+
+// Call parser(n, begin, end) for the first num_lines non-blank lines of
+// [begin,end), where n is the index of the line and [begin,end) its
+// contents without the newline.  The buffer is split into newline aligned
+// chunks that are scanned by separate threads: a counting pass locates the
+// lines of each chunk and a second pass parses them.  The parser returns
+// zero on success or an error code, and the first error (in file order) is
+// returned.  The number of lines parsed, at most num_lines, is stored in
+// num_lines_found.
+template <typename LineParser>
+int parse_lines(const char * begin, const char * end, const size_t num_lines,
+                LineParser& parser, size_t& num_lines_found)
+{
+  using namespace cusp::detail::host;
+
+  // chunk t is [bounds[t], bounds[t+1])
+  std::vector<const char *> bounds;
+  std::vector<size_t>       counts;
+  std::vector<int>          errors;
+
+  #pragma omp parallel num_threads(num_threads(end - begin, parse_grain_size))
+  {
+    const size_t tid  = thread_num();
+    const size_t size = team_size();
+
+    #pragma omp single
+    {
+      bounds.assign(size + 1, end);
+      bounds[0] = begin;
+
+      for (size_t t = 1; t < size; t++)
+        bounds[t] = std::max(bounds[t - 1], next_line(begin + partition_begin(end - begin, t, size) - 1, end));
+
+      counts.assign(size + 1, 0);
+      errors.assign(size, 0);
+    }
+
+    size_t count = 0;
+
+    for (const char * p = bounds[tid]; p != bounds[tid + 1]; p = next_line(p, bounds[tid + 1]))
+    {
+      const char * q = skip_blanks(p, bounds[tid + 1]);
+
+      if (q != bounds[tid + 1] && *q != '\n')
+        count++;
+    }
+
+    counts[tid] = count;
+
+    #pragma omp barrier
+
+    #pragma omp single
+    counts_to_offsets(counts);
+
+    size_t n = counts[tid];
+
+    for (const char * p = bounds[tid]; p != bounds[tid + 1] && n < num_lines; p = next_line(p, bounds[tid + 1]))
+    {
+      const char * q = skip_blanks(p, bounds[tid + 1]);
+
+      if (q == bounds[tid + 1] || *q == '\n')
+        continue;
+
+      int error = parser(n, q, line_end(q, bounds[tid + 1]));
+
+      if (error != 0)
+      {
+        errors[tid] = error;
+        break;
+      }
+
+      n++;
+    }
+  }
+
+  num_lines_found = std::min(counts.back(), num_lines);
+
+  for (size_t t = 0; t < errors.size(); t++)
+    if (errors[t] != 0)
+      return errors[t];
+
+  return 0;
+}
+
+} // end namespace detail
+} // end namespace io
+} // end namespace cusp
+
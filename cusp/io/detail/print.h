@@ -0,0 +1,506 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file print.h
+ *  \brief Locale independent number formatting and parallel line output
+ */
+
+#pragma once
+
+#include <cusp/complex.h>
+
+#include <cusp/detail/host/parallel.h>
+#include <cusp/io/detail/parse.h>
+
+#include <algorithm>
+#include <clocale>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+namespace cusp
+{
+namespace io
+{
+namespace detail
+{
+
+// longest line printed for a matrix entry (two indices and a complex value)
+const size_t max_line_length = 128;
+
+// number of lines formatted by a thread before they are written
+const size_t print_grain_size = 1 << 16;
+
+// Print the decimal representation of an integer at p and return the end
+inline char * print_integer(char * p, const long long value)
+{
+  unsigned long long magnitude = value < 0 ? 0ULL - static_cast<unsigned long long>(value) : value;
+
+  if (value < 0)
+    *p++ = '-';
+
+  char digits[20];
+  int  n = 0;
+
+  do
+  {
+    digits[n++] = static_cast<char>('0' + magnitude % 10);
+    magnitude /= 10;
+  }
+  while (magnitude != 0);
+
+  while (n > 0)
+    *p++ = digits[--n];
+
+  return p;
+}
+
+// Print x with the given number of significant digits in the style of %g,
+// using '.' as the decimal point regardless of the locale
+inline char * print_real(char * p, const double x, const int precision)
+{
+  const int n = std::sprintf(p, "%.*g", precision, x);
+
+  const char point = std::localeconv()->decimal_point[0];
+
+  if (point != '.')
+    std::replace(p, p + n, point, '.');
+
+  return p + n;
+}
+
+// Shortest decimal digits of a floating point number with the Grisu2
+// algorithm of Loitsch, "Printing Floating-Point Numbers Quickly and
+// Accurately with Integers" (PLDI 2010).  The digits always read back to
+// the same number and are the shortest such digits for almost all inputs.
+
+// a 64-bit significand f and a binary exponent e representing f * 2^e
+struct diy_fp
+{
+  unsigned long long f;
+  int                e;
+
+  diy_fp(unsigned long long f, int e) : f(f), e(e) {}
+};
+
+// the upper 64 bits of the product, rounded
+inline diy_fp multiply(const diy_fp& x, const diy_fp& y)
+{
+  const unsigned long long mask = 0xFFFFFFFFULL;
+
+  const unsigned long long a = x.f >> 32, b = x.f & mask;
+  const unsigned long long c = y.f >> 32, d = y.f & mask;
+
+  const unsigned long long ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+
+  const unsigned long long middle = (bd >> 32) + (ad & mask) + (bc & mask) + (1ULL << 31);
+
+  return diy_fp(ac + (ad >> 32) + (bc >> 32) + (middle >> 32), x.e + y.e + 64);
+}
+
+inline diy_fp normalize(diy_fp x)
+{
+  while ((x.f >> 63) == 0)
+  {
+    x.f <<= 1;
+    x.e--;
+  }
+
+  return x;
+}
+
+// Normalized value v of the positive number x and the boundaries m_minus and
+// m_plus of the interval of numbers that round to x, with m_minus scaled to
+// the exponent of m_plus
+template <typename FloatType, typename BitsType>
+void float_boundaries(const FloatType x, diy_fp& v, diy_fp& m_minus, diy_fp& m_plus)
+{
+  const int precision = std::numeric_limits<FloatType>::digits;
+  const int bias      = std::numeric_limits<FloatType>::max_exponent - 1 + (precision - 1);
+
+  const unsigned long long hidden_bit = 1ULL << (precision - 1);
+
+  BitsType bits;
+  std::memcpy(&bits, &x, sizeof(FloatType));
+
+  const unsigned long long E = static_cast<unsigned long long>(bits) >> (precision - 1);
+  const unsigned long long F = static_cast<unsigned long long>(bits) & (hidden_bit - 1);
+
+  const diy_fp value = E == 0 ? diy_fp(F, 1 - bias) : diy_fp(F + hidden_bit, int(E) - bias);
+
+  // the gap to the next smaller number is halved at powers of two
+  const bool closer_lower = F == 0 && E > 1;
+
+  m_plus  = normalize(diy_fp(2 * value.f + 1, value.e - 1));
+  m_minus = closer_lower ? diy_fp(4 * value.f - 1, value.e - 2) : diy_fp(2 * value.f - 1, value.e - 1);
+
+  m_minus.f <<= m_minus.e - m_plus.e;
+  m_minus.e   = m_plus.e;
+
+  v = normalize(value);
+}
+
+// c = 10^k as a normalized diy_fp such that the exponent of c * w lies in
+// [-60,-32] for a normalized w with binary exponent e
+inline diy_fp cached_power(const int e, int& k)
+{
+  struct power { unsigned long long f; int e; int k; };
+
+  // 10^-300, 10^-292, ..., 10^324
+  static const power powers[] = {
+    { 0xAB70FE17C79AC6CAULL, -1060, -300 },
+    { 0xFF77B1FCBEBCDC4FULL, -1034, -292 },
+    { 0xBE5691EF416BD60CULL, -1007, -284 },
+    { 0x8DD01FAD907FFC3CULL,  -980, -276 },
+    { 0xD3515C2831559A83ULL,  -954, -268 },
+    { 0x9D71AC8FADA6C9B5ULL,  -927, -260 },
+    { 0xEA9C227723EE8BCBULL,  -901, -252 },
+    { 0xAECC49914078536DULL,  -874, -244 },
+    { 0x823C12795DB6CE57ULL,  -847, -236 },
+    { 0xC21094364DFB5637ULL,  -821, -228 },
+    { 0x9096EA6F3848984FULL,  -794, -220 },
+    { 0xD77485CB25823AC7ULL,  -768, -212 },
+    { 0xA086CFCD97BF97F4ULL,  -741, -204 },
+    { 0xEF340A98172AACE5ULL,  -715, -196 },
+    { 0xB23867FB2A35B28EULL,  -688, -188 },
+    { 0x84C8D4DFD2C63F3BULL,  -661, -180 },
+    { 0xC5DD44271AD3CDBAULL,  -635, -172 },
+    { 0x936B9FCEBB25C996ULL,  -608, -164 },
+    { 0xDBAC6C247D62A584ULL,  -582, -156 },
+    { 0xA3AB66580D5FDAF6ULL,  -555, -148 },
+    { 0xF3E2F893DEC3F126ULL,  -529, -140 },
+    { 0xB5B5ADA8AAFF80B8ULL,  -502, -132 },
+    { 0x87625F056C7C4A8BULL,  -475, -124 },
+    { 0xC9BCFF6034C13053ULL,  -449, -116 },
+    { 0x964E858C91BA2655ULL,  -422, -108 },
+    { 0xDFF9772470297EBDULL,  -396, -100 },
+    { 0xA6DFBD9FB8E5B88FULL,  -369,  -92 },
+    { 0xF8A95FCF88747D94ULL,  -343,  -84 },
+    { 0xB94470938FA89BCFULL,  -316,  -76 },
+    { 0x8A08F0F8BF0F156BULL,  -289,  -68 },
+    { 0xCDB02555653131B6ULL,  -263,  -60 },
+    { 0x993FE2C6D07B7FACULL,  -236,  -52 },
+    { 0xE45C10C42A2B3B06ULL,  -210,  -44 },
+    { 0xAA242499697392D3ULL,  -183,  -36 },
+    { 0xFD87B5F28300CA0EULL,  -157,  -28 },
+    { 0xBCE5086492111AEBULL,  -130,  -20 },
+    { 0x8CBCCC096F5088CCULL,  -103,  -12 },
+    { 0xD1B71758E219652CULL,   -77,   -4 },
+    { 0x9C40000000000000ULL,   -50,    4 },
+    { 0xE8D4A51000000000ULL,   -24,   12 },
+    { 0xAD78EBC5AC620000ULL,     3,   20 },
+    { 0x813F3978F8940984ULL,    30,   28 },
+    { 0xC097CE7BC90715B3ULL,    56,   36 },
+    { 0x8F7E32CE7BEA5C70ULL,    83,   44 },
+    { 0xD5D238A4ABE98068ULL,   109,   52 },
+    { 0x9F4F2726179A2245ULL,   136,   60 },
+    { 0xED63A231D4C4FB27ULL,   162,   68 },
+    { 0xB0DE65388CC8ADA8ULL,   189,   76 },
+    { 0x83C7088E1AAB65DBULL,   216,   84 },
+    { 0xC45D1DF942711D9AULL,   242,   92 },
+    { 0x924D692CA61BE758ULL,   269,  100 },
+    { 0xDA01EE641A708DEAULL,   295,  108 },
+    { 0xA26DA3999AEF774AULL,   322,  116 },
+    { 0xF209787BB47D6B85ULL,   348,  124 },
+    { 0xB454E4A179DD1877ULL,   375,  132 },
+    { 0x865B86925B9BC5C2ULL,   402,  140 },
+    { 0xC83553C5C8965D3DULL,   428,  148 },
+    { 0x952AB45CFA97A0B3ULL,   455,  156 },
+    { 0xDE469FBD99A05FE3ULL,   481,  164 },
+    { 0xA59BC234DB398C25ULL,   508,  172 },
+    { 0xF6C69A72A3989F5CULL,   534,  180 },
+    { 0xB7DCBF5354E9BECEULL,   561,  188 },
+    { 0x88FCF317F22241E2ULL,   588,  196 },
+    { 0xCC20CE9BD35C78A5ULL,   614,  204 },
+    { 0x98165AF37B2153DFULL,   641,  212 },
+    { 0xE2A0B5DC971F303AULL,   667,  220 },
+    { 0xA8D9D1535CE3B396ULL,   694,  228 },
+    { 0xFB9B7CD9A4A7443CULL,   720,  236 },
+    { 0xBB764C4CA7A44410ULL,   747,  244 },
+    { 0x8BAB8EEFB6409C1AULL,   774,  252 },
+    { 0xD01FEF10A657842CULL,   800,  260 },
+    { 0x9B10A4E5E9913129ULL,   827,  268 },
+    { 0xE7109BFBA19C0C9DULL,   853,  276 },
+    { 0xAC2820D9623BF429ULL,   880,  284 },
+    { 0x80444B5E7AA7CF85ULL,   907,  292 },
+    { 0xBF21E44003ACDD2DULL,   933,  300 },
+    { 0x8E679C2F5E44FF8FULL,   960,  308 },
+    { 0xD433179D9C8CB841ULL,   986,  316 },
+    { 0x9E19DB92B4E31BA9ULL,  1013,  324 }
+  };
+
+  const int f = -60 - e - 1;
+
+  const int estimate = (f * 78913) / (1 << 18) + (f > 0 ? 1 : 0);
+
+  const power& c = powers[(300 + estimate + 7) / 8];
+
+  k = c.k;
+
+  return diy_fp(c.f, c.e);
+}
+
+// move the last digit towards w while the result stays in the interval
+inline void grisu_round(char * digits, const int length, const unsigned long long distance,
+                        const unsigned long long delta, unsigned long long rest, const unsigned long long ten_k)
+{
+  while (rest < distance && delta - rest >= ten_k &&
+         (rest + ten_k < distance || distance - rest > rest + ten_k - distance))
+  {
+    digits[length - 1]--;
+    rest += ten_k;
+  }
+}
+
+// Generate the digits of w, the shortest in [M_minus,M_plus].  Returns the
+// number of digits; the value is digits * 10^exponent.
+inline int grisu_digits(char * digits, int& exponent, const diy_fp& M_minus, const diy_fp& w, const diy_fp& M_plus)
+{
+  unsigned long long delta    = M_plus.f - M_minus.f;
+  unsigned long long distance = M_plus.f - w.f;
+
+  const int                shift = -M_plus.e;
+  const unsigned long long one   = 1ULL << shift;
+
+  unsigned int       p1 = static_cast<unsigned int>(M_plus.f >> shift);
+  unsigned long long p2 = M_plus.f & (one - 1);
+
+  unsigned int power = 1000000000;
+  int          n     = 10;
+
+  while (n > 1 && p1 < power)
+  {
+    power /= 10;
+    n--;
+  }
+
+  int length = 0;
+
+  // integral part
+  while (n > 0)
+  {
+    digits[length++] = static_cast<char>('0' + p1 / power);
+
+    p1 %= power;
+    n--;
+
+    const unsigned long long rest = (static_cast<unsigned long long>(p1) << shift) + p2;
+
+    if (rest <= delta)
+    {
+      exponent += n;
+      grisu_round(digits, length, distance, delta, rest, static_cast<unsigned long long>(power) << shift);
+      return length;
+    }
+
+    power /= 10;
+  }
+
+  // fractional part
+  int m = 0;
+
+  while (true)
+  {
+    p2 *= 10;
+
+    digits[length++] = static_cast<char>('0' + (p2 >> shift));
+
+    p2 &= one - 1;
+    m++;
+
+    delta    *= 10;
+    distance *= 10;
+
+    if (p2 <= delta)
+      break;
+  }
+
+  exponent -= m;
+  grisu_round(digits, length, distance, delta, p2, one);
+
+  return length;
+}
+
+// Print digits * 10^exponent like %g, but with all of the digits
+inline char * print_digits(char * p, const char * digits, const int length, const int exponent)
+{
+  // position of the decimal point relative to the first digit
+  const int n = length + exponent;
+
+  if (length <= n && n <= 15)
+  {
+    // integer
+    p = std::copy(digits, digits + length, p);
+    p = std::fill_n(p, n - length, '0');
+  }
+  else if (0 < n && n <= 15)
+  {
+    p = std::copy(digits, digits + n, p);
+    *p++ = '.';
+    p = std::copy(digits + n, digits + length, p);
+  }
+  else if (-4 < n && n <= 0)
+  {
+    *p++ = '0';
+    *p++ = '.';
+    p = std::fill_n(p, -n, '0');
+    p = std::copy(digits, digits + length, p);
+  }
+  else
+  {
+    *p++ = digits[0];
+
+    if (length > 1)
+    {
+      *p++ = '.';
+      p = std::copy(digits + 1, digits + length, p);
+    }
+
+    *p++ = 'e';
+    p = print_integer(p, n - 1);
+  }
+
+  return p;
+}
+
+// Print the shortest representation of x that parses back to x
+template <typename FloatType, typename BitsType>
+char * print_shortest(char * p, FloatType x)
+{
+  if (x != x || x - x != x - x)
+    return print_real(p, x, std::numeric_limits<FloatType>::digits10);  // nan or inf
+
+  BitsType bits;
+  std::memcpy(&bits, &x, sizeof(FloatType));
+
+  if (bits >> (8 * sizeof(FloatType) - 1))
+  {
+    *p++ = '-';
+    x = -x;
+  }
+
+  // integers are printed exactly without scaling
+  if (x < 1e15 && x == std::floor(x))
+    return print_integer(p, static_cast<long long>(x));
+
+  diy_fp v(0, 0), m_minus(0, 0), m_plus(0, 0);
+  float_boundaries<FloatType,BitsType>(x, v, m_minus, m_plus);
+
+  int k;
+  const diy_fp c = cached_power(m_plus.e, k);
+
+  // the scaled boundaries are narrowed by one unit to absorb the rounding
+  // errors of the multiplications
+  const diy_fp w       = multiply(v, c);
+  const diy_fp w_minus = multiply(m_minus, c);
+  const diy_fp w_plus  = multiply(m_plus, c);
+
+  char digits[20];
+  int  exponent = -k;
+
+  const int length = grisu_digits(digits, exponent, diy_fp(w_minus.f + 1, w_minus.e), w, diy_fp(w_plus.f - 1, w_plus.e));
+
+  return print_digits(p, digits, length, exponent);
+}
+
+inline char * print_value(char * p, const double x)
+{
+  return print_shortest<double,unsigned long long>(p, x);
+}
+
+// Values are read back in double precision.  In rare cases the digits of a
+// float lie so close to a rounding boundary that the double nearest to them
+// rounds to another float, so the result is checked.
+inline char * print_value(char * p, const float x)
+{
+  char * end = print_shortest<float,unsigned int>(p, x);
+
+  const char * q = p;
+  double parsed;
+
+  if (parse_real(q, end, parsed) && q == end && float(parsed) == x)
+    return end;
+
+  return print_real(p, x, 9);
+}
+
+// other types (e.g. integers) are printed like doubles
+template <typename RealType>
+char * print_value(char * p, const RealType x)
+{
+  return print_value(p, static_cast<double>(x));
+}
+
+template <typename RealType>
+char * print_value(char * p, const cusp::complex<RealType>& x)
+{
+  p = print_value(p, x.real());
+  *p++ = ' ';
+  return print_value(p, x.imag());
+}
+
+// Write num_lines lines to output, where printer(n, p) prints line n
+// (including the newline, at most max_line_length characters) at p and
+// returns the end.  Blocks of lines are formatted by separate threads into
+// their own buffers, which are then written in order.
+template <typename LinePrinter, typename Stream>
+void print_lines(Stream& output, const size_t num_lines, const LinePrinter& printer)
+{
+  using namespace cusp::detail::host;
+
+  const size_t T = num_threads(num_lines, print_grain_size);
+
+  const size_t block_size = std::min(num_lines, print_grain_size);
+  const size_t batch_size = T * print_grain_size;
+
+  std::vector< std::vector<char> > buffers(T);
+  std::vector<size_t>              sizes(T);
+
+  for (size_t first = 0; first < num_lines; first += batch_size)
+  {
+    const size_t last = std::min(num_lines, first + batch_size);
+
+    #pragma omp parallel for num_threads(T)
+    for (long t = 0; t < long(T); t++)
+    {
+      const size_t begin = std::min(last, first + t * print_grain_size);
+      const size_t end   = std::min(last, begin + print_grain_size);
+
+      std::vector<char>& buffer = buffers[t];
+
+      if (buffer.empty())
+        buffer.resize(block_size * max_line_length);
+
+      char * p = &buffer[0];
+
+      for (size_t n = begin; n < end; n++)
+        p = printer(n, p);
+
+      sizes[t] = p - &buffer[0];
+    }
+
+    for (size_t t = 0; t < T; t++)
+      if (sizes[t] > 0)
+        output.write(&buffers[t][0], sizes[t]);
+  }
+}
+
+} // end namespace detail
+} // end namespace io
+} // end namespace cusp
+
@@ -36,6 +36,10 @@ namespace io
  */
 
 /*! \p read_matrix_market_file : Read a MatrixMarket file
+ *
+ * gzip compressed files (e.g. \c A.mtx.gz) are recognized by their
+ * contents and decompressed in memory when cusp is compiled with
+ * \c CUSP_USE_ZLIB defined and linked with zlib.
  *
  * \param mtx a matrix container (e.g. \p csr_matrix or \p coo_matrix)
  * \param filename file name of the MatrixMarket file
@@ -94,6 +98,9 @@ void read_matrix_market_stream(Matrix& mtx, Stream& input);
 
 
 /*! \p write_matrix_market_file : Write a MatrixMarket file
+ *
+ * Files whose name ends in \c .gz are gzip compressed, which requires
+ * cusp to be compiled with \c CUSP_USE_ZLIB defined and linked with zlib.
  *
  * \param mtx a matrix container (e.g. \p csr_matrix or \p coo_matrix)
  * \param filename file name of the MatrixMarket file
@@ -158,6 +165,55 @@ void write_matrix_market_file(const Matrix& mtx, const std::string& filename);
 template <typename Matrix, typename Stream>
 void write_matrix_market_stream(const Matrix& mtx, Stream& output);
 
+/*! \p enable_matrix_market_cache : Cache the matrices read by
+ * \p read_matrix_market_file in binary files.
+ *
+ * When the cache is enabled, the first time a MatrixMarket file is read
+ * into a given format (e.g. a \p csr_matrix of \c int and \c float) the
+ * parsed matrix is saved in the cusp binary format.  Later reads of the
+ * same file into the same format load the binary snapshot instead of
+ * parsing the text.  A snapshot is replaced when the size or the
+ * modification time of the MatrixMarket file changes.
+ *
+ * The cache can also be enabled by setting the environment variable
+ * \c CUSP_MATRIX_MARKET_CACHE to a directory, or to \c 1 to store the
+ * snapshots next to the MatrixMarket files.
+ *
+ * \param directory directory that holds the snapshots, or an empty string
+ * to store each snapshot next to its MatrixMarket file
+ *
+ * \note the cache is only available on POSIX systems
+ * \note snapshots that cannot be written (e.g. to a read-only directory)
+ * are skipped and the file is parsed on every read
+ *
+ * \code
+ * #include <cusp/io/matrix_market.h>
+ * #include <cusp/csr_matrix.h>
+ *
+ * int main(void)
+ * {
+ *     cusp::io::enable_matrix_market_cache("/tmp/cusp_cache");
+ *
+ *     // the first run parses A.mtx, later runs load /tmp/cusp_cache/A.mtx.*.cusp
+ *     cusp::csr_matrix<int, float, cusp::host_memory> A;
+ *     cusp::io::read_matrix_market_file(A, "A.mtx");
+ *
+ *     return 0;
+ * }
+ * \endcode
+ *
+ * \see \p disable_matrix_market_cache
+ * \see \p read_matrix_market_file
+ */
+inline void enable_matrix_market_cache(const std::string& directory = std::string());
+
+/*! \p disable_matrix_market_cache : Parse every MatrixMarket file read by
+ * \p read_matrix_market_file.  Existing snapshots are left in place.
+ *
+ * \see \p enable_matrix_market_cache
+ */
+inline void disable_matrix_market_cache(void);
+
 /*! \}
  */
 
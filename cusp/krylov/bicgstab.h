@@ -117,6 +117,40 @@ void bicgstab(LinearOperator& A,
               Vector& b,
               Monitor& monitor,
               Preconditioner& M);
+
+/*! \p bicgstab : Biconjugate Gradient Stabilized method
+ *
+ * Solves the linear system A x = b with preconditioner \p M, keeping the
+ * residual, the shadow residual, the search direction and the iteration
+ * count in \p state.  If \p state holds a \p bicgstab solve that was
+ * interrupted (e.g. read with \p read_solver_state) the solve continues
+ * from where it stopped, otherwise a new solve starts.
+ *
+ * \param A matrix of the linear system 
+ * \param x approximate solution of the linear system
+ * \param b right-hand side of the linear system
+ * \param monitor montiors iteration and determines stopping conditions
+ * \param M preconditioner for A
+ * \param state state of the solver, which can be saved and resumed
+ *
+ * \tparam SolverState \p solver_state of the value type and memory space of \p A
+ *
+ * \throws cusp::invalid_input_exception if \p state belongs to another
+ * method or to a system of another size
+ *
+ *  \see \p solver_state
+ */
+template <class LinearOperator,
+          class Vector,
+          class Monitor,
+          class Preconditioner,
+          class SolverState>
+void bicgstab(LinearOperator& A,
+              Vector& x,
+              Vector& b,
+              Monitor& monitor,
+              Preconditioner& M,
+              SolverState& state);
 /*! \}
  */
 
@@ -20,6 +20,7 @@
 #include <cusp/multiply.h>
 #include <cusp/monitor.h>
 #include <cusp/linear_operator.h>
+#include <cusp/krylov/solver_state.h>
 
 namespace blas = cusp::blas;
 
@@ -66,6 +67,26 @@ void bicgstab(LinearOperator& A,
               Vector& b,
               Monitor& monitor,
               Preconditioner& M)
+{
+    typedef typename LinearOperator::value_type   ValueType;
+    typedef typename LinearOperator::memory_space MemorySpace;
+
+    cusp::krylov::solver_state<ValueType,MemorySpace> state;
+
+    cusp::krylov::bicgstab(A, x, b, monitor, M, state);
+}
+
+template <class LinearOperator,
+          class Vector,
+          class Monitor,
+          class Preconditioner,
+          class SolverState>
+void bicgstab(LinearOperator& A,
+              Vector& x,
+              Vector& b,
+              Monitor& monitor,
+              Preconditioner& M,
+              SolverState& state)
 {
     CUSP_PROFILE_SCOPED();
 
@@ -79,28 +100,37 @@ void bicgstab(LinearOperator& A,
     // allocate workspace
     cusp::array1d<ValueType,MemorySpace> y(N);
 
-    cusp::array1d<ValueType,MemorySpace>   p(N);
-    cusp::array1d<ValueType,MemorySpace>   r(N);
-    cusp::array1d<ValueType,MemorySpace>   r_star(N);
     cusp::array1d<ValueType,MemorySpace>   s(N);
     cusp::array1d<ValueType,MemorySpace>  Mp(N);
     cusp::array1d<ValueType,MemorySpace> AMp(N);
     cusp::array1d<ValueType,MemorySpace>  Ms(N);
     cusp::array1d<ValueType,MemorySpace> AMs(N);
 
-    // y <- Ax
-    cusp::multiply(A, x, y);
+    // the residuals, the search direction and <r_star, r> are kept in the state
+    const bool resume = cusp::krylov::detail::resume_solver_state(state, monitor, cusp::krylov::detail::bicgstab_solver, N, 3, 1);
+
+    typename SolverState::vector_type& p      = state.vectors[0];
+    typename SolverState::vector_type& r      = state.vectors[1];
+    typename SolverState::vector_type& r_star = state.vectors[2];
 
-    // r <- b - A*x
-    blas::axpby(b, y, r, ValueType(1), ValueType(-1));
+    ValueType& r_r_star_old = state.scalars[0];
 
-    // p <- r
-    blas::copy(r, p);
+    if (!resume)
+    {
+        // y <- Ax
+        cusp::multiply(A, x, y);
+
+        // r <- b - A*x
+        blas::axpby(b, y, r, ValueType(1), ValueType(-1));
 
-    // r_star <- r
-    blas::copy(r, r_star);
+        // p <- r
+        blas::copy(r, p);
 
-    ValueType r_r_star_old = blas::dotc(r_star, r);
+        // r_star <- r
+        blas::copy(r, r_star);
+
+        r_r_star_old = blas::dotc(r_star, r);
+    }
 
     while (!monitor.finished(r))
     {
@@ -119,6 +149,8 @@ void bicgstab(LinearOperator& A,
 	if (monitor.finished(s)){
 	  // x += alpha*M*p_j
 	  blas::axpby(x, Mp, x, ValueType(1), ValueType(alpha));
+	  // r <- s so the state reflects the converged residual
+	  blas::copy(s, r);
 	  break;
 	}
 
@@ -146,6 +178,8 @@ void bicgstab(LinearOperator& A,
         blas::axpbypcz(r, p, AMp, p, ValueType(1), beta, -beta*omega);
 
         ++monitor;
+
+        state.iteration_count = monitor.iteration_count();
     }
 }
 
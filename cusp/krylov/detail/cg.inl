@@ -20,6 +20,7 @@
 #include <cusp/multiply.h>
 #include <cusp/monitor.h>
 #include <cusp/linear_operator.h>
+#include <cusp/krylov/solver_state.h>
 
 namespace blas = cusp::blas;
 
@@ -66,6 +67,26 @@ void cg(LinearOperator& A,
         Vector& b,
         Monitor& monitor,
         Preconditioner& M)
+{
+    typedef typename LinearOperator::value_type   ValueType;
+    typedef typename LinearOperator::memory_space MemorySpace;
+
+    cusp::krylov::solver_state<ValueType,MemorySpace> state;
+
+    cusp::krylov::cg(A, x, b, monitor, M, state);
+}
+
+template <class LinearOperator,
+          class Vector,
+          class Monitor,
+          class Preconditioner,
+          class SolverState>
+void cg(LinearOperator& A,
+        Vector& x,
+        Vector& b,
+        Monitor& monitor,
+        Preconditioner& M,
+        SolverState& state)
 {
     CUSP_PROFILE_SCOPED();
 
@@ -79,23 +100,32 @@ void cg(LinearOperator& A,
     // allocate workspace
     cusp::array1d<ValueType,MemorySpace> y(N);
     cusp::array1d<ValueType,MemorySpace> z(N);
-    cusp::array1d<ValueType,MemorySpace> r(N);
-    cusp::array1d<ValueType,MemorySpace> p(N);
-        
-    // y <- Ax
-    cusp::multiply(A, x, y);
 
-    // r <- b - A*x
-    blas::axpby(b, y, r, ValueType(1), ValueType(-1));
-   
-    // z <- M*r
-    cusp::multiply(M, r, z);
+    // the residual, the search direction and <r^H, z> are kept in the state
+    const bool resume = cusp::krylov::detail::resume_solver_state(state, monitor, cusp::krylov::detail::cg_solver, N, 2, 1);
 
-    // p <- z
-    blas::copy(z, p);
-		
-    // rz = <r^H, z>
-    ValueType rz = blas::dotc(r, z);
+    typename SolverState::vector_type& r = state.vectors[0];
+    typename SolverState::vector_type& p = state.vectors[1];
+
+    ValueType& rz = state.scalars[0];
+
+    if (!resume)
+    {
+        // y <- Ax
+        cusp::multiply(A, x, y);
+
+        // r <- b - A*x
+        blas::axpby(b, y, r, ValueType(1), ValueType(-1));
+
+        // z <- M*r
+        cusp::multiply(M, r, z);
+
+        // p <- z
+        blas::copy(z, p);
+
+        // rz = <r^H, z>
+        rz = blas::dotc(r, z);
+    }
 
     while (!monitor.finished(r))
     {
@@ -126,6 +156,8 @@ void cg(LinearOperator& A,
         blas::axpby(z, p, p, ValueType(1), beta);
 
         ++monitor;
+
+        state.iteration_count = monitor.iteration_count();
     }
 }
 
@@ -14,10 +14,12 @@
  *  limitations under the License.
  */
 #include <cusp/array1d.h>
+#include <cusp/array2d.h>
 #include <cusp/blas.h>
 #include <cusp/multiply.h>
 #include <cusp/monitor.h>
 #include <cusp/linear_operator.h>
+#include <cusp/krylov/solver_state.h>
 
 namespace blas = cusp::blas;
 namespace cusp
@@ -107,6 +109,25 @@ namespace cusp
 	       const size_t restart,
 	       Monitor& monitor,
 	       Preconditioner& M)
+    {
+      typedef typename LinearOperator::value_type   ValueType;
+      typedef typename LinearOperator::memory_space MemorySpace;
+      cusp::krylov::solver_state<ValueType,MemorySpace> state;
+      cusp::krylov::gmres(A, x, b, restart, monitor, M, state);
+    }
+
+    template <class LinearOperator,
+	      class Vector,
+	      class Monitor,
+	      class Preconditioner,
+	      class SolverState>
+    void gmres(LinearOperator& A,
+	       Vector& x,
+	       Vector& b,
+	       const size_t restart,
+	       Monitor& monitor,
+	       Preconditioner& M,
+	       SolverState& state)
     {
       typedef typename LinearOperator::value_type   ValueType;
       typedef typename LinearOperator::memory_space MemorySpace;
@@ -121,13 +142,19 @@ namespace cusp
       cusp::array1d<ValueType,MemorySpace> w(N);
       cusp::array1d<ValueType,MemorySpace> V0(N); //Arnoldi matrix pos 0
       cusp::array2d<ValueType,MemorySpace,cusp::column_major> V(N,R+1,ValueType(0.0)); //Arnoldi matrix
-      //duplicate copy of s on GPU
-      cusp::array1d<ValueType,MemorySpace> sDev(R+1);
+      //views of the leading columns of V and of parts of host arrays
+      typedef typename cusp::array1d<ValueType,MemorySpace>::view        VectorView;
+      typedef cusp::array2d_view<VectorView,cusp::column_major>          MatrixView;
+      typedef typename cusp::array1d<ValueType,cusp::host_memory>::view HostVectorView;
       //HOST WORKSPACE
       cusp::array2d<ValueType,cusp::host_memory,cusp::column_major> H(R+1, R); //Hessenberg matrix
       cusp::array1d<ValueType,cusp::host_memory> s(R+1);
       cusp::array1d<ValueType,cusp::host_memory> cs(R);
       cusp::array1d<ValueType,cusp::host_memory> sn(R);
+      cusp::array1d<ValueType,cusp::host_memory> c(R); //reorthogonalization coefficients
+      // only x is carried between restart cycles, so a resumed solve
+      // starts a new cycle
+      cusp::krylov::detail::resume_solver_state(state, monitor, cusp::krylov::detail::gmres_solver, N, 0, 0);
       do{
 	// compute initial residual and its norm //
 	cusp::multiply(A, x, w);                     // V(0) = A*x        //
@@ -155,14 +182,28 @@ namespace cusp
 	  //V(i+1) = A*w = M*A*V(i)    //
 	  cusp::multiply(M,V0,w);
 	  
-	  for (k = 0; k <= i; k++){
-	    //  H(k,i) = <V(i+1),V(k)>    //
-	    H(k, i) = blas::dotc(w, V.column(k));
-	    // V(i+1) -= H(k, i) * V(k)  //
-	    blas::axpy(V.column(k),w,-H(k,i));
+	  // Arnoldi basis V(0:i) and column i of H //
+	  MatrixView Vi = cusp::make_array2d_view(N, i+1, V.pitch, cusp::make_array1d_view(V.values), cusp::column_major());
+	  HostVectorView Hi(H.values.begin() + H.pitch * i, H.values.begin() + H.pitch * i + i+1);
+	  
+	  // classical Gram-Schmidt, all columns in one pass //
+	  NormType wnorm = blas::nrm2(w);
+	  //  H(0:i,i) = V(0:i)^H V(i+1)           //
+	  blas::mdotc(Vi, w, Hi);
+	  //  V(i+1) -= V(0:i) * H(0:i,i)          //
+	  blas::maxpy(Vi, Hi, w, ValueType(-1));
+	  NormType hnorm = blas::nrm2(w);
+	  
+	  // reorthogonalize once if cancellation removed most of V(i+1) //
+	  if (hnorm < NormType(0.7071067811865476) * wnorm){
+	    HostVectorView Ci(c.begin(), c.begin() + i+1);
+	    blas::mdotc(Vi, w, Ci);
+	    blas::maxpy(Vi, Ci, w, ValueType(-1));
+	    blas::axpy(Ci, Hi, ValueType(1));
+	    hnorm = blas::nrm2(w);
 	  }
 	  
-	  H(i+1,i) = blas::nrm2(w);   
+	  H(i+1,i) = hnorm;
 	  // V(i+1) = V(i+1) / H(i+1, i) //
 	  blas::scal(w,ValueType(1.0)/H(i+1,i));
 	  blas::copy(w,V.column(i+1));
@@ -189,13 +230,10 @@ namespace cusp
 	
 	// update the solution //
 	
-	//copy s to gpu 
-	blas::copy(s,sDev);
 	// x= V(1:N,0:i)*s(0:i)+x //
-	for (j = 0; j <= i; j++){
-	  // x = x + s[j] * V(j) //
-	  blas::axpy(V.column(j),x,s[j]);
-	}
+	MatrixView Vi = cusp::make_array2d_view(N, i+1, V.pitch, cusp::make_array1d_view(V.values), cusp::column_major());
+	blas::maxpy(Vi, HostVectorView(s.begin(), s.begin() + i+1), x, ValueType(1));
+	state.iteration_count = monitor.iteration_count();
       } while (!monitor.finished(resid));
     }
   } // end namespace krylov
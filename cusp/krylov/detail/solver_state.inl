@@ -0,0 +1,197 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <cusp/exception.h>
+
+#include <cusp/io/binary.h>
+#include <cusp/io/detail/binary.h>
+#include <cusp/io/detail/mapped_file.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+namespace cusp
+{
+namespace krylov
+{
+namespace detail
+{
+
+enum solver_method
+{
+    no_solver       = 0,
+    cg_solver       = 1,
+    bicgstab_solver = 2,
+    gmres_solver    = 3
+};
+
+// A checkpoint is a sequence of cusp binary containers: a description of
+// the state, the iterate, the scalars and then each of the vectors.
+//
+//   description  array1d of binary_word
+//                  magic, method, num_rows, iteration_count, num_vectors
+typedef cusp::io::detail::binary_word solver_state_word;
+
+const solver_state_word solver_state_magic = 0x5441545350535543ULL; // "CUSPSTAT"
+const size_t            solver_state_words = 5;
+
+// Prepare state for a solve of N unknowns by method.  Returns true if the
+// state holds a solve in progress, in which case the monitor is advanced
+// to the iteration at which it stopped, and false if a new solve starts.
+template <typename SolverState, typename Monitor>
+bool resume_solver_state(SolverState& state, Monitor& monitor, const solver_method method,
+                         const size_t N, const size_t num_vectors, const size_t num_scalars)
+{
+    if (!state.empty())
+    {
+        if (state.method != size_t(method))
+            throw cusp::invalid_input_exception("solver state was produced by a different method");
+
+        if (state.num_rows != N || state.vectors.size() != num_vectors || state.scalars.size() != num_scalars)
+            throw cusp::invalid_input_exception("solver state does not match the linear system");
+
+        for (size_t i = 0; i < state.vectors.size(); i++)
+            if (state.vectors[i].size() != N)
+                throw cusp::invalid_input_exception("solver state does not match the linear system");
+
+        while (monitor.iteration_count() < state.iteration_count)
+            ++monitor;
+
+        return true;
+    }
+
+    state.method          = method;
+    state.num_rows        = N;
+    state.iteration_count = monitor.iteration_count();
+
+    state.vectors.resize(num_vectors);
+
+    for (size_t i = 0; i < num_vectors; i++)
+        state.vectors[i].resize(N);
+
+    state.scalars.resize(num_scalars);
+
+    return false;
+}
+
+// read the container at begin into array and return the end of the container
+template <typename Array>
+const char * read_solver_state_array(Array& array, const char * begin, const char * end)
+{
+    cusp::io::detail::binary_header header;
+    cusp::io::detail::read_binary_header(header, begin, end);
+    cusp::io::detail::read_binary_buffer(array, begin, end, cusp::array1d_format());
+
+    // the padding of the last container may be missing
+    return begin + std::min<size_t>(cusp::io::detail::binary_size(header), end - begin);
+}
+
+} // end namespace detail
+
+
+template <typename Vector, typename SolverState>
+void write_solver_state(const Vector& x, const SolverState& state, const std::string& filename)
+{
+    const std::string temporary = filename + ".tmp";
+
+    try
+    {
+        std::ofstream file(temporary.c_str(), std::ios::out | std::ios::binary);
+
+        if (!file)
+            throw cusp::io_exception(std::string("unable to open file \"") + temporary + std::string("\" for writing"));
+
+        cusp::array1d<detail::solver_state_word,cusp::host_memory> description(detail::solver_state_words);
+        description[0] = detail::solver_state_magic;
+        description[1] = state.method;
+        description[2] = state.num_rows;
+        description[3] = state.iteration_count;
+        description[4] = state.vectors.size();
+
+        cusp::io::write_binary_stream(description, file);
+        cusp::io::write_binary_stream(x, file);
+        cusp::io::write_binary_stream(state.scalars, file);
+
+        for (size_t i = 0; i < state.vectors.size(); i++)
+            cusp::io::write_binary_stream(state.vectors[i], file);
+
+        file.close();
+
+        if (!file)
+            throw cusp::io_exception(std::string("unable to write file \"") + temporary + std::string("\""));
+    }
+    catch (...)
+    {
+        std::remove(temporary.c_str());
+        throw;
+    }
+
+    // rename does not replace an existing file on some systems
+    if (std::rename(temporary.c_str(), filename.c_str()) != 0)
+    {
+        std::remove(filename.c_str());
+
+        if (std::rename(temporary.c_str(), filename.c_str()) != 0)
+        {
+            std::remove(temporary.c_str());
+            throw cusp::io_exception(std::string("unable to write file \"") + filename + std::string("\""));
+        }
+    }
+}
+
+template <typename Vector, typename SolverState>
+void read_solver_state(Vector& x, SolverState& state, const std::string& filename)
+{
+    cusp::io::detail::mapped_file file(filename);
+
+    const char * begin = file.begin();
+    const char * end   = file.end();
+
+    cusp::array1d<detail::solver_state_word,cusp::host_memory> description;
+
+    begin = detail::read_solver_state_array(description, begin, end);
+
+    if (description.size() != detail::solver_state_words || description[0] != detail::solver_state_magic)
+        throw cusp::io_exception("file \"" + filename + "\" does not contain a solver state");
+
+    state.clear();
+
+    begin = detail::read_solver_state_array(x, begin, end);
+
+    if (x.size() != description[2])
+        throw cusp::io_exception("invalid solver state: iterate size does not match the system");
+
+    begin = detail::read_solver_state_array(state.scalars, begin, end);
+
+    state.vectors.resize(description[4]);
+
+    for (size_t i = 0; i < state.vectors.size(); i++)
+    {
+        begin = detail::read_solver_state_array(state.vectors[i], begin, end);
+
+        if (state.vectors[i].size() != description[2])
+            throw cusp::io_exception("invalid solver state: vector size does not match the system");
+    }
+
+    state.method          = description[1];
+    state.num_rows        = description[2];
+    state.iteration_count = description[3];
+}
+
+} // end namespace krylov
+} // end namespace cusp
+
@@ -0,0 +1,205 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file solver_state.h
+ *  \brief Checkpoint and restart of iterative solvers
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/array1d.h>
+
+#include <string>
+#include <vector>
+
+namespace cusp
+{
+namespace krylov
+{
+
+/*! \addtogroup iterative_solvers Iterative Solvers
+ *  \addtogroup krylov_methods Krylov Methods
+ *  \ingroup iterative_solvers
+ *  \{
+ */
+
+/*! \p solver_state : State of an interrupted Krylov solve
+ *
+ * A \p solver_state passed to \p cg, \p bicgstab or \p gmres holds the
+ * vectors and scalars the method carries from one iteration to the next,
+ * together with the number of iterations performed.  When the solver
+ * returns (e.g. because the monitor reached its iteration limit) the
+ * state and the iterate \c x can be saved with \p write_solver_state.
+ * Passing the state read back with \p read_solver_state to the same
+ * method continues the solve from the iteration at which it stopped, as
+ * if it had never been interrupted.
+ *
+ * The monitor given to the resumed solve is advanced to the iteration
+ * count of the state, so its iteration limit applies to the whole solve.
+ *
+ * \p cg and \p bicgstab resume exactly.  \p gmres resumes at the start of
+ * a restart cycle: when it is interrupted in the middle of a cycle, the
+ * partial Krylov subspace is folded into \c x as at every restart.
+ *
+ * \tparam ValueType scalar type used in the solver (e.g. \c float or \c cusp::complex<double>)
+ * \tparam MemorySpace memory space of the solver vectors
+ *
+ *  The following code snippet demonstrates how to checkpoint a long
+ *  \p cg solve every 1000 iterations and to resume it after the program
+ *  was stopped.
+ *
+ *  \code
+ *  #include <cusp/csr_matrix.h>
+ *  #include <cusp/monitor.h>
+ *  #include <cusp/krylov/cg.h>
+ *  #include <cusp/krylov/solver_state.h>
+ *  #include <cusp/gallery/poisson.h>
+ *  #include <fstream>
+ *
+ *  int main(void)
+ *  {
+ *      cusp::csr_matrix<int, float, cusp::device_memory> A;
+ *      cusp::gallery::poisson5pt(A, 1000, 1000);
+ *
+ *      cusp::array1d<float, cusp::device_memory> x(A.num_rows, 0);
+ *      cusp::array1d<float, cusp::device_memory> b(A.num_rows, 1);
+ *
+ *      cusp::identity_operator<float, cusp::device_memory> M(A.num_rows, A.num_rows);
+ *
+ *      cusp::krylov::solver_state<float, cusp::device_memory> state;
+ *
+ *      // continue from the last checkpoint, if any
+ *      if (std::ifstream("cg.state"))
+ *          cusp::krylov::read_solver_state(x, state, "cg.state");
+ *
+ *      while (true)
+ *      {
+ *          // run (at most) 1000 more iterations
+ *          cusp::default_monitor<float> monitor(b, state.iteration_count + 1000, 1e-6);
+ *
+ *          cusp::krylov::cg(A, x, b, monitor, M, state);
+ *
+ *          if (monitor.converged())
+ *              break;
+ *
+ *          cusp::krylov::write_solver_state(x, state, "cg.state");
+ *      }
+ *
+ *      return 0;
+ *  }
+ *  \endcode
+ *
+ *  \see \p write_solver_state
+ *  \see \p read_solver_state
+ */
+template <typename ValueType, typename MemorySpace>
+class solver_state
+{
+    public:
+    typedef ValueType   value_type;
+    typedef MemorySpace memory_space;
+    typedef cusp::array1d<ValueType,MemorySpace> vector_type;
+
+    /*! Construct an empty state, which starts a new solve
+     */
+    solver_state(void) : method(0), num_rows(0), iteration_count(0) {}
+
+    /*! whether the state holds a solve in progress
+     */
+    bool empty(void) const { return method == 0; }
+
+    /*! discard the solve in progress
+     */
+    void clear(void)
+    {
+        method          = 0;
+        num_rows        = 0;
+        iteration_count = 0;
+        vectors.clear();
+        scalars.clear();
+    }
+
+    /*! identifies the method that produced the state (0 if empty)
+     */
+    size_t method;
+
+    /*! size of the linear system
+     */
+    size_t num_rows;
+
+    /*! number of iterations performed
+     */
+    size_t iteration_count;
+
+    /*! vectors carried between iterations (e.g. residual and search direction)
+     */
+    std::vector<vector_type> vectors;
+
+    /*! scalars carried between iterations
+     */
+    cusp::array1d<ValueType,cusp::host_memory> scalars;
+};
+
+/*! \p write_solver_state : Save the iterate and the state of a solver
+ *
+ * The iterate, the state vectors and the scalars are stored in the cusp
+ * binary format (see \p write_binary_file).  The file is written under a
+ * temporary name and renamed when complete, so a job that is stopped
+ * while writing leaves the previous checkpoint intact.
+ *
+ * \param x current approximate solution of the linear system
+ * \param state state of the solver
+ * \param filename file name of the checkpoint
+ * \tparam Vector vector
+ * \tparam SolverState \p solver_state
+ *
+ * \note if the file already exists it will be overwritten
+ *
+ * \see \p read_solver_state
+ * \see \p solver_state
+ */
+template <typename Vector, typename SolverState>
+void write_solver_state(const Vector& x, const SolverState& state, const std::string& filename);
+
+/*! \p read_solver_state : Load the iterate and the state of a solver
+ *
+ * \param x approximate solution of the linear system
+ * \param state state of the solver
+ * \param filename file name of the checkpoint written by \p write_solver_state
+ * \tparam Vector vector
+ * \tparam SolverState \p solver_state
+ *
+ * \throws cusp::io_exception if the file is damaged or its value type does
+ * not match \p x and \p state
+ *
+ * \note any contents of \p x and \p state will be overwritten
+ *
+ * \see \p write_solver_state
+ * \see \p solver_state
+ */
+template <typename Vector, typename SolverState>
+void read_solver_state(Vector& x, SolverState& state, const std::string& filename);
+
+/*! \}
+ */
+
+} // end namespace krylov
+} // end namespace cusp
+
+#include <cusp/krylov/detail/solver_state.inl>
+
@@ -82,6 +82,247 @@ template <typename LinearOperator,
 void multiply(LinearOperator&  A,
               MatrixOrVector1& B,
               MatrixOrVector2& C);
+
+/*! \p multiply_symbolic : Computes the sparsity structure of a sparse
+ *  matrix-matrix product
+ *
+ * \p multiply_symbolic sets the row and column indices of \p C to the
+ * structure of <tt>A * B</tt> and fills its values with zeros.  Every
+ * product term is kept in the structure, even if its value sums to zero,
+ * and column indices are sorted within each row.  The structure can then be
+ * reused by \p multiply_numeric for any matrices with the same sparsity as
+ * \p A and \p B.
+ *
+ * \param A input matrix
+ * \param B input matrix
+ * \param C output matrix
+ *
+ * \tparam Matrix1 sparse matrix (\p coo_matrix or \p csr_matrix)
+ * \tparam Matrix2 sparse matrix of the same format as \p Matrix1
+ * \tparam Matrix3 sparse matrix of the same format as \p Matrix1
+ */
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3>
+void multiply_symbolic(const Matrix1& A,
+                       const Matrix2& B,
+                             Matrix3& C);
+
+/*! \p multiply_numeric : Recomputes the values of a sparse matrix-matrix
+ *  product with a known structure
+ *
+ * \p multiply_numeric overwrites <tt>C.values</tt> with the values of
+ * <tt>A * B</tt>, where \p C holds a structure computed by
+ * \p multiply_symbolic.  The indices of \p C are not modified, so this is
+ * considerably cheaper than \p multiply when the values of \p A and
+ * \p B change but their sparsity does not.
+ *
+ * \param A input matrix
+ * \param B input matrix
+ * \param C matrix whose values are recomputed
+ *
+ * \tparam Matrix1 sparse matrix (\p coo_matrix or \p csr_matrix)
+ * \tparam Matrix2 sparse matrix of the same format as \p Matrix1
+ * \tparam Matrix3 sparse matrix of the same format as \p Matrix1
+ *
+ * \throws cusp::invalid_input_exception if a nonzero of <tt>A * B</tt>
+ * falls outside the structure of \p C
+ *
+ *  The following code snippet demonstrates how to reuse the structure of a
+ *  product when the values of \p A change.
+ *
+ *  \code
+ *  #include <cusp/multiply.h>
+ *  #include <cusp/csr_matrix.h>
+ *  #include <cusp/gallery/poisson.h>
+ *  
+ *  int main(void)
+ *  {
+ *      cusp::csr_matrix<int, float, cusp::host_memory> A;
+ *      cusp::gallery::poisson5pt(A, 10, 10);
+ *  
+ *      // compute the structure of C = A * A once
+ *      cusp::csr_matrix<int, float, cusp::host_memory> C;
+ *      cusp::multiply_symbolic(A, A, C);
+ *  
+ *      for (int step = 0; step < 10; step++)
+ *      {
+ *          // values of A change, structure does not
+ *          A.values[0] = step;
+ *  
+ *          // refill C.values
+ *          cusp::multiply_numeric(A, A, C);
+ *      }
+ *  
+ *      return 0;
+ *  }
+ *  \endcode
+ */
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3>
+void multiply_numeric(const Matrix1& A,
+                      const Matrix2& B,
+                            Matrix3& C);
+
+/*! \p multiply_masked : Computes the entries of a sparse matrix-matrix
+ *  product that lie within a sparsity mask
+ *
+ * \p multiply_masked computes <tt>C = (A * B) .* M</tt>, where only the
+ * sparsity pattern of \p M is used: <tt>C(i,j)</tt> is <tt>(A * B)(i,j)</tt>
+ * if \p M has an entry at <tt>(i,j)</tt> and zero otherwise.  The values of
+ * \p M are ignored.  Product terms outside the mask are discarded as they
+ * are generated, so the full product is never formed.  Entries of \p C
+ * that evaluate to zero are not stored.
+ *
+ * \param A input matrix
+ * \param B input matrix
+ * \param M mask matrix with the shape of <tt>A * B</tt>
+ * \param C output matrix
+ *
+ * \tparam Matrix1 sparse matrix
+ * \tparam Matrix2 sparse matrix
+ * \tparam Matrix3 sparse matrix
+ * \tparam Matrix4 sparse matrix
+ *
+ * \see cusp::graph::triangle_count
+ */
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3,
+          typename Matrix4>
+void multiply_masked(const Matrix1& A,
+                     const Matrix2& B,
+                     const Matrix3& M,
+                           Matrix4& C);
+
+/*! \p galerkin_product : Computes the triple product <tt>R * A * P</tt>
+ *
+ * \p galerkin_product computes the coarse operator <tt>RAP = R * A * P</tt>
+ * used by multigrid methods.  On the host each row of \p RAP is formed
+ * directly from the corresponding row of <tt>R * A</tt>, so neither
+ * <tt>R * A</tt> nor <tt>A * P</tt> is ever stored.
+ *
+ * \param R restriction operator
+ * \param A input matrix
+ * \param P prolongation operator
+ * \param RAP output matrix
+ *
+ * \tparam Matrix1 sparse matrix
+ * \tparam Matrix2 sparse matrix
+ * \tparam Matrix3 sparse matrix
+ * \tparam Matrix4 sparse matrix
+ *
+ *  \code
+ *  #include <cusp/multiply.h>
+ *  #include <cusp/transpose.h>
+ *  #include <cusp/csr_matrix.h>
+ *  #include <cusp/gallery/poisson.h>
+ *  
+ *  int main(void)
+ *  {
+ *      cusp::csr_matrix<int, float, cusp::host_memory> A;
+ *      cusp::gallery::poisson5pt(A, 10, 10);
+ *  
+ *      // prolongator that sums pairs of unknowns
+ *      cusp::csr_matrix<int, float, cusp::host_memory> P(100, 50, 100);
+ *      for (int i = 0; i < 100; i++)
+ *      {
+ *          P.row_offsets[i]    = i;
+ *          P.column_indices[i] = i / 2;
+ *          P.values[i]         = 1;
+ *      }
+ *      P.row_offsets[100] = 100;
+ *  
+ *      cusp::csr_matrix<int, float, cusp::host_memory> R;
+ *      cusp::transpose(P, R);
+ *  
+ *      // compute RAP = R * A * P
+ *      cusp::csr_matrix<int, float, cusp::host_memory> RAP;
+ *      cusp::galerkin_product(R, A, P, RAP);
+ *  
+ *      return 0;
+ *  }
+ *  \endcode
+ */
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3,
+          typename Matrix4>
+void galerkin_product(const Matrix1& R,
+                      const Matrix2& A,
+                      const Matrix3& P,
+                            Matrix4& RAP);
+
+/*! \p multiply_blocked : Computes a sparse matrix-matrix product one block
+ *  of rows at a time
+ *
+ * \p multiply_blocked computes <tt>C = A * B</tt> in blocks of consecutive
+ * rows and passes each block to \p f instead of storing all of \p C.
+ * Blocks are sized so that an upper bound on the storage of each block
+ * (its row offsets, column indices and values) does not exceed
+ * \p max_bytes, although a block always contains at least one row.
+ * Temporary storage during the computation of a block may be up to twice
+ * the size of the block.
+ *
+ * \p f is called as <tt>f(first_row, C_block)</tt>, where \p C_block is a
+ * host \p csr_matrix holding rows <tt>[first_row, first_row +
+ * C_block.num_rows)</tt> of \p C.  Blocks are delivered in order and
+ * \p C_block is only valid for the duration of the call.
+ *
+ * \param A input matrix
+ * \param B input matrix
+ * \param f function object called for each block of rows of \p C
+ * \param max_bytes storage budget for each block of \p C
+ *
+ * \tparam Matrix1 sparse matrix
+ * \tparam Matrix2 sparse matrix
+ * \tparam BlockFunction function object
+ *
+ *  The following code snippet demonstrates how to count the entries of a
+ *  product without storing it.
+ *
+ *  \code
+ *  #include <cusp/multiply.h>
+ *  #include <cusp/csr_matrix.h>
+ *  #include <cusp/gallery/poisson.h>
+ *  #include <iostream>
+ *  
+ *  struct count_entries
+ *  {
+ *      size_t& count;
+ *  
+ *      count_entries(size_t& count) : count(count) {}
+ *  
+ *      template <typename Matrix>
+ *      void operator()(size_t first_row, const Matrix& C_block)
+ *      {
+ *          count += C_block.num_entries;
+ *      }
+ *  };
+ *  
+ *  int main(void)
+ *  {
+ *      cusp::csr_matrix<int, float, cusp::host_memory> A;
+ *      cusp::gallery::poisson5pt(A, 100, 100);
+ *  
+ *      // compute A * A in blocks of at most 64KB
+ *      size_t count = 0;
+ *      cusp::multiply_blocked(A, A, count_entries(count), 1 << 16);
+ *  
+ *      std::cout << "nnz(A * A) = " << count << std::endl;
+ *  
+ *      return 0;
+ *  }
+ *  \endcode
+ */
+template <typename Matrix1,
+          typename Matrix2,
+          typename BlockFunction>
+void multiply_blocked(const Matrix1& A,
+                      const Matrix2& B,
+                            BlockFunction f,
+                      const size_t max_bytes);
 /*! \}
  */
 
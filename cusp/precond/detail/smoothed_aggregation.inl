@@ -15,6 +15,7 @@
  */
 
 #include <cusp/blas.h>
+#include <cusp/convert.h>
 #include <cusp/elementwise.h>
 #include <cusp/multiply.h>
 #include <cusp/monitor.h>
@@ -152,12 +153,6 @@ void fit_candidates(const Array1& aggregates,
     Q_ = Q;
 }
 
-template <typename Matrix>
-void setup_level_matrix(Matrix& dst, Matrix& src){dst.swap(src);}
-
-template <typename Matrix1, typename Matrix2>
-void setup_level_matrix(Matrix1& dst, Matrix2& src){dst = src;}
-
 } // end namespace detail
 
 
@@ -181,10 +176,9 @@ smoothed_aggregation<IndexType,ValueType,MemorySpace>::smoothed_aggregation(cons
   cusp::array2d<ValueType,cusp::host_memory> coarse_dense(levels.back().A_);
   LU = cusp::detail::lu_solver<ValueType, cusp::host_memory>(coarse_dense);
 
-  // Setup solve matrix for each level
-  levels[0].A = A;
-  for( size_t lvl = 1; lvl < levels.size(); lvl++ )
-    detail::setup_level_matrix( levels[lvl].A, levels[lvl].A_ );
+  // Setup solve matrix for each level, releasing the setup matrices
+  for( size_t lvl = 0; lvl < levels.size(); lvl++ )
+    cusp::convert_inplace( levels[lvl].A_, levels[lvl].A );
 }
 
 template <typename IndexType, typename ValueType, typename MemorySpace>
@@ -224,12 +218,7 @@ void smoothed_aggregation<IndexType,ValueType,MemorySpace>::extend_hierarchy(voi
 
   // construct Galerkin product R*A*P
   SetupMatrixType RAP;
-  {
-    // TODO test speed of R * (A * P) vs. (R * A) * P
-    SetupMatrixType AP;
-    cusp::multiply(levels.back().A_, P, AP);
-    cusp::multiply(R, AP, RAP);
-  }
+  cusp::galerkin_product(R, levels.back().A_, P, RAP);
 
   #ifndef USE_POLY_SMOOTHER
   //  4/3 * 1/rho is a good default, where rho is the spectral radius of D^-1(A)
@@ -243,8 +232,8 @@ void smoothed_aggregation<IndexType,ValueType,MemorySpace>::extend_hierarchy(voi
   #endif
 
   levels.back().aggregates.swap(aggregates);
-  detail::setup_level_matrix( levels.back().R, R );
-  detail::setup_level_matrix( levels.back().P, P );
+  cusp::convert_inplace( R, levels.back().R );
+  cusp::convert_inplace( P, levels.back().P );
   levels.back().residual.resize(levels.back().A_.num_rows);
 
   //std::cout << "omega " << omega << std::endl;
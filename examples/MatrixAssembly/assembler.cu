@@ -0,0 +1,41 @@
+#include <cusp/assembler.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/print.h>
+
+// Assemble a sparse matrix from (i,j,v) triplets produced by several
+// threads at once, where duplicate entries are summed together.
+//
+// This example assembles the 1D finite element Laplacian: every element
+// contributes a 2x2 block to the matrix and neighbouring elements overlap
+// on the diagonal.  When compiled with OpenMP (hostomp=1) the elements are
+// processed in parallel, each thread appending to its own buffer.
+
+int main(void)
+{
+    // number of elements and dimensions of the matrix
+    int num_elements = 8;
+    int num_rows     = num_elements + 1;
+    int num_cols     = num_elements + 1;
+
+    // one triplet buffer per thread
+    cusp::assembler<int, float> assembler(num_rows, num_cols);
+
+    #pragma omp parallel for
+    for (int e = 0; e < num_elements; e++)
+    {
+        assembler.insert(e,     e,      1.0f);
+        assembler.insert(e,     e + 1, -1.0f);
+        assembler.insert(e + 1, e,     -1.0f);
+        assembler.insert(e + 1, e + 1,  1.0f);
+    }
+
+    // sum duplicate triplets into a CSR matrix in device memory
+    cusp::csr_matrix<int, float, cusp::device_memory> A;
+    assembler.finalize(A);
+
+    // print matrix
+    cusp::print(A);
+
+    return 0;
+}
+
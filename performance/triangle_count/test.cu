@@ -0,0 +1,111 @@
+#include <cusp/gallery/poisson.h>
+#include <cusp/io/matrix_market.h>
+#include <cusp/graph/triangle_count.h>
+#include <cusp/multiply.h>
+
+#include <cusp/coo_matrix.h>
+#include <cusp/csr_matrix.h>
+
+#include <iostream>
+#include <stdio.h>
+
+#include "../timer.h"
+
+template <typename MatrixType>
+float time_triangle_count(const MatrixType& A, size_t& num_triangles)
+{
+    unsigned int N = 10;
+
+    timer t;
+
+    for(unsigned int i = 0; i < N; i++)
+        num_triangles = cusp::graph::triangle_count(A);
+
+    return t.milliseconds_elapsed() / N;
+}
+
+// reference: form the full product L * L, then filter it with L
+template <typename MatrixType>
+float time_unmasked(const MatrixType& A, size_t& num_triangles)
+{
+    typedef typename MatrixType::index_type IndexType;
+    typedef cusp::csr_matrix<IndexType,IndexType,cusp::host_memory> PatternMatrix;
+
+    unsigned int N = 10;
+
+    timer t;
+
+    for(unsigned int i = 0; i < N; i++)
+    {
+        // strictly lower triangular part of A
+        cusp::coo_matrix<IndexType,IndexType,cusp::host_memory> A_coo(A);
+        size_t num_entries = 0;
+        for(size_t n = 0; n < A_coo.num_entries; n++)
+        {
+            if (A_coo.column_indices[n] < A_coo.row_indices[n])
+            {
+                A_coo.row_indices[num_entries]    = A_coo.row_indices[n];
+                A_coo.column_indices[num_entries] = A_coo.column_indices[n];
+                A_coo.values[num_entries]         = 1;
+                num_entries++;
+            }
+        }
+        A_coo.resize(A.num_rows, A.num_cols, num_entries);
+
+        PatternMatrix L(A_coo);
+        PatternMatrix LL;
+        cusp::multiply(L, L, LL);
+
+        // sum the entries of L * L that lie in L
+        cusp::array1d<char,cusp::host_memory> mask(A.num_cols, 0);
+        num_triangles = 0;
+
+        for(size_t r = 0; r < L.num_rows; r++)
+        {
+            for(IndexType jj = L.row_offsets[r]; jj < L.row_offsets[r + 1]; jj++)
+                mask[L.column_indices[jj]] = 1;
+
+            for(IndexType jj = LL.row_offsets[r]; jj < LL.row_offsets[r + 1]; jj++)
+                if (mask[LL.column_indices[jj]])
+                    num_triangles += LL.values[jj];
+
+            for(IndexType jj = L.row_offsets[r]; jj < L.row_offsets[r + 1]; jj++)
+                mask[L.column_indices[jj]] = 0;
+        }
+    }
+
+    return t.milliseconds_elapsed() / N;
+}
+
+int main(int argc, char ** argv)
+{
+    typedef int    IndexType;
+    typedef float  ValueType;
+
+    cusp::csr_matrix<IndexType, ValueType, cusp::host_memory> A;
+
+    if (argc == 1)
+    {
+        // no input file was specified, generate an example
+        cusp::gallery::poisson27pt(A, 50, 50, 50);
+    }
+    else
+    {
+        // input file was specified, read it from disk
+        cusp::io::read_matrix_market_file(A, argv[1]);
+    }
+
+    std::cout << "Input matrix A has shape (" << A.num_rows << "," << A.num_cols << ") and " << A.num_entries << " entries" << "\n\n";
+
+    size_t masked = 0, unmasked = 0;
+
+    printf("Host Triangle Count (milliseconds per count)\n");
+    printf("  masked   | %9.2f\n", time_triangle_count(A, masked));
+    printf("  unmasked | %9.2f\n", time_unmasked(A, unmasked));
+    printf("\n%lu triangles\n", (unsigned long) masked);
+
+    if (masked != unmasked)
+        printf("error: unmasked count is %lu\n", (unsigned long) unmasked);
+
+    return 0;
+}
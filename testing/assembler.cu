@@ -0,0 +1,232 @@
+#include <unittest/unittest.h>
+
+#include <cusp/assembler.h>
+#include <cusp/coo_matrix.h>
+#include <cusp/csr_matrix.h>
+
+#include <thrust/reduce.h>
+
+#include <algorithm>
+
+template <class Matrix>
+void TestAssembler(void)
+{
+    typedef typename Matrix::index_type IndexType;
+    typedef typename Matrix::value_type ValueType;
+
+    // triplets of examples/MatrixAssembly/unordered_triplets.cu spread over three buffers
+    cusp::assembler<IndexType,ValueType> assembler(3, 3, 3);
+
+    assembler.insert(2, 0, 10, 0);
+    assembler.insert(0, 2, 10, 1);
+    assembler.insert(1, 1, 10, 2);
+    assembler.insert(2, 0, 10, 0);
+    assembler.insert(1, 1, 10, 1);
+    assembler.insert(0, 0, 10, 2);
+    assembler.insert(2, 2, 10, 0);
+    assembler.insert(0, 0, 10, 1);
+    assembler.insert(1, 0, 10, 2);
+    assembler.insert(0, 0, 10, 0);
+
+    ASSERT_EQUAL(assembler.num_buffers(), 3);
+    ASSERT_EQUAL(assembler.num_triplets(), 10);
+
+    Matrix M;
+    assembler.finalize(M);
+
+    ASSERT_EQUAL(assembler.num_triplets(), 0);
+
+    cusp::coo_matrix<IndexType,ValueType,cusp::host_memory> A(M);
+
+    ASSERT_EQUAL(A.num_rows,    3);
+    ASSERT_EQUAL(A.num_cols,    3);
+    ASSERT_EQUAL(A.num_entries, 6);
+
+    ASSERT_EQUAL(A.row_indices[0], 0);  ASSERT_EQUAL(A.column_indices[0], 0);  ASSERT_EQUAL(A.values[0], 30);
+    ASSERT_EQUAL(A.row_indices[1], 0);  ASSERT_EQUAL(A.column_indices[1], 2);  ASSERT_EQUAL(A.values[1], 10);
+    ASSERT_EQUAL(A.row_indices[2], 1);  ASSERT_EQUAL(A.column_indices[2], 0);  ASSERT_EQUAL(A.values[2], 10);
+    ASSERT_EQUAL(A.row_indices[3], 1);  ASSERT_EQUAL(A.column_indices[3], 1);  ASSERT_EQUAL(A.values[3], 20);
+    ASSERT_EQUAL(A.row_indices[4], 2);  ASSERT_EQUAL(A.column_indices[4], 0);  ASSERT_EQUAL(A.values[4], 20);
+    ASSERT_EQUAL(A.row_indices[5], 2);  ASSERT_EQUAL(A.column_indices[5], 2);  ASSERT_EQUAL(A.values[5], 10);
+}
+DECLARE_SPARSE_MATRIX_UNITTEST(TestAssembler);
+
+void TestAssemblerBuffers(void)
+{
+    const size_t N = 10000;
+
+    cusp::array1d<int,cusp::host_memory> I = unittest::random_integers<unsigned short>(N);
+    cusp::array1d<int,cusp::host_memory> J = unittest::random_integers<unsigned short>(N);
+
+    cusp::assembler<int,float> serial(100, 1000, 1);
+    cusp::assembler<int,float> parallel(100, 1000, 7);
+
+    for (size_t n = 0; n < N; n++)
+    {
+        serial.insert(I[n] % 100, J[n] % 1000, 1);
+        parallel.insert(I[n] % 100, J[n] % 1000, 1, n % 7);
+    }
+
+    cusp::csr_matrix<int,float,cusp::host_memory> A;
+    cusp::csr_matrix<int,float,cusp::host_memory> B;
+
+    serial.finalize(A);
+    parallel.finalize(B);
+
+    ASSERT_EQUAL(A.row_offsets,    B.row_offsets);
+    ASSERT_EQUAL(A.column_indices, B.column_indices);
+    ASSERT_EQUAL(A.values,         B.values);
+
+    // columns are sorted and unique within each row
+    for (size_t i = 0; i < A.num_rows; i++)
+        for (int jj = A.row_offsets[i] + 1; jj < A.row_offsets[i + 1]; jj++)
+            ASSERT_EQUAL(A.column_indices[jj - 1] < A.column_indices[jj], true);
+
+    // duplicates are summed
+    ASSERT_EQUAL(thrust::reduce(A.values.begin(), A.values.end()), float(N));
+}
+DECLARE_UNITTEST(TestAssemblerBuffers);
+
+void TestAssemblerReuse(void)
+{
+    cusp::assembler<int,float> assembler(2, 2, 2);
+
+    assembler.insert(0, 1, 1, 0);
+    assembler.insert(1, 0, 2, 1);
+    assembler.clear();
+
+    ASSERT_EQUAL(assembler.num_triplets(), 0);
+
+    assembler.insert(1, 1, 3, 1);
+
+    cusp::csr_matrix<int,float,cusp::host_memory> A;
+    assembler.finalize(A);
+
+    ASSERT_EQUAL(A.num_entries, 1);
+    ASSERT_EQUAL(A.row_offsets[0], 0);
+    ASSERT_EQUAL(A.row_offsets[1], 0);
+    ASSERT_EQUAL(A.row_offsets[2], 1);
+    ASSERT_EQUAL(A.column_indices[0], 1);
+    ASSERT_EQUAL(A.values[0], 3);
+
+    // an assembler may be reused after finalize
+    assembler.insert(0, 0, 4, 0);
+    assembler.finalize(A);
+
+    ASSERT_EQUAL(A.num_entries, 1);
+    ASSERT_EQUAL(A.row_offsets[1], 1);
+    ASSERT_EQUAL(A.values[0], 4);
+}
+DECLARE_UNITTEST(TestAssemblerReuse);
+
+void TestAssemblerInvalidIndex(void)
+{
+    cusp::assembler<int,float> assembler(3, 3, 2);
+
+    assembler.insert(0, 0, 1, 0);
+    assembler.insert(1, 3, 1, 1);
+
+    cusp::csr_matrix<int,float,cusp::host_memory> A;
+
+    ASSERT_THROWS(assembler.finalize(A), cusp::invalid_input_exception);
+}
+DECLARE_UNITTEST(TestAssemblerInvalidIndex);
+
+void TestAssemblerInvalidBuffer(void)
+{
+    cusp::assembler<int,float> assembler(3, 3, 2);
+
+    ASSERT_THROWS(assembler.insert(0, 0, 1, 2), cusp::invalid_input_exception);
+
+    // more threads than buffers
+    int threads  = 1;
+    int failures = 0;
+
+    #pragma omp parallel num_threads(4) reduction(+ : failures)
+    {
+        if (cusp::detail::host::thread_num() == 0)
+            threads = cusp::detail::host::team_size();
+
+        try
+        {
+            assembler.insert(0, 0, 1);
+        }
+        catch (cusp::invalid_input_exception&)
+        {
+            failures++;
+        }
+    }
+
+    ASSERT_EQUAL(failures, std::max(threads - 2, 0));
+
+    // the rejected triplets are not inserted
+    cusp::csr_matrix<int,float,cusp::host_memory> A;
+    assembler.finalize(A);
+
+    ASSERT_EQUAL(A.num_entries, 1);
+    ASSERT_EQUAL(A.values[0], float(threads - failures));
+}
+DECLARE_UNITTEST(TestAssemblerInvalidBuffer);
+
+template <class MemorySpace>
+void TestAssemblyMap(void)
+{
+    // pattern of two overlapping 2x2 elements and an entry without triplets
+    cusp::csr_matrix<int,float,cusp::host_memory> A(3, 3, 8);
+
+    A.row_offsets[0] = 0;  A.row_offsets[1] = 2;  A.row_offsets[2] = 5;  A.row_offsets[3] = 8;
+
+    A.column_indices[0] = 0;  A.column_indices[1] = 1;
+    A.column_indices[2] = 0;  A.column_indices[3] = 1;  A.column_indices[4] = 2;
+    A.column_indices[5] = 0;  A.column_indices[6] = 1;  A.column_indices[7] = 2;
+
+    cusp::array1d<int,cusp::host_memory> I(8);
+    cusp::array1d<int,cusp::host_memory> J(8);
+
+    I[0] = 0;  J[0] = 0;
+    I[1] = 0;  J[1] = 1;
+    I[2] = 1;  J[2] = 0;
+    I[3] = 1;  J[3] = 1;
+    I[4] = 1;  J[4] = 1;
+    I[5] = 1;  J[5] = 2;
+    I[6] = 2;  J[6] = 1;
+    I[7] = 2;  J[7] = 2;
+
+    cusp::csr_matrix<int,float,MemorySpace> M(A);
+
+    cusp::assembly_map<int> map(M, cusp::array1d<int,MemorySpace>(I), cusp::array1d<int,MemorySpace>(J));
+
+    ASSERT_EQUAL(map.num_entries(),  8);
+    ASSERT_EQUAL(map.num_triplets(), 8);
+
+    for (int step = 1; step <= 2; step++)
+    {
+        cusp::array1d<float,MemorySpace> V(8);
+        for (int n = 0; n < 8; n++)
+            V[n] = step * (n + 1);
+
+        cusp::refresh_values(M, map, V);
+
+        cusp::array1d<float,cusp::host_memory> values(M.values);
+
+        ASSERT_EQUAL(values[0], step *  1);
+        ASSERT_EQUAL(values[1], step *  2);
+        ASSERT_EQUAL(values[2], step *  3);
+        ASSERT_EQUAL(values[3], step *  9);
+        ASSERT_EQUAL(values[4], step *  6);
+        ASSERT_EQUAL(values[5], 0);
+        ASSERT_EQUAL(values[6], step *  7);
+        ASSERT_EQUAL(values[7], step *  8);
+    }
+
+    // the number of values must match the map
+    cusp::array1d<float,MemorySpace> W(7);
+    ASSERT_THROWS(cusp::refresh_values(M, map, W), cusp::invalid_input_exception);
+
+    // every triplet must be an entry of the matrix
+    typedef cusp::assembly_map<int> Map;
+    I[0] = 0;  J[0] = 2;
+    ASSERT_THROWS(Map invalid(M, I, J), cusp::invalid_input_exception);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestAssemblyMap);
+
@@ -4,6 +4,7 @@
 #include <cusp/csr_matrix.h>
 #include <cusp/multiply.h>
 #include <cusp/krylov/bicgstab.h>
+#include <cusp/krylov/solver_state.h>
 
 template <class MemorySpace>
 void TestBiConjugateGradientStabilized(void)
@@ -58,3 +59,39 @@ void TestBiConjugateGradientStabilizedZeroResidual(void)
 }
 DECLARE_HOST_DEVICE_UNITTEST(TestBiConjugateGradientStabilizedZeroResidual);
 
+
+template <class MemorySpace>
+void TestBiConjugateGradientStabilizedResume(void)
+{
+    cusp::csr_matrix<int, float, MemorySpace> A;
+
+    cusp::gallery::poisson5pt(A, 10, 10);
+
+    cusp::array1d<float, MemorySpace> b(A.num_rows, 1.0f);
+
+    cusp::identity_operator<float, MemorySpace> M(A.num_rows, A.num_rows);
+
+    // uninterrupted solve
+    cusp::array1d<float, MemorySpace> x(A.num_rows, 0.0f);
+    {
+        cusp::default_monitor<float> monitor(b, 8, 0.0f);
+        cusp::krylov::bicgstab(A, x, b, monitor, M);
+    }
+
+    // solve interrupted after 3 iterations and resumed
+    cusp::array1d<float, MemorySpace> y(A.num_rows, 0.0f);
+    cusp::krylov::solver_state<float, MemorySpace> state;
+    {
+        cusp::default_monitor<float> monitor(b, 3, 0.0f);
+        cusp::krylov::bicgstab(A, y, b, monitor, M, state);
+    }
+    {
+        cusp::default_monitor<float> monitor(b, 8, 0.0f);
+        cusp::krylov::bicgstab(A, y, b, monitor, M, state);
+
+        ASSERT_EQUAL(monitor.iteration_count(), 8);
+    }
+
+    ASSERT_EQUAL(y, x);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestBiConjugateGradientStabilizedResume);
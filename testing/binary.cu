@@ -0,0 +1,206 @@
+#include <unittest/unittest.h>
+
+#include <cusp/io/binary.h>
+
+#include <cusp/array1d.h>
+#include <cusp/array2d.h>
+#include <cusp/coo_matrix.h>
+#include <cusp/csr_matrix.h>
+
+#include <stdio.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+const char random_binary_file_name[] = "test_52814409317305.bin";
+
+template <typename ValueType>
+void InitializeBinaryExample(cusp::array2d<ValueType,cusp::host_memory>& A)
+{
+  A.resize(4, 3);
+  A(0,0) = 10;  A(0,1) =  0;  A(0,2) = 20;
+  A(1,0) =  0;  A(1,1) =  0;  A(1,2) =  0;
+  A(2,0) =  0;  A(2,1) =  0;  A(2,2) = 30;
+  A(3,0) = 40;  A(3,1) = 50;  A(3,2) = 60;
+}
+
+template <class Matrix>
+void TestReadWriteBinaryFile(void)
+{
+  typedef typename Matrix::index_type IndexType;
+  typedef typename Matrix::value_type ValueType;
+
+  cusp::array2d<ValueType,cusp::host_memory> D;
+  InitializeBinaryExample(D);
+
+  Matrix A(D);
+
+  cusp::io::write_binary_file(A, random_binary_file_name);
+
+  // same format
+  Matrix B;
+  cusp::io::read_binary_file(B, random_binary_file_name);
+
+  // another format
+  cusp::csr_matrix<IndexType,ValueType,cusp::host_memory> C;
+  cusp::io::read_binary_file(C, random_binary_file_name);
+
+  remove(random_binary_file_name);
+
+  ASSERT_EQUAL(B.num_rows,    A.num_rows);
+  ASSERT_EQUAL(B.num_cols,    A.num_cols);
+  ASSERT_EQUAL(B.num_entries, A.num_entries);
+  ASSERT_EQUAL(cusp::array2d<ValueType,cusp::host_memory>(B) == D, true);
+  ASSERT_EQUAL(cusp::array2d<ValueType,cusp::host_memory>(C) == D, true);
+}
+DECLARE_SPARSE_MATRIX_UNITTEST(TestReadWriteBinaryFile);
+
+template <class MemorySpace>
+void TestReadWriteBinaryStreamArrays(void)
+{
+  cusp::array1d<double, MemorySpace> a(5);
+  a[0] = 10;  a[1] = -1.5;  a[2] = 20;  a[3] = 0;  a[4] = 1e-300;
+
+  cusp::array2d<cusp::complex<float>, MemorySpace, cusp::column_major> M(3, 2);
+  M(0,0) = cusp::complex<float>(1, 2);  M(0,1) = cusp::complex<float>(3, 4);
+  M(1,0) = cusp::complex<float>(5, 6);  M(1,1) = cusp::complex<float>(7, 8);
+  M(2,0) = cusp::complex<float>(9, 0);  M(2,1) = cusp::complex<float>(1, 1);
+
+  std::stringstream array1d_stream;
+  std::stringstream array2d_stream;
+
+  cusp::io::write_binary_stream(a, array1d_stream);
+  cusp::io::write_binary_stream(M, array2d_stream);
+
+  cusp::array1d<double, MemorySpace> b;
+  cusp::io::read_binary_stream(b, array1d_stream);
+
+  std::istringstream column_major_stream(array2d_stream.str());
+  cusp::array2d<cusp::complex<float>, MemorySpace, cusp::column_major> N;
+  cusp::io::read_binary_stream(N, column_major_stream);
+
+  // converted to another orientation
+  std::istringstream row_major_stream(array2d_stream.str());
+  cusp::array2d<cusp::complex<float>, cusp::host_memory, cusp::row_major> R;
+  cusp::io::read_binary_stream(R, row_major_stream);
+
+  ASSERT_EQUAL(a == b, true);
+  ASSERT_EQUAL(M.pitch, N.pitch);
+  ASSERT_EQUAL(M.values == N.values, true);
+  ASSERT_EQUAL(R(2,0), cusp::complex<float>(9, 0));
+  ASSERT_EQUAL(R(1,1), cusp::complex<float>(7, 8));
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestReadWriteBinaryStreamArrays);
+
+void TestBinaryFileView(void)
+{
+  typedef cusp::array1d_view<const int *>   IndexArray;
+  typedef cusp::array1d_view<const float *> ValueArray;
+
+  cusp::array2d<float,cusp::host_memory> D;
+  InitializeBinaryExample(D);
+
+  cusp::csr_matrix<int,float,cusp::host_memory> A(D);
+
+  cusp::io::write_binary_file(A, random_binary_file_name);
+
+  {
+    cusp::io::binary_file file(random_binary_file_name);
+
+    file.verify();
+
+    ASSERT_EQUAL(file.num_rows(),    4);
+    ASSERT_EQUAL(file.num_cols(),    3);
+    ASSERT_EQUAL(file.num_entries(), 6);
+
+    cusp::csr_matrix_view<IndexArray,IndexArray,ValueArray> V;
+    file.view(V);
+
+    ASSERT_EQUAL(V.num_rows,    4);
+    ASSERT_EQUAL(V.num_cols,    3);
+    ASSERT_EQUAL(V.num_entries, 6);
+    ASSERT_EQUAL(V.row_offsets    == A.row_offsets,    true);
+    ASSERT_EQUAL(V.column_indices == A.column_indices, true);
+    ASSERT_EQUAL(V.values         == A.values,         true);
+
+    // arrays are aligned within the mapping
+    ASSERT_EQUAL(size_t(&V.values[0]) % 64, 0);
+
+    // the view can be used like any other matrix
+    ASSERT_EQUAL(cusp::array2d<float,cusp::host_memory>(V) == D, true);
+
+    // the format and the types of the view must match the file
+    cusp::coo_matrix_view<IndexArray,IndexArray,ValueArray> W;
+    ASSERT_THROWS(file.view(W), cusp::io_exception);
+
+    cusp::array1d_view<const double *> X;
+    ASSERT_THROWS(file.view(X), cusp::io_exception);
+  }
+
+  cusp::array1d<float,cusp::host_memory> x(A.values);
+
+  cusp::io::write_binary_file(x, random_binary_file_name);
+
+  {
+    cusp::io::binary_file file(random_binary_file_name);
+
+    ValueArray v;
+    file.view(v);
+
+    ASSERT_EQUAL(v == x, true);
+  }
+
+  remove(random_binary_file_name);
+}
+DECLARE_UNITTEST(TestBinaryFileView);
+
+void TestBinaryFileInvalid(void)
+{
+  cusp::array1d<float,cusp::host_memory> a(100, 1.0f);
+
+  std::stringstream stream;
+  cusp::io::write_binary_stream(a, stream);
+
+  std::string contents = stream.str();
+
+  // damaged data is detected by the checksums
+  std::string damaged_data(contents);
+  damaged_data[damaged_data.size() - 200] ^= 1;
+
+  {
+    std::ofstream file(random_binary_file_name, std::ios::out | std::ios::binary);
+    file << damaged_data;
+  }
+
+  {
+    cusp::io::binary_file file(random_binary_file_name);
+    ASSERT_THROWS(file.verify(), cusp::io_exception);
+  }
+
+  cusp::array1d<float,cusp::host_memory> b;
+  ASSERT_THROWS(cusp::io::read_binary_file(b, random_binary_file_name), cusp::io_exception);
+
+  remove(random_binary_file_name);
+
+  // damaged header
+  std::string damaged_header(contents);
+  damaged_header[80] ^= 1;
+
+  std::istringstream header_stream(damaged_header);
+  ASSERT_THROWS(cusp::io::read_binary_stream(b, header_stream), cusp::io_exception);
+
+  // truncated file
+  std::istringstream truncated_stream(contents.substr(0, contents.size() - 100));
+  ASSERT_THROWS(cusp::io::read_binary_stream(b, truncated_stream), cusp::io_exception);
+
+  // not a binary file
+  std::istringstream text_stream("%%MatrixMarket matrix array real general\n1 1\n1\n");
+  ASSERT_THROWS(cusp::io::read_binary_stream(b, text_stream), cusp::io_exception);
+
+  // value type mismatch
+  cusp::array1d<double,cusp::host_memory> c;
+  std::istringstream double_stream(contents);
+  ASSERT_THROWS(cusp::io::read_binary_stream(c, double_stream), cusp::io_exception);
+}
+DECLARE_UNITTEST(TestBinaryFileInvalid);
+
@@ -1,6 +1,13 @@
 #include <unittest/unittest.h>
 
 #include <cusp/blas.h>
+#include <cusp/array2d.h>
+
+#include <cmath>
+
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
 
 
 template <class MemorySpace>
@@ -252,6 +259,101 @@ void TestDotc(void)
 }
 DECLARE_HOST_DEVICE_UNITTEST(TestDotc);
 
+template <class MemorySpace>
+void TestComplexDotc(void)
+{
+    typedef cusp::complex<float> ValueType;
+    typedef typename cusp::array1d<ValueType, MemorySpace> Array;
+
+    Array x(3);
+    Array y(3);
+
+    x[0] = ValueType( 1.0f,  2.0f);   y[0] = ValueType( 3.0f,  0.0f);
+    x[1] = ValueType( 0.0f, -1.0f);   y[1] = ValueType( 2.0f,  1.0f);
+    x[2] = ValueType(-2.0f,  0.0f);   y[2] = ValueType( 1.0f, -1.0f);
+
+    // conj(x) * y
+    ASSERT_EQUAL(cusp::blas::dotc(x, y), ValueType(0.0f, -2.0f));
+
+    // x * y
+    ASSERT_EQUAL(cusp::blas::dot(x, y), ValueType(2.0f, 6.0f));
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestComplexDotc);
+
+template <class MemorySpace>
+void TestMdotMaxpy(void)
+{
+    typedef typename cusp::array1d<float, MemorySpace>::view View;
+    typedef typename cusp::array2d_view<View, cusp::column_major> MatrixView;
+
+    cusp::array2d<float, MemorySpace, cusp::column_major> A(4, 3);
+
+    A(0,0) =  1.0f;   A(0,1) =  0.0f;   A(0,2) =  5.0f;
+    A(1,0) =  2.0f;   A(1,1) =  1.0f;   A(1,2) =  5.0f;
+    A(2,0) =  0.0f;   A(2,1) =  3.0f;   A(2,2) =  5.0f;
+    A(3,0) = -1.0f;   A(3,1) =  2.0f;   A(3,2) =  5.0f;
+
+    cusp::array1d<float, MemorySpace> x(4);
+    x[0] = 1.0f;  x[1] = -1.0f;  x[2] = 2.0f;  x[3] = 1.0f;
+
+    // all columns
+    cusp::array1d<float, cusp::host_memory> y(3);
+    cusp::blas::mdot(A, x, y);
+    ASSERT_EQUAL(y[0], -2.0f);
+    ASSERT_EQUAL(y[1],  7.0f);
+    ASSERT_EQUAL(y[2], 15.0f);
+
+    // leading columns only
+    MatrixView A2 = cusp::make_array2d_view(4, 2, A.pitch, cusp::make_array1d_view(A.values), cusp::column_major());
+
+    cusp::array1d<float, cusp::host_memory> z(2);
+    cusp::blas::mdotc(A2, x, z);
+    ASSERT_EQUAL(z[0], -2.0f);
+    ASSERT_EQUAL(z[1],  7.0f);
+
+    // x = 3 * A2 * [2 -1] + x
+    cusp::array1d<float, cusp::host_memory> c(2);
+    c[0] = 2.0f;  c[1] = -1.0f;
+    cusp::blas::maxpy(A2, c, x, 3.0f);
+    ASSERT_EQUAL(x[0],   7.0f);
+    ASSERT_EQUAL(x[1],   8.0f);
+    ASSERT_EQUAL(x[2],  -7.0f);
+    ASSERT_EQUAL(x[3], -11.0f);
+
+    // test size checking
+    ASSERT_THROWS(cusp::blas::mdot(A2, x, y),       cusp::invalid_input_exception);
+    ASSERT_THROWS(cusp::blas::maxpy(A, c, x, 1.0f), cusp::invalid_input_exception);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestMdotMaxpy);
+
+template <class MemorySpace>
+void TestComplexMdot(void)
+{
+    typedef cusp::complex<float> ValueType;
+
+    cusp::array2d<ValueType, MemorySpace, cusp::column_major> A(3, 2);
+
+    A(0,0) = ValueType( 1.0f,  2.0f);   A(0,1) = ValueType( 0.0f,  1.0f);
+    A(1,0) = ValueType( 0.0f, -1.0f);   A(1,1) = ValueType( 1.0f,  0.0f);
+    A(2,0) = ValueType(-2.0f,  0.0f);   A(2,1) = ValueType( 1.0f,  1.0f);
+
+    cusp::array1d<ValueType, MemorySpace> x(3);
+    x[0] = ValueType(3.0f, 0.0f);  x[1] = ValueType(2.0f, 1.0f);  x[2] = ValueType(1.0f, -1.0f);
+
+    cusp::array1d<ValueType, cusp::host_memory> y(2);
+
+    // conj(A)^T * x
+    cusp::blas::mdotc(A, x, y);
+    ASSERT_EQUAL(y[0], ValueType(0.0f, -2.0f));
+    ASSERT_EQUAL(y[1], ValueType(2.0f, -4.0f));
+
+    // A^T * x
+    cusp::blas::mdot(A, x, y);
+    ASSERT_EQUAL(y[0], ValueType(2.0f, 6.0f));
+    ASSERT_EQUAL(y[1], ValueType(4.0f, 4.0f));
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestComplexMdot);
+
 
 template <class MemorySpace>
 void TestFill(void)
@@ -449,3 +551,98 @@ void TestScal(void)
 }
 DECLARE_HOST_DEVICE_UNITTEST(TestScal);
 
+
+template <class MemorySpace>
+void TestBlasLargeArrays(void)
+{
+    // large enough to be divided among several threads on the host
+    const size_t N = 100003;
+
+    cusp::array1d<float, cusp::host_memory> x(N);
+    cusp::array1d<float, cusp::host_memory> y(N);
+
+    for (size_t i = 0; i < N; i++)
+    {
+        x[i] = float(i % 7) - 3.0f;
+        y[i] = float(i % 5);
+    }
+
+    // integer values are summed exactly in any order
+    float dot = 0, nrm = 0;
+    for (size_t i = 0; i < N; i++)
+    {
+        dot += x[i] * y[i];
+        nrm += x[i] * x[i];
+    }
+
+    cusp::array1d<float, cusp::host_memory> z(N);
+    for (size_t i = 0; i < N; i++)
+        z[i] = 2.0f * x[i] - y[i];
+
+    cusp::array1d<float, MemorySpace> X(x);
+    cusp::array1d<float, MemorySpace> Y(y);
+    cusp::array1d<float, MemorySpace> Z(N);
+
+    ASSERT_EQUAL(cusp::blas::dot(X, Y),  dot);
+    ASSERT_EQUAL(cusp::blas::dotc(X, Y), dot);
+    ASSERT_EQUAL(cusp::blas::nrm2(X),    std::sqrt(nrm));
+
+    cusp::blas::axpby(X, Y, Z, 2.0f, -1.0f);
+    ASSERT_EQUAL(Z, z);
+
+    cusp::blas::axpbypcz(X, Y, X, Z, 1.0f, -1.0f, 1.0f);
+    ASSERT_EQUAL(Z, z);
+
+    cusp::blas::scal(Z, 0.5f);
+    cusp::blas::axpy(Y, Z, 0.5f);
+    ASSERT_EQUAL(Z, x);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestBlasLargeArrays);
+
+#if defined(_OPENMP) && defined(CUSP_DETERMINISTIC_REDUCTIONS)
+void TestDeterministicReductions(void)
+{
+    // large enough that every thread count from 2 to 8 changes the
+    // partition, and not a multiple of the reduction block size
+    const size_t N = 8 * 32768 + 3;
+
+    cusp::array1d<float, cusp::host_memory> x(N);
+    cusp::array1d<float, cusp::host_memory> y(N);
+
+    // values whose sums are rounded
+    for (size_t i = 0; i < N; i++)
+    {
+        x[i] = 1.0f / float(i % 97 + 1);
+        y[i] = 0.1f * float(i % 13) - 0.6f;
+    }
+
+    cusp::array2d<float, cusp::host_memory, cusp::column_major> A(N, 2);
+    cusp::blas::copy(x, A.column(0));
+    cusp::blas::copy(y, A.column(1));
+
+    const int max_threads = omp_get_max_threads();
+
+    omp_set_num_threads(1);
+
+    const float dot = cusp::blas::dot(x, y);
+    const float nrm = cusp::blas::nrm2(x);
+
+    cusp::array1d<float, cusp::host_memory> m(2);
+    cusp::blas::mdot(A, y, m);
+
+    for (int threads = 2; threads <= 8; threads++)
+    {
+        omp_set_num_threads(threads);
+
+        ASSERT_EQUAL(cusp::blas::dot(x, y), dot);
+        ASSERT_EQUAL(cusp::blas::nrm2(x),   nrm);
+
+        cusp::array1d<float, cusp::host_memory> z(2);
+        cusp::blas::mdot(A, y, z);
+        ASSERT_EQUAL(z, m);
+    }
+
+    omp_set_num_threads(max_threads);
+}
+DECLARE_UNITTEST(TestDeterministicReductions);
+#endif
@@ -4,6 +4,12 @@
 #include <cusp/csr_matrix.h>
 #include <cusp/multiply.h>
 #include <cusp/krylov/cg.h>
+#include <cusp/krylov/bicgstab.h>
+#include <cusp/krylov/solver_state.h>
+
+#include <stdio.h>
+
+const char random_state_file_name[] = "test_71930284561023.state";
 
 template <class MemorySpace>
 void TestConjugateGradient(void)
@@ -58,3 +64,56 @@ void TestConjugateGradientZeroResidual(void)
 }
 DECLARE_HOST_DEVICE_UNITTEST(TestConjugateGradientZeroResidual);
 
+
+
+template <class MemorySpace>
+void TestConjugateGradientResume(void)
+{
+    cusp::csr_matrix<int, float, MemorySpace> A;
+
+    cusp::gallery::poisson5pt(A, 10, 10);
+
+    cusp::array1d<float, MemorySpace> b(A.num_rows, 1.0f);
+
+    cusp::identity_operator<float, MemorySpace> M(A.num_rows, A.num_rows);
+
+    // uninterrupted solve
+    cusp::array1d<float, MemorySpace> x(A.num_rows, 0.0f);
+    {
+        cusp::default_monitor<float> monitor(b, 12, 0.0f);
+        cusp::krylov::cg(A, x, b, monitor, M);
+    }
+
+    // solve interrupted after 5 iterations and resumed from a checkpoint
+    cusp::array1d<float, MemorySpace> y(A.num_rows, 0.0f);
+    {
+        cusp::krylov::solver_state<float, MemorySpace> state;
+        cusp::default_monitor<float> monitor(b, 5, 0.0f);
+        cusp::krylov::cg(A, y, b, monitor, M, state);
+
+        ASSERT_EQUAL(state.iteration_count, 5);
+
+        cusp::krylov::write_solver_state(y, state, random_state_file_name);
+    }
+    {
+        cusp::krylov::solver_state<float, MemorySpace> state;
+        cusp::array1d<float, MemorySpace> z;
+        cusp::krylov::read_solver_state(z, state, random_state_file_name);
+
+        ASSERT_EQUAL(z, y);
+        ASSERT_EQUAL(state.iteration_count, 5);
+
+        cusp::default_monitor<float> monitor(b, 12, 0.0f);
+        cusp::krylov::cg(A, z, b, monitor, M, state);
+
+        ASSERT_EQUAL(monitor.iteration_count(), 12);
+        ASSERT_EQUAL(z, x);
+
+        // the state of cg cannot resume another method
+        cusp::default_monitor<float> other(b, 20, 0.0f);
+        ASSERT_THROWS(cusp::krylov::bicgstab(A, z, b, other, M, state), cusp::invalid_input_exception);
+    }
+
+    remove(random_state_file_name);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestConjugateGradientResume);
@@ -11,6 +11,10 @@
 
 #include <cusp/verify.h>
 
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
 
 template <typename Matrix>
 void reset_view(Matrix& view, cusp::coo_format)
@@ -290,6 +294,36 @@ void TestConversionTo(void)
 }
 DECLARE_MATRIX_UNITTEST(TestConversionTo);
 
+template <class DestinationType, class SourceType>
+void TestConvertInplaceFromFormat(void)
+{
+    SourceType src;
+    initialize_conversion_example(src);
+
+    DestinationType dst;
+    cusp::convert_inplace(src, dst);
+
+    verify_conversion_example(dst);  cusp::assert_is_valid_matrix(dst);
+
+    // source is consumed
+    ASSERT_EQUAL(src.num_rows,      0);
+    ASSERT_EQUAL(src.num_cols,      0);
+    ASSERT_EQUAL(src.num_entries,   0);
+    ASSERT_EQUAL(src.values.size(), 0);
+}
+
+template <class Matrix>
+void TestConvertInplace(void)
+{
+    typedef typename Matrix::index_type   IndexType;
+    typedef typename Matrix::value_type   ValueType;
+    typedef typename Matrix::memory_space MemorySpace;
+
+    TestConvertInplaceFromFormat<Matrix, cusp::coo_matrix<IndexType, ValueType, MemorySpace> >();
+    TestConvertInplaceFromFormat<Matrix, cusp::csr_matrix<IndexType, ValueType, MemorySpace> >();
+}
+DECLARE_SPARSE_MATRIX_UNITTEST(TestConvertInplace);
+
 //////////////////////////////
 // Special Conversion Tests //
 //////////////////////////////
@@ -370,6 +404,54 @@ void TestConvertCsrToEllMatrixHost(void)
 }
 DECLARE_UNITTEST(TestConvertCsrToEllMatrixHost);
 
+void TestConvertCooToCsrHostCanonical(void)
+{
+    // unsorted entries with duplicates
+    cusp::coo_matrix<int, float, cusp::host_memory> coo(3, 4, 7);
+    coo.row_indices[0] = 2;  coo.column_indices[0] = 3;  coo.values[0] = 1.0;
+    coo.row_indices[1] = 0;  coo.column_indices[1] = 2;  coo.values[1] = 2.0;
+    coo.row_indices[2] = 2;  coo.column_indices[2] = 0;  coo.values[2] = 3.0;
+    coo.row_indices[3] = 0;  coo.column_indices[3] = 1;  coo.values[3] = 4.0;
+    coo.row_indices[4] = 2;  coo.column_indices[4] = 3;  coo.values[4] = 5.0;
+    coo.row_indices[5] = 0;  coo.column_indices[5] = 2;  coo.values[5] = 6.0;
+    coo.row_indices[6] = 2;  coo.column_indices[6] = 1;  coo.values[6] = 7.0;
+
+    cusp::csr_matrix<int, float, cusp::host_memory> csr;
+
+    // entries keep their order within each row
+    cusp::detail::host::coo_to_csr(coo, csr);
+
+    ASSERT_EQUAL(csr.num_entries, 7);
+    ASSERT_EQUAL(csr.row_offsets[0], 0);
+    ASSERT_EQUAL(csr.row_offsets[1], 3);
+    ASSERT_EQUAL(csr.row_offsets[2], 3);
+    ASSERT_EQUAL(csr.row_offsets[3], 7);
+    ASSERT_EQUAL(csr.column_indices[0], 2);  ASSERT_EQUAL(csr.values[0], 2.0);
+    ASSERT_EQUAL(csr.column_indices[1], 1);  ASSERT_EQUAL(csr.values[1], 4.0);
+    ASSERT_EQUAL(csr.column_indices[2], 2);  ASSERT_EQUAL(csr.values[2], 6.0);
+    ASSERT_EQUAL(csr.column_indices[3], 3);  ASSERT_EQUAL(csr.values[3], 1.0);
+    ASSERT_EQUAL(csr.column_indices[4], 0);  ASSERT_EQUAL(csr.values[4], 3.0);
+    ASSERT_EQUAL(csr.column_indices[5], 3);  ASSERT_EQUAL(csr.values[5], 5.0);
+    ASSERT_EQUAL(csr.column_indices[6], 1);  ASSERT_EQUAL(csr.values[6], 7.0);
+
+    // sorted columns with duplicates summed
+    cusp::detail::host::coo_to_csr(coo, csr, true, true);
+
+    ASSERT_EQUAL(csr.num_entries, 5);
+    ASSERT_EQUAL(csr.row_offsets[0], 0);
+    ASSERT_EQUAL(csr.row_offsets[1], 2);
+    ASSERT_EQUAL(csr.row_offsets[2], 2);
+    ASSERT_EQUAL(csr.row_offsets[3], 5);
+    ASSERT_EQUAL(csr.column_indices[0], 1);  ASSERT_EQUAL(csr.values[0],  4.0);
+    ASSERT_EQUAL(csr.column_indices[1], 2);  ASSERT_EQUAL(csr.values[1],  8.0);
+    ASSERT_EQUAL(csr.column_indices[2], 0);  ASSERT_EQUAL(csr.values[2],  3.0);
+    ASSERT_EQUAL(csr.column_indices[3], 1);  ASSERT_EQUAL(csr.values[3],  7.0);
+    ASSERT_EQUAL(csr.column_indices[4], 3);  ASSERT_EQUAL(csr.values[4],  6.0);
+
+    cusp::assert_is_valid_matrix(csr);
+}
+DECLARE_UNITTEST(TestConvertCooToCsrHostCanonical);
+
 template <class Matrix>
 void TestConversionFromArray1dTo(void)
 {
@@ -542,3 +624,95 @@ void TestConversionFromPitchedArray2dToArray1d(void)
 }
 DECLARE_HOST_DEVICE_UNITTEST(TestConversionFromPitchedArray2dToArray1d);
 
+
+// banded matrix with offsets [-lower, upper) whose occupied diagonals span
+// several words of the diagonal bitmap
+template <typename Matrix>
+void initialize_wide_band(Matrix& dense, const int N, const int lower, const int upper)
+{
+    dense.resize(N, N);
+
+    for(int i = 0; i < N; i++)
+        for(int j = 0; j < N; j++)
+            dense(i,j) = (j - i >= -lower && j - i < upper) ? float((i + 2 * j) % 11 + 1) : 0.0f;
+}
+
+template <typename IndexType, typename ValueType>
+void convert_wide_band(const cusp::csr_matrix<IndexType, ValueType, cusp::host_memory>& csr,
+                       cusp::dia_matrix<IndexType, ValueType, cusp::host_memory>& dia,
+                       cusp::ell_matrix<IndexType, ValueType, cusp::host_memory>& ell,
+                       cusp::hyb_matrix<IndexType, ValueType, cusp::host_memory>& hyb)
+{
+    cusp::detail::host::convert(csr, dia, cusp::csr_format(), cusp::dia_format());
+    cusp::detail::host::convert(csr, ell, cusp::csr_format(), cusp::ell_format());
+
+    // leaves the longest rows partly in the COO
+    cusp::detail::host::convert(csr, hyb, cusp::csr_format(), cusp::hyb_format(), 1.5, 0);
+}
+
+void TestConvertWideBandHost(void)
+{
+    const int N = 300;
+
+    cusp::array2d<float, cusp::host_memory> dense;
+    initialize_wide_band(dense, N, 100, 100);
+
+    cusp::csr_matrix<int, float, cusp::host_memory> csr(dense);
+
+    cusp::dia_matrix<int, float, cusp::host_memory> dia;
+    cusp::ell_matrix<int, float, cusp::host_memory> ell;
+    cusp::hyb_matrix<int, float, cusp::host_memory> hyb;
+
+    convert_wide_band(csr, dia, ell, hyb);
+
+    // 200 diagonals in order
+    ASSERT_EQUAL(dia.diagonal_offsets.size(), 200);
+    for(int d = 0; d < 200; d++)
+        ASSERT_EQUAL(dia.diagonal_offsets[d], d - 100);
+
+    ASSERT_EQUAL(ell.column_indices.num_cols, 200);
+    ASSERT_EQUAL(hyb.coo.num_entries > 0, true);
+    ASSERT_EQUAL(hyb.ell.num_entries + hyb.coo.num_entries, csr.num_entries);
+
+    cusp::assert_is_valid_matrix(dia);
+    cusp::assert_is_valid_matrix(ell);
+    cusp::assert_is_valid_matrix(hyb);
+
+    // compare with the dense matrix
+    {  cusp::array2d<float, cusp::host_memory> result(dia);  ASSERT_EQUAL(result.values, dense.values);  }
+    {  cusp::array2d<float, cusp::host_memory> result(ell);  ASSERT_EQUAL(result.values, dense.values);  }
+    {  cusp::array2d<float, cusp::host_memory> result(hyb);  ASSERT_EQUAL(result.values, dense.values);  }
+
+#if defined(_OPENMP)
+    // one thread and several threads give identical structures
+    const int max_threads = omp_get_max_threads();
+
+    omp_set_num_threads(1);
+
+    cusp::dia_matrix<int, float, cusp::host_memory> serial_dia;
+    cusp::ell_matrix<int, float, cusp::host_memory> serial_ell;
+    cusp::hyb_matrix<int, float, cusp::host_memory> serial_hyb;
+
+    convert_wide_band(csr, serial_dia, serial_ell, serial_hyb);
+
+    for(int threads = 2; threads <= 8; threads *= 2)
+    {
+        omp_set_num_threads(threads);
+
+        convert_wide_band(csr, dia, ell, hyb);
+
+        ASSERT_EQUAL(dia.diagonal_offsets,       serial_dia.diagonal_offsets);
+        ASSERT_EQUAL(dia.values.values,          serial_dia.values.values);
+        ASSERT_EQUAL(ell.column_indices.values,  serial_ell.column_indices.values);
+        ASSERT_EQUAL(ell.values.values,          serial_ell.values.values);
+        ASSERT_EQUAL(hyb.ell.column_indices.values, serial_hyb.ell.column_indices.values);
+        ASSERT_EQUAL(hyb.ell.values.values,         serial_hyb.ell.values.values);
+        ASSERT_EQUAL(hyb.coo.row_indices,           serial_hyb.coo.row_indices);
+        ASSERT_EQUAL(hyb.coo.column_indices,        serial_hyb.coo.column_indices);
+        ASSERT_EQUAL(hyb.coo.values,                serial_hyb.coo.values);
+    }
+
+    omp_set_num_threads(max_threads);
+#endif
+}
+DECLARE_UNITTEST(TestConvertWideBandHost);
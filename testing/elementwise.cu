@@ -163,3 +163,40 @@ void TestSubtract(void)
 }
 DECLARE_SPARSE_MATRIX_UNITTEST(TestSubtract);
 
+
+
+void TestAddUnsortedCsr(void)
+{
+    // rows with unsorted and duplicate column indices
+    cusp::csr_matrix<int,float,cusp::host_memory> A(3,4,6);
+    A.row_offsets[0] = 0;  A.row_offsets[1] = 3;  A.row_offsets[2] = 3;  A.row_offsets[3] = 6;
+    A.column_indices[0] = 3;  A.values[0] = 1.0;
+    A.column_indices[1] = 0;  A.values[1] = 2.0;
+    A.column_indices[2] = 3;  A.values[2] = 3.0;
+    A.column_indices[3] = 2;  A.values[3] = 4.0;
+    A.column_indices[4] = 1;  A.values[4] = 5.0;
+    A.column_indices[5] = 0;  A.values[5] = 6.0;
+
+    cusp::array2d<float,cusp::host_memory> B(3,4,0);
+    B(0,0) = -2.0; B(0,1) = 1.0;
+    B(1,2) =  7.0;
+    B(2,1) = -5.0; B(2,3) = 8.0;
+
+    cusp::array2d<float,cusp::host_memory> C(3,4,0);
+    C(0,1) = 1.0; C(0,3) = 4.0;
+    C(1,2) = 7.0;
+    C(2,0) = 6.0; C(2,2) = 4.0; C(2,3) = 8.0;
+
+    cusp::csr_matrix<int,float,cusp::host_memory> _B(B), _C;
+    cusp::add(A, _B, _C);
+
+    // cancelled entries are not stored
+    ASSERT_EQUAL(_C.num_entries, 6);
+    ASSERT_EQUAL(C == cusp::array2d<float,cusp::host_memory>(_C), true);
+
+    // output may alias an input
+    cusp::add(_B, A, _B);
+    ASSERT_EQUAL(C == cusp::array2d<float,cusp::host_memory>(_B), true);
+}
+DECLARE_UNITTEST(TestAddUnsortedCsr);
+
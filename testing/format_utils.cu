@@ -139,3 +139,86 @@ void TestExtractDiagonal(void)
 }
 DECLARE_SPARSE_MATRIX_UNITTEST(TestExtractDiagonal);
 
+
+template <class Space>
+void TestSortByRowAndColumn(void)
+{
+    const size_t N = 10000;
+
+    // wide matrix with many duplicate coordinates
+    cusp::array1d<int,cusp::host_memory> I = unittest::random_integers<unsigned short>(N);
+    cusp::array1d<int,cusp::host_memory> J = unittest::random_integers<unsigned short>(N);
+    cusp::array1d<int,cusp::host_memory> V(N);
+
+    for (size_t n = 0; n < N; n++)
+    {
+        I[n] = I[n] % 64;
+        J[n] = (J[n] % 512) * 4099;
+        V[n] = n;
+    }
+
+    cusp::array1d<int,Space> rows(I);
+    cusp::array1d<int,Space> columns(J);
+    cusp::array1d<int,Space> values(V);
+
+    cusp::detail::sort_by_row_and_column(rows, columns, values);
+
+    cusp::array1d<int,cusp::host_memory> rows_h(rows);
+    cusp::array1d<int,cusp::host_memory> columns_h(columns);
+    cusp::array1d<int,cusp::host_memory> values_h(values);
+
+    for (size_t n = 0; n < N; n++)
+    {
+        // entries travel with their values
+        ASSERT_EQUAL(rows_h[n],    I[values_h[n]]);
+        ASSERT_EQUAL(columns_h[n], J[values_h[n]]);
+
+        // sorted by (row, column) and stable for duplicate coordinates
+        if (n > 0)
+        {
+            ASSERT_EQUAL(rows_h[n - 1] <= rows_h[n], true);
+
+            if (rows_h[n - 1] == rows_h[n])
+            {
+                ASSERT_EQUAL(columns_h[n - 1] <= columns_h[n], true);
+
+                if (columns_h[n - 1] == columns_h[n])
+                    ASSERT_EQUAL(values_h[n - 1] < values_h[n], true);
+            }
+        }
+    }
+
+    // sorted input is left unchanged
+    cusp::detail::sort_by_row_and_column(rows, columns, values);
+
+    ASSERT_EQUAL(rows,    rows_h);
+    ASSERT_EQUAL(columns, columns_h);
+    ASSERT_EQUAL(values,  values_h);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestSortByRowAndColumn);
+
+
+void TestSortByRowAndColumnWideIndices(void)
+{
+    typedef unsigned long long IndexType;
+
+    // column indices that need every bit of the packed key
+    const IndexType big = ~IndexType(0);
+
+    cusp::array1d<IndexType,cusp::host_memory> rows(4, 0);
+    cusp::array1d<IndexType,cusp::host_memory> columns(4);
+    cusp::array1d<int,cusp::host_memory>       values(4);
+
+    columns[0] = big;      values[0] = 0;
+    columns[1] = 1;        values[1] = 1;
+    columns[2] = big - 1;  values[2] = 2;
+    columns[3] = 0;        values[3] = 3;
+
+    cusp::detail::sort_by_row_and_column(rows, columns, values);
+
+    ASSERT_EQUAL(columns[0] == 0,       true);  ASSERT_EQUAL(values[0], 3);
+    ASSERT_EQUAL(columns[1] == 1,       true);  ASSERT_EQUAL(values[1], 1);
+    ASSERT_EQUAL(columns[2] == big - 1, true);  ASSERT_EQUAL(values[2], 2);
+    ASSERT_EQUAL(columns[3] == big,     true);  ASSERT_EQUAL(values[3], 0);
+}
+DECLARE_UNITTEST(TestSortByRowAndColumnWideIndices);
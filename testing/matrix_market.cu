@@ -7,6 +7,10 @@
 #include <cusp/array2d.h>
 
 #include <stdio.h>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
 
 const char random_file_name[] = "test_93298409283221.mtx";
 
@@ -186,6 +190,130 @@ void TestReadMatrixMarketFileToCsrMatrix(void)
 }
 DECLARE_HOST_DEVICE_UNITTEST(TestReadMatrixMarketFileToCsrMatrix);
 
+void TestReadMatrixMarketFileCoordinatePatternSymmetricToCsrMatrix(void)
+{
+  // symmetric entries are expanded while the CSR matrix is assembled
+  cusp::csr_matrix<int, float, cusp::host_memory> csr;
+  cusp::io::read_matrix_market_file(csr, "data/test/coordinate_pattern_symmetric.mtx");
+
+  cusp::coo_matrix<int, float, cusp::host_memory> coo;
+  cusp::io::read_matrix_market_file(coo, "data/test/coordinate_pattern_symmetric.mtx");
+
+  ASSERT_EQUAL(csr.num_entries, 9);
+  ASSERT_EQUAL(cusp::array2d<float, cusp::host_memory>(csr) == cusp::array2d<float, cusp::host_memory>(coo), true);
+
+  // column indices are sorted within each row
+  for (size_t i = 0; i < csr.num_rows; i++)
+    for (int jj = csr.row_offsets[i] + 1; jj < csr.row_offsets[i + 1]; jj++)
+      ASSERT_EQUAL(csr.column_indices[jj - 1] < csr.column_indices[jj], true);
+}
+DECLARE_UNITTEST(TestReadMatrixMarketFileCoordinatePatternSymmetricToCsrMatrix);
+
+void TestReadMatrixMarketStreamDuplicatesToCsrMatrix(void)
+{
+  // duplicate entries are kept and ordered by value
+  std::stringstream input;
+  input << "%%MatrixMarket matrix coordinate real general\n";
+  input << "2 2 4\n";
+  input << "1 2 5\n";
+  input << "1 2 -1\n";
+  input << "1 1 3\n";
+  input << "1 2 2\n";
+
+  cusp::csr_matrix<int, float, cusp::host_memory> csr;
+  cusp::io::read_matrix_market_stream(csr, input);
+
+  ASSERT_EQUAL(csr.num_entries, 4);
+  ASSERT_EQUAL(csr.row_offsets[1], 4);
+  ASSERT_EQUAL(csr.row_offsets[2], 4);
+  ASSERT_EQUAL(csr.column_indices[0], 0);  ASSERT_EQUAL(csr.values[0],  3.0f);
+  ASSERT_EQUAL(csr.column_indices[1], 1);  ASSERT_EQUAL(csr.values[1], -1.0f);
+  ASSERT_EQUAL(csr.column_indices[2], 1);  ASSERT_EQUAL(csr.values[2],  2.0f);
+  ASSERT_EQUAL(csr.column_indices[3], 1);  ASSERT_EQUAL(csr.values[3],  5.0f);
+}
+DECLARE_UNITTEST(TestReadMatrixMarketStreamDuplicatesToCsrMatrix);
+
+void TestReadMatrixMarketStreamDuplicateNaNToCsrMatrix(void)
+{
+  // duplicate NaN entries are ordered after the numbers
+  std::stringstream input;
+  input << "%%MatrixMarket matrix coordinate real general\n";
+  input << "1 1 5\n";
+  input << "1 1 nan\n";
+  input << "1 1 5\n";
+  input << "1 1 -1\n";
+  input << "1 1 nan\n";
+  input << "1 1 5\n";
+
+  cusp::csr_matrix<int, float, cusp::host_memory> csr;
+  cusp::io::read_matrix_market_stream(csr, input);
+
+  ASSERT_EQUAL(csr.num_entries, 5);
+  ASSERT_EQUAL(csr.values[0], -1.0f);
+  ASSERT_EQUAL(csr.values[1],  5.0f);
+  ASSERT_EQUAL(csr.values[2],  5.0f);
+  ASSERT_EQUAL(csr.values[3] != csr.values[3], true);
+  ASSERT_EQUAL(csr.values[4] != csr.values[4], true);
+}
+DECLARE_UNITTEST(TestReadMatrixMarketStreamDuplicateNaNToCsrMatrix);
+
+void TestReadMatrixMarketStreamCoordinateFormatting(void)
+{
+  // blank lines, tabs, carriage returns, signs and exponents
+  std::stringstream input;
+  input << "%%MatrixMarket matrix coordinate real general\r\n";
+  input << "% comment\r\n";
+  input << "\r\n";
+  input << "\t3 4  5 \r\n";
+  input << "3 4 -2.5e+02\r\n";
+  input << "\r\n";
+  input << "  1\t1 1\r\n";
+  input << "2 3 +.25\r\n";
+  input << "1 4 1.5E1\r\n";
+  input << "3 1 0.000125e4";
+
+  cusp::coo_matrix<int, double, cusp::host_memory> coo;
+  cusp::io::read_matrix_market_stream(coo, input);
+
+  ASSERT_EQUAL(coo.num_rows,    3);
+  ASSERT_EQUAL(coo.num_cols,    4);
+  ASSERT_EQUAL(coo.num_entries, 5);
+
+  ASSERT_EQUAL(coo.row_indices[0], 0);  ASSERT_EQUAL(coo.column_indices[0], 0);  ASSERT_EQUAL(coo.values[0],    1.0);
+  ASSERT_EQUAL(coo.row_indices[1], 0);  ASSERT_EQUAL(coo.column_indices[1], 3);  ASSERT_EQUAL(coo.values[1],   15.0);
+  ASSERT_EQUAL(coo.row_indices[2], 1);  ASSERT_EQUAL(coo.column_indices[2], 2);  ASSERT_EQUAL(coo.values[2],   0.25);
+  ASSERT_EQUAL(coo.row_indices[3], 2);  ASSERT_EQUAL(coo.column_indices[3], 0);  ASSERT_EQUAL(coo.values[3],   1.25);
+  ASSERT_EQUAL(coo.row_indices[4], 2);  ASSERT_EQUAL(coo.column_indices[4], 3);  ASSERT_EQUAL(coo.values[4], -250.0);
+}
+DECLARE_UNITTEST(TestReadMatrixMarketStreamCoordinateFormatting);
+
+void TestReadMatrixMarketStreamInvalid(void)
+{
+  const char * inputs[] = {
+    "%%MatrixMarket matrix coordinate real general\n2 2 2\n1 1 1.0\n",          // missing entry
+    "%%MatrixMarket matrix coordinate real general\n2 2 1\n0 1 1.0\n",          // row index < 1
+    "%%MatrixMarket matrix coordinate real general\n2 2 1\n1 3 1.0\n",          // column index > num_cols
+    "%%MatrixMarket matrix coordinate real general\n2 2 1\n1 1 x\n",            // malformed value
+    "%%MatrixMarket matrix coordinate complex general\n2 2 1\n1 1 1.0\n",       // missing imaginary part
+    "%%MatrixMarket matrix coordinate real general\n2 2\n",                     // malformed size line
+    "%%MatrixMarket matrix coordinate real general\n2 2 1\n99999999999999999999 1 1.0\n", // row index overflows
+    "%%MatrixMarket matrix coordinate real general\n2 99999999999999999999 1\n1 1 1.0\n", // size overflows
+    "%%MatrixMarket matrix array real general\n2 2\n1.0\n2.0\n3.0\n"            // missing entry
+  };
+
+  for (size_t i = 0; i < sizeof(inputs) / sizeof(inputs[0]); i++)
+  {
+    std::stringstream input(inputs[i]);
+    cusp::coo_matrix<int, float, cusp::host_memory> coo;
+    ASSERT_THROWS(cusp::io::read_matrix_market_stream(coo, input), cusp::io_exception);
+
+    std::stringstream csr_input(inputs[i]);
+    cusp::csr_matrix<int, float, cusp::host_memory> csr;
+    ASSERT_THROWS(cusp::io::read_matrix_market_stream(csr, csr_input), cusp::io_exception);
+  }
+}
+DECLARE_UNITTEST(TestReadMatrixMarketStreamInvalid);
+
 template <typename MemorySpace>
 void TestWriteMatrixMarketFileCoordinateRealGeneral(void)
 {
@@ -240,3 +368,171 @@ void TestWriteMatrixMarketFileCoordinateComplexGeneral(void)
 }
 DECLARE_HOST_DEVICE_UNITTEST(TestWriteMatrixMarketFileCoordinateComplexGeneral);
 
+
+template <typename MemorySpace>
+void TestReadMatrixMarketFileCache(void)
+{
+  typedef cusp::csr_matrix<int, float, MemorySpace> Matrix;
+
+  {
+    std::ofstream file(random_file_name);
+    file << "%%MatrixMarket matrix coordinate real general\n3 3 2\n1 1 1.5\n3 2 2\n";
+  }
+
+  cusp::io::enable_matrix_market_cache();
+
+  std::string snapshot;
+  cusp::io::detail::matrix_market_cache_key key;
+  ASSERT_EQUAL(cusp::io::detail::find_matrix_market_snapshot<Matrix>(random_file_name, snapshot, key), true);
+
+  // the first read creates the snapshot and the second one loads it
+  Matrix A;
+  cusp::io::read_matrix_market_file(A, random_file_name);
+  ASSERT_EQUAL(std::ifstream(snapshot.c_str()).good(), true);
+
+  Matrix B;
+  cusp::io::read_matrix_market_file(B, random_file_name);
+
+  ASSERT_EQUAL(B.num_entries, 2);
+  ASSERT_EQUAL(cusp::array2d<float, cusp::host_memory>(A) == cusp::array2d<float, cusp::host_memory>(B), true);
+
+  // a modified file replaces its snapshot
+  {
+    std::ofstream file(random_file_name);
+    file << "%%MatrixMarket matrix coordinate real general\n3 3 3\n1 1 1.5\n3 2 2\n2 2 4\n";
+  }
+
+  Matrix C;
+  cusp::io::read_matrix_market_file(C, random_file_name);
+  cusp::io::read_matrix_market_file(C, random_file_name);
+
+  ASSERT_EQUAL(C.num_entries, 3);
+  ASSERT_EQUAL(C.values[1], 4.0f);
+
+  cusp::io::disable_matrix_market_cache();
+
+  remove(snapshot.c_str());
+  remove(random_file_name);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestReadMatrixMarketFileCache);
+
+void TestReadMatrixMarketFileCacheOrientation(void)
+{
+  typedef cusp::array2d<float, cusp::host_memory, cusp::row_major>    RowMajor;
+  typedef cusp::array2d<float, cusp::host_memory, cusp::column_major> ColumnMajor;
+
+  {
+    std::ofstream file(random_file_name);
+    file << "%%MatrixMarket matrix coordinate real general\n2 3 2\n1 3 1.5\n2 1 2\n";
+  }
+
+  cusp::io::enable_matrix_market_cache();
+
+  // each orientation has its own snapshot
+  std::string row_snapshot, column_snapshot;
+  cusp::io::detail::matrix_market_cache_key row_key, column_key;
+  ASSERT_EQUAL(cusp::io::detail::find_matrix_market_snapshot<RowMajor>   (random_file_name, row_snapshot,    row_key),    true);
+  ASSERT_EQUAL(cusp::io::detail::find_matrix_market_snapshot<ColumnMajor>(random_file_name, column_snapshot, column_key), true);
+  ASSERT_EQUAL(row_snapshot == column_snapshot, false);
+  ASSERT_EQUAL(row_key.orientation == column_key.orientation, false);
+
+  RowMajor A;
+  cusp::io::read_matrix_market_file(A, random_file_name);
+  cusp::io::read_matrix_market_file(A, random_file_name);
+
+  ColumnMajor B;
+  cusp::io::read_matrix_market_file(B, random_file_name);
+  cusp::io::read_matrix_market_file(B, random_file_name);
+
+  ASSERT_EQUAL(A(0,2), 1.5f);  ASSERT_EQUAL(A(1,0), 2.0f);
+  ASSERT_EQUAL(B(0,2), 1.5f);  ASSERT_EQUAL(B(1,0), 2.0f);
+
+  cusp::io::disable_matrix_market_cache();
+
+  remove(row_snapshot.c_str());
+  remove(column_snapshot.c_str());
+  remove(random_file_name);
+}
+DECLARE_UNITTEST(TestReadMatrixMarketFileCacheOrientation);
+
+void TestReadWriteMatrixMarketFileGzip(void)
+{
+  const char gzip_file_name[] = "test_93298409283221.mtx.gz";
+
+  cusp::array2d<float, cusp::host_memory> E(3, 3);
+  E(0,0) = 1.5;  E(0,1) = 0.0;  E(0,2) = 0.0;
+  E(1,0) = 0.0;  E(1,1) = 4.0;  E(1,2) = 0.0;
+  E(2,0) = 0.0;  E(2,1) = 2.0;  E(2,2) = 0.0;
+
+  cusp::coo_matrix<int, float, cusp::host_memory> A(E);
+
+#if defined(CUSP_USE_ZLIB)
+  // write a compressed file and read it back
+  cusp::io::write_matrix_market_file(A, gzip_file_name);
+
+  cusp::csr_matrix<int, float, cusp::host_memory> B;
+  cusp::io::read_matrix_market_file(B, gzip_file_name);
+
+  ASSERT_EQUAL(cusp::array2d<float, cusp::host_memory>(B) == E, true);
+
+  // compressed streams are recognized as well
+  std::ifstream file(gzip_file_name, std::ios::in | std::ios::binary);
+  std::string contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+  std::stringstream compressed(contents);
+  cusp::coo_matrix<int, float, cusp::host_memory> C;
+  cusp::io::read_matrix_market_stream(C, compressed);
+
+  ASSERT_EQUAL(cusp::array2d<float, cusp::host_memory>(C) == E, true);
+
+  // damaged data
+  std::stringstream truncated(contents.substr(0, contents.size() - 10));
+  ASSERT_THROWS(cusp::io::read_matrix_market_stream(C, truncated), cusp::io_exception);
+
+  remove(gzip_file_name);
+#else
+  // compressed files require zlib
+  ASSERT_THROWS(cusp::io::write_matrix_market_file(A, gzip_file_name), cusp::io_exception);
+
+  std::stringstream compressed("\x1f\x8b\x08");
+  ASSERT_THROWS(cusp::io::read_matrix_market_stream(A, compressed), cusp::io_exception);
+#endif
+}
+DECLARE_UNITTEST(TestReadWriteMatrixMarketFileGzip);
+
+void TestWriteMatrixMarketStreamExactValues(void)
+{
+  // values are written with enough digits to be read back exactly
+  cusp::coo_matrix<int, double, cusp::host_memory> A(2, 3, 5);
+  A.row_indices[0] = 0;  A.column_indices[0] = 0;  A.values[0] = 0.1;
+  A.row_indices[1] = 0;  A.column_indices[1] = 2;  A.values[1] = 1.0 / 3.0;
+  A.row_indices[2] = 1;  A.column_indices[2] = 0;  A.values[2] = -2.5e-300;
+  A.row_indices[3] = 1;  A.column_indices[3] = 1;  A.values[3] = 1.7976931348623157e308;
+  A.row_indices[4] = 1;  A.column_indices[4] = 2;  A.values[4] = -250;
+
+  std::stringstream coordinate;
+  cusp::io::write_matrix_market_stream(A, coordinate);
+
+  // short values are written with few digits
+  ASSERT_EQUAL(coordinate.str().find("1 1 0.1\n") != std::string::npos, true);
+  ASSERT_EQUAL(coordinate.str().find("2 3 -250\n") != std::string::npos, true);
+
+  cusp::coo_matrix<int, double, cusp::host_memory> B;
+  cusp::io::read_matrix_market_stream(B, coordinate);
+
+  ASSERT_EQUAL(B.values == A.values, true);
+
+  cusp::array1d<cusp::complex<float>, cusp::host_memory> x(3);
+  x[0] = cusp::complex<float>(0.1f, -1.0f / 3.0f);
+  x[1] = cusp::complex<float>(3.4028235e38f, 1e-45f);
+  x[2] = cusp::complex<float>(16777216.0f, -0.3f);
+
+  std::stringstream array;
+  cusp::io::write_matrix_market_stream(x, array);
+
+  cusp::array1d<cusp::complex<float>, cusp::host_memory> y;
+  cusp::io::read_matrix_market_stream(y, array);
+
+  ASSERT_EQUAL(x == y, true);
+}
+DECLARE_UNITTEST(TestWriteMatrixMarketStreamExactValues);
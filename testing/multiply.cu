@@ -6,8 +6,10 @@
 
 #include <cusp/multiply.h>
 
+#include <cusp/complex.h>
 #include <cusp/linear_operator.h>
 #include <cusp/print.h>
+#include <cusp/transpose.h>
 #include <cusp/gallery/poisson.h>
 #include <cusp/gallery/random.h>
 
@@ -111,6 +113,219 @@ void TestSparseMatrixMatrixMultiply(void)
 }
 DECLARE_SPARSE_MATRIX_UNITTEST(TestSparseMatrixMatrixMultiply);
 
+void TestSparseMatrixMatrixMultiplySortedColumns(void)
+{
+    typedef cusp::csr_matrix<int,float,cusp::host_memory> CsrMatrix;
+    typedef cusp::array2d<float,cusp::host_memory>        DenseMatrix;
+
+    CsrMatrix A;
+    cusp::gallery::random(300, 200, 2000, A);
+
+    CsrMatrix B;
+    cusp::gallery::random(200, 250, 2000, B);
+
+    DenseMatrix A_dense(A), B_dense(B), C;
+    cusp::multiply(A_dense, B_dense, C);
+
+    CsrMatrix _C;
+    cusp::detail::host::detail::spmm_csr(A, B, _C, true);
+
+    ASSERT_EQUAL(C == DenseMatrix(_C), true);
+    ASSERT_EQUAL(_C.row_offsets.back(), int(_C.num_entries));
+
+    // column indices must be strictly increasing within each row
+    for(size_t i = 0; i < _C.num_rows; i++)
+        for(int jj = _C.row_offsets[i] + 1; jj < _C.row_offsets[i + 1]; jj++)
+            ASSERT_EQUAL(_C.column_indices[jj - 1] < _C.column_indices[jj], true);
+}
+DECLARE_UNITTEST(TestSparseMatrixMatrixMultiplySortedColumns);
+
+void TestSparseMatrixMatrixMultiplyWide(void)
+{
+    // short rows in a wide product are formed with hash accumulators
+    typedef cusp::csr_matrix<int,float,cusp::host_memory> CsrMatrix;
+    typedef cusp::array2d<float,cusp::host_memory>        DenseMatrix;
+
+    CsrMatrix A;
+    cusp::gallery::random(40, 50, 200, A);
+
+    CsrMatrix B;
+    cusp::gallery::random(50, 20000, 500, B);
+
+    DenseMatrix A_dense(A), B_dense(B), C;
+    cusp::multiply(A_dense, B_dense, C);
+
+    CsrMatrix _C;
+    cusp::multiply(A, B, _C);
+
+    ASSERT_EQUAL(C == DenseMatrix(_C), true);
+}
+DECLARE_UNITTEST(TestSparseMatrixMatrixMultiplyWide);
+
+template <typename TestMatrix>
+void TestSparseMatrixMatrixMultiplySymbolic(void)
+{
+    typedef cusp::array2d<float,cusp::host_memory> DenseMatrix;
+
+    DenseMatrix A;
+    cusp::gallery::random(30, 20, 120, A);
+
+    DenseMatrix B;
+    cusp::gallery::random(20, 25, 100, B);
+
+    TestMatrix _A(A), _B(B), _C;
+
+    cusp::multiply_symbolic(_A, _B, _C);
+
+    ASSERT_EQUAL(_C.num_rows, 30);
+    ASSERT_EQUAL(_C.num_cols, 25);
+
+    size_t num_entries = _C.num_entries;
+
+    // change the values but not the structure of A
+    for(int step = 0; step < 3; step++)
+    {
+        for(size_t n = 0; n < _A.values.size(); n++)
+            _A.values[n] = float((n + step) % 5) - 2;
+
+        DenseMatrix A_dense(_A), C;
+        cusp::multiply(A_dense, B, C);
+
+        cusp::multiply_numeric(_A, _B, _C);
+
+        ASSERT_EQUAL(_C.num_entries, num_entries);
+        ASSERT_EQUAL(C == DenseMatrix(_C), true);
+    }
+
+    // A * B has entries outside the structure of C
+    DenseMatrix P(30, 20, 0), Q(20, 25, 0);
+    for(size_t i = 0; i < 30; i++) P(i, i % 20) = 1;
+    for(size_t i = 0; i < 20; i++) Q(i, i) = 1;
+
+    TestMatrix _P(P), _Q(Q), _D;
+    cusp::multiply_symbolic(_P, _Q, _D);
+
+    ASSERT_THROWS(cusp::multiply_numeric(_A, _B, _D), cusp::invalid_input_exception);
+
+    // inner dimensions do not match
+    ASSERT_THROWS(cusp::multiply_numeric(_B, _A, _C), cusp::invalid_input_exception);
+}
+DECLARE_SPARSE_FORMAT_UNITTEST(TestSparseMatrixMatrixMultiplySymbolic,Coo,coo);
+DECLARE_SPARSE_FORMAT_UNITTEST(TestSparseMatrixMatrixMultiplySymbolic,Csr,csr);
+
+template <typename TestMatrix>
+void TestGalerkinProduct(void)
+{
+    typedef cusp::array2d<float,cusp::host_memory> DenseMatrix;
+
+    DenseMatrix A;
+    cusp::gallery::poisson5pt(A, 6, 5);
+
+    DenseMatrix P;
+    cusp::gallery::random(30, 8, 40, P);
+
+    DenseMatrix R;
+    cusp::transpose(P, R);
+
+    DenseMatrix AP, RAP;
+    cusp::multiply(A, P, AP);
+    cusp::multiply(R, AP, RAP);
+
+    TestMatrix _R(R), _A(A), _P(P), _RAP;
+    cusp::galerkin_product(_R, _A, _P, _RAP);
+
+    ASSERT_EQUAL(RAP == DenseMatrix(_RAP), true);
+
+    ASSERT_THROWS(cusp::galerkin_product(_P, _A, _P, _RAP), cusp::invalid_input_exception);
+}
+DECLARE_SPARSE_MATRIX_UNITTEST(TestGalerkinProduct);
+
+template <typename DenseMatrix>
+struct copy_block
+{
+    DenseMatrix& C;
+    size_t& next_row;
+
+    copy_block(DenseMatrix& C, size_t& next_row) : C(C), next_row(next_row) {}
+
+    template <typename Matrix>
+    void operator()(size_t first_row, const Matrix& C_block)
+    {
+        ASSERT_EQUAL(first_row, next_row);
+        ASSERT_EQUAL(C_block.num_cols, C.num_cols);
+
+        for(size_t i = 0; i < C_block.num_rows; i++)
+            for(size_t jj = C_block.row_offsets[i]; jj < size_t(C_block.row_offsets[i + 1]); jj++)
+                C(first_row + i, C_block.column_indices[jj]) += C_block.values[jj];
+
+        next_row += C_block.num_rows;
+    }
+};
+
+template <typename TestMatrix>
+void TestSparseMatrixMatrixMultiplyBlocked(void)
+{
+    typedef cusp::array2d<float,cusp::host_memory> DenseMatrix;
+
+    DenseMatrix A;
+    cusp::gallery::random(40, 30, 200, A);
+
+    DenseMatrix B;
+    cusp::gallery::random(30, 35, 200, B);
+
+    DenseMatrix C;
+    cusp::multiply(A, B, C);
+
+    TestMatrix _A(A), _B(B);
+
+    // budgets below one row, a few rows, and all rows
+    size_t budgets[3] = {1, 256, 1 << 20};
+
+    for(size_t n = 0; n < 3; n++)
+    {
+        DenseMatrix _C(C.num_rows, C.num_cols, 0);
+        size_t next_row = 0;
+
+        cusp::multiply_blocked(_A, _B, copy_block<DenseMatrix>(_C, next_row), budgets[n]);
+
+        ASSERT_EQUAL(next_row, C.num_rows);
+        ASSERT_EQUAL(C == _C, true);
+    }
+}
+DECLARE_SPARSE_MATRIX_UNITTEST(TestSparseMatrixMatrixMultiplyBlocked);
+
+template <typename TestMatrix>
+void TestSparseMatrixMatrixMultiplyMasked(void)
+{
+    typedef cusp::array2d<float,cusp::host_memory> DenseMatrix;
+
+    DenseMatrix A;
+    cusp::gallery::random(30, 20, 120, A);
+
+    DenseMatrix B;
+    cusp::gallery::random(20, 25, 100, B);
+
+    DenseMatrix M;
+    cusp::gallery::random(30, 25, 200, M);
+
+    DenseMatrix C;
+    cusp::multiply(A, B, C);
+
+    // keep only the entries inside the mask
+    for(size_t i = 0; i < C.num_rows; i++)
+        for(size_t j = 0; j < C.num_cols; j++)
+            if (M(i,j) == 0)
+                C(i,j) = 0;
+
+    TestMatrix _A(A), _B(B), _M(M), _C;
+    cusp::multiply_masked(_A, _B, _M, _C);
+
+    ASSERT_EQUAL(C == DenseMatrix(_C), true);
+
+    ASSERT_THROWS(cusp::multiply_masked(_A, _B, _A, _C), cusp::invalid_input_exception);
+}
+DECLARE_SPARSE_MATRIX_UNITTEST(TestSparseMatrixMatrixMultiplyMasked);
+
 
 /////////////////////////////////////////
 // Sparse Matrix-Vector Multiplication //
@@ -218,6 +433,112 @@ void TestSparseMatrixVectorMultiply()
 DECLARE_SPARSE_MATRIX_UNITTEST(TestSparseMatrixVectorMultiply);
 
 
+////////////////////////////////
+// Dense Matrix Multiplication //
+////////////////////////////////
+
+// small integers, which are multiplied and summed exactly
+template <typename ValueType>
+struct dense_test_value
+{
+    static ValueType make(int re, int im) { return ValueType(re); }
+};
+
+template <typename T>
+struct dense_test_value< cusp::complex<T> >
+{
+    static cusp::complex<T> make(int re, int im) { return cusp::complex<T>(T(re), T(im)); }
+};
+
+template <typename ValueType, typename Orientation1, typename Orientation2, typename Orientation3>
+void CompareDenseMatrixMatrixMultiply(size_t num_rows, size_t num_cols, size_t num_inner)
+{
+    cusp::array2d<ValueType, cusp::host_memory, Orientation1> A(num_rows, num_inner);
+    cusp::array2d<ValueType, cusp::host_memory, Orientation2> B(num_inner, num_cols);
+    cusp::array2d<ValueType, cusp::host_memory, Orientation3> C;
+
+    for(size_t i = 0; i < num_rows; i++)
+        for(size_t k = 0; k < num_inner; k++)
+            A(i,k) = dense_test_value<ValueType>::make(int((3 * i + k) % 7) - 3, int((i + 2 * k) % 5) - 2);
+    for(size_t k = 0; k < num_inner; k++)
+        for(size_t j = 0; j < num_cols; j++)
+            B(k,j) = dense_test_value<ValueType>::make(int((k + 2 * j) % 5) - 2, int((2 * k + j) % 3) - 1);
+
+    cusp::multiply(A, B, C);
+
+    ASSERT_EQUAL(C.num_rows, num_rows);
+    ASSERT_EQUAL(C.num_cols, num_cols);
+
+    size_t errors = 0;
+    for(size_t i = 0; i < num_rows; i++)
+        for(size_t j = 0; j < num_cols; j++)
+        {
+            ValueType v(0);
+            for(size_t k = 0; k < num_inner; k++)
+                v += A(i,k) * B(k,j);
+            if (C(i,j) != v)
+                errors++;
+        }
+    ASSERT_EQUAL(errors, size_t(0));
+}
+
+template <typename ValueType>
+void CompareDenseMatrixMatrixMultiply(void)
+{
+    // sizes that span several tiles and leave partial tiles and register blocks
+    CompareDenseMatrixMatrixMultiply<ValueType, cusp::row_major,    cusp::row_major,    cusp::row_major   >(71, 530, 260);
+    CompareDenseMatrixMatrixMultiply<ValueType, cusp::column_major, cusp::column_major, cusp::column_major>(71, 530, 260);
+    CompareDenseMatrixMatrixMultiply<ValueType, cusp::column_major, cusp::row_major,    cusp::row_major   >(71, 530, 260);
+    CompareDenseMatrixMatrixMultiply<ValueType, cusp::row_major,    cusp::column_major, cusp::column_major>(3, 5, 1);
+    CompareDenseMatrixMatrixMultiply<ValueType, cusp::row_major,    cusp::row_major,    cusp::row_major   >(4, 3, 0);
+}
+
+void TestDenseMatrixMatrixMultiply(void)
+{
+    CompareDenseMatrixMatrixMultiply<float>();
+    CompareDenseMatrixMatrixMultiply<double>();
+    CompareDenseMatrixMatrixMultiply< cusp::complex<float>  >();
+    CompareDenseMatrixMatrixMultiply< cusp::complex<double> >();
+}
+DECLARE_UNITTEST(TestDenseMatrixMatrixMultiply);
+
+template <typename Orientation>
+void CompareDenseMatrixVectorMultiply(size_t num_rows, size_t num_cols)
+{
+    cusp::array2d<float, cusp::host_memory, Orientation> A(num_rows, num_cols);
+    cusp::array1d<float, cusp::host_memory> x(num_cols);
+    cusp::array1d<float, cusp::host_memory> y(num_rows, 10);
+
+    for(size_t i = 0; i < num_rows; i++)
+        for(size_t j = 0; j < num_cols; j++)
+            A(i,j) = float((i + 2 * j) % 5) - 2.0f;
+    for(size_t j = 0; j < num_cols; j++)
+        x[j] = float(j % 3);
+
+    cusp::multiply(A, x, y);
+
+    size_t errors = 0;
+    for(size_t i = 0; i < num_rows; i++)
+    {
+        float v = 0;
+        for(size_t j = 0; j < num_cols; j++)
+            v += A(i,j) * x[j];
+        if (y[i] != v)
+            errors++;
+    }
+    ASSERT_EQUAL(errors, size_t(0));
+}
+
+void TestDenseMatrixVectorMultiply(void)
+{
+    CompareDenseMatrixVectorMultiply<cusp::row_major>   (1500, 300);
+    CompareDenseMatrixVectorMultiply<cusp::column_major>(1500, 300);
+    CompareDenseMatrixVectorMultiply<cusp::row_major>   (3, 0);
+    CompareDenseMatrixVectorMultiply<cusp::column_major>(3, 0);
+}
+DECLARE_UNITTEST(TestDenseMatrixVectorMultiply);
+
+
 //////////////////////////////
 // General Linear Operators //
 //////////////////////////////
@@ -117,3 +117,42 @@ void TestTranspose(void)
 }
 DECLARE_MATRIX_UNITTEST(TestTranspose);
 
+
+template <class SparseMatrix>
+void TestTransposeWide(void)
+{
+    // matrix much wider than it is dense
+    cusp::array2d<float, cusp::host_memory> D(3, 20000, 0.0f);
+    D(0,19999) = 1;  D(0,7) = 2;  D(0,0) = 3;
+    D(1,7)     = 4;  D(1,5) = 5;
+    D(2,19999) = 6;  D(2,0) = 7;  D(2,5) = 8;
+
+    SparseMatrix A(D), At;
+    cusp::transpose(A, At);
+
+    cusp::csr_matrix<int, float, cusp::host_memory> B(At);
+
+    // rows of the transpose have sorted column indices
+    ASSERT_EQUAL(B.num_rows,    20000);
+    ASSERT_EQUAL(B.num_cols,    3);
+    ASSERT_EQUAL(B.num_entries, 8);
+    ASSERT_EQUAL(B.row_offsets[0],     0);
+    ASSERT_EQUAL(B.row_offsets[1],     2);
+    ASSERT_EQUAL(B.row_offsets[5],     2);
+    ASSERT_EQUAL(B.row_offsets[6],     4);
+    ASSERT_EQUAL(B.row_offsets[7],     4);
+    ASSERT_EQUAL(B.row_offsets[8],     6);
+    ASSERT_EQUAL(B.row_offsets[19999], 6);
+    ASSERT_EQUAL(B.row_offsets[20000], 8);
+    ASSERT_EQUAL(B.column_indices[0], 0);  ASSERT_EQUAL(B.values[0], 3);
+    ASSERT_EQUAL(B.column_indices[1], 2);  ASSERT_EQUAL(B.values[1], 7);
+    ASSERT_EQUAL(B.column_indices[2], 1);  ASSERT_EQUAL(B.values[2], 5);
+    ASSERT_EQUAL(B.column_indices[3], 2);  ASSERT_EQUAL(B.values[3], 8);
+    ASSERT_EQUAL(B.column_indices[4], 0);  ASSERT_EQUAL(B.values[4], 2);
+    ASSERT_EQUAL(B.column_indices[5], 1);  ASSERT_EQUAL(B.values[5], 4);
+    ASSERT_EQUAL(B.column_indices[6], 0);  ASSERT_EQUAL(B.values[6], 1);
+    ASSERT_EQUAL(B.column_indices[7], 2);  ASSERT_EQUAL(B.values[7], 6);
+}
+DECLARE_SPARSE_FORMAT_UNITTEST(TestTransposeWide, Coo, coo);
+DECLARE_SPARSE_FORMAT_UNITTEST(TestTransposeWide, Csr, csr);
+
@@ -0,0 +1,52 @@
+#include <unittest/unittest.h>
+
+#include <cusp/graph/triangle_count.h>
+
+#include <cusp/array2d.h>
+#include <cusp/coo_matrix.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/dia_matrix.h>
+#include <cusp/ell_matrix.h>
+#include <cusp/hyb_matrix.h>
+#include <cusp/gallery/poisson.h> 
+
+template <typename TestMatrix>
+void TestTriangleCount(void)
+{
+    // linear graph
+    cusp::array2d<float,cusp::host_memory> A(4,4);
+    A(0,0) = 1; A(0,1) = 1; A(0,2) = 0; A(0,3) = 0;
+    A(1,0) = 1; A(1,1) = 1; A(1,2) = 1; A(1,3) = 0;
+    A(2,0) = 0; A(2,1) = 1; A(2,2) = 1; A(2,3) = 1;
+    A(3,0) = 0; A(3,1) = 0; A(3,2) = 1; A(3,3) = 1;
+
+    // two triangles sharing an edge
+    cusp::array2d<float,cusp::host_memory> B(4,4);
+    B(0,0) = 0; B(0,1) = 1; B(0,2) = 1; B(0,3) = 0;
+    B(1,0) = 1; B(1,1) = 0; B(1,2) = 1; B(1,3) = 1;
+    B(2,0) = 1; B(2,1) = 1; B(2,2) = 0; B(2,3) = 1;
+    B(3,0) = 0; B(3,1) = 1; B(3,2) = 1; B(3,3) = 0;
+
+    // complete graph
+    cusp::array2d<float,cusp::host_memory> C(6,6,1);
+
+    // empty graph
+    cusp::array2d<float,cusp::host_memory> D(6,6,0);
+
+    // 5-point grid has no triangles
+    cusp::coo_matrix<int,float,cusp::host_memory> E;
+    cusp::gallery::poisson5pt(E, 13, 17);
+
+    // every cell of a 9-point grid holds 4 triangles
+    cusp::coo_matrix<int,float,cusp::host_memory> F;
+    cusp::gallery::poisson9pt(F, 13, 17);
+
+    ASSERT_EQUAL(cusp::graph::triangle_count(TestMatrix(A)),  0);
+    ASSERT_EQUAL(cusp::graph::triangle_count(TestMatrix(B)),  2);
+    ASSERT_EQUAL(cusp::graph::triangle_count(TestMatrix(C)), 20);
+    ASSERT_EQUAL(cusp::graph::triangle_count(TestMatrix(D)),  0);
+    ASSERT_EQUAL(cusp::graph::triangle_count(TestMatrix(E)),  0);
+    ASSERT_EQUAL(cusp::graph::triangle_count(TestMatrix(F)),  4 * 12 * 16);
+}
+DECLARE_SPARSE_MATRIX_UNITTEST(TestTriangleCount);
+